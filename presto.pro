@@ -1,4 +1,5 @@
 QT += quick multimedia # added multimedia for the camera functionality
+QT += concurrent
 CONFIG += c++11
 
 android {
@@ -11,14 +12,29 @@ SOURCES +=  \
 }
 
 linux:!android {
+HEADERS += \
+    src/NfcHelper.h \
+    src/NfcTransceiver.h \
+    src/LoopbackNfcTransceiver.h \
+    src/NfcBenchmark.h
+
+SOURCES += \
+    src/NfcHelper.cpp \
+    src/LoopbackNfcTransceiver.cpp \
+    src/NfcBenchmark.cpp
+
+# The NXP reader only where linux_libnfc-nci is installed, CONFIG+=no_nxp_nfc to leave it out anyway
+!no_nxp_nfc:exists(/usr/local/lib/libnfc_nci_linux.so*) {
+DEFINES += PRESTO_NXP_NFC
 LIBS += -L/usr/local/lib -lnfc_nci_linux
 
 HEADERS += \
     src/NfcController.h \
-    src/NfcHelper.h
+    src/NxpNfcTransceiver.h
 
 SOURCES += \
-    src/NfcHelper.cpp
+    src/NxpNfcTransceiver.cpp
+}
 }
 
 # The following define makes your compiler emit warnings if you use
@@ -42,64 +58,10 @@ QML_IMPORT_PATH +=
 QML_DESIGNER_IMPORT_PATH =
 
 include(3rdparty/kirigami/kirigami.pri)
-include(3rdparty/qzxing/src/QZXing.pri)
-
-INCLUDEPATH += \
-    3rdparty/QtCryptoHash/lib/include
-
-QCRYPTOHASH_SOURCES += \
-    3rdparty/QtCryptoHash/lib/src/qcryptohash.cpp \
-    3rdparty/QtCryptoHash/lib/src/rmd160.cpp \
-    3rdparty/QtCryptoHash/lib/src/tiger.cpp \
-    3rdparty/QtCryptoHash/lib/src/whirlpool.cpp \
-    3rdparty/QtCryptoHash/lib/src/hashalgorithm.cpp
-
-QJSONRPC_HEADERS += \
-    3rdparty/qjsonrpc/src/qjsonrpcabstractserver.h \
-    3rdparty/qjsonrpc/src/qjsonrpcabstractserver_p.h \
-    3rdparty/qjsonrpc/src/qjsonrpcglobal.h \
-    3rdparty/qjsonrpc/src/qjsonrpcmessage.h \
-    3rdparty/qjsonrpc/src/qjsonrpcmetatype.h \
-    3rdparty/qjsonrpc/src/qjsonrpcservice.h \
-    3rdparty/qjsonrpc/src/qjsonrpcservice_p.h \
-    3rdparty/qjsonrpc/src/qjsonrpcserviceprovider.h \
-    3rdparty/qjsonrpc/src/qjsonrpcservicereply.h \
-    3rdparty/qjsonrpc/src/qjsonrpcservicereply_p.h \
-    3rdparty/qjsonrpc/src/qjsonrpcsocket.h \
-    3rdparty/qjsonrpc/src/qjsonrpcsocket_p.h
-
-QJSONRPC_SOURCES += \
-    3rdparty/qjsonrpc/src/qjsonrpcabstractserver.cpp \
-    3rdparty/qjsonrpc/src/qjsonrpcmessage.cpp \
-    3rdparty/qjsonrpc/src/qjsonrpcservice.cpp \
-    3rdparty/qjsonrpc/src/qjsonrpcserviceprovider.cpp \
-    3rdparty/qjsonrpc/src/qjsonrpcservicereply.cpp \
-    3rdparty/qjsonrpc/src/qjsonrpcsocket.cpp \
-
-HEADERS += \
-    $${QJSONRPC_HEADERS} \
-    src/LightningModel.h \
-    src/PaymentsModel.h \
-    src/PeersModel.h \
-    src/WalletModel.h \
-    src/InvoicesModel.h \
-    src/QClipboardProxy.h \
-    src/NodesModel.h \
-    src/macros.h \
-    src/AutoPilot.h
+include(src/src.pri)
 
 SOURCES += \
-    $${QJSONRPC_SOURCES} \
-    $${QCRYPTOHASH_SOURCES} \
-    src/main.cpp \
-    src/LightningModel.cpp \
-    src/PaymentsModel.cpp \
-    src/PeersModel.cpp \
-    src/WalletModel.cpp \
-    src/InvoicesModel.cpp \
-    src/QClipboardProxy.cpp \
-    src/NodesModel.cpp \
-    src/AutoPilot.cpp
+    src/main.cpp
 
 DISTFILES += \
     src/qml/qmldir \
@@ -2,6 +2,7 @@
 #include "LightningModel.h"
 #include "NodesModel.h"
 #include "PeersModel.h"
+#include "Tracer.h"
 
 #include <QCryptographicHash>
 #include <QtEndian>
@@ -24,6 +25,8 @@ AutoPilot::AutoPilot(QObject *parent) : QObject(parent)
 
 void AutoPilot::go(int amountSatoshi, quint32 iteration)
 {
+    TRACE_SCOPE("autopilot", "go");
+
     // https://lists.linuxfoundation.org/pipermail/lightning-dev/2018-March/001108.html
     m_autopilotChannelAmount = amountSatoshi;
 
@@ -38,13 +41,37 @@ void AutoPilot::go(int amountSatoshi, quint32 iteration)
     }
 
     QString ourId = LightningModel::instance()->id();
-    QCryptographicHash::Algorithm standardAlgorithm1 = QCryptographicHash::Sha256;
-    QCryptoHash::Algorithm standardAlgorithm2 = QCryptoHash::RMD160;
-
     quint32 i = iteration;
     m_autoPilotIteration = i;
 
-    quint32 networkOrderI = qToBigEndian(i);
+    QString candidateNodeId = candidateNode(nodes, ourId, i);
+
+    // Any idea how to connect to our candidate?
+    QString candidateNodeAddress;
+    foreach (Node node, nodes) {
+        if (node.id() == candidateNodeId) {
+            if (!node.nodeAddressList().isEmpty()) {
+                candidateNodeAddress = node.nodeAddressList().at(0).address();
+            }
+        }
+    }
+
+    if (candidateNodeAddress.isEmpty()) {
+        i++;
+        go(amountSatoshi, i);
+    }
+    else {
+        m_currentCandidateNodeId = candidateNodeId;
+        LightningModel::instance()->peersModel()->connectToPeer(candidateNodeId, candidateNodeAddress);
+    }
+}
+
+QString AutoPilot::candidateNode(const QList<Node> &nodes, const QString &ourId, quint32 iteration)
+{
+    QCryptographicHash::Algorithm standardAlgorithm1 = QCryptographicHash::Sha256;
+    QCryptoHash::Algorithm standardAlgorithm2 = QCryptoHash::RMD160;
+
+    quint32 networkOrderI = qToBigEndian(iteration);
 
     QCryptographicHash ourHashSha256(standardAlgorithm1);
     ourHashSha256.addData((char*)&networkOrderI, 4);
@@ -116,24 +143,7 @@ void AutoPilot::go(int amountSatoshi, quint32 iteration)
         candidateNodeId = hashedNodes.first();
     }
 
-    // Any idea how to connect to our candidate?
-    QString candidateNodeAddress;
-    foreach (Node node, nodes) {
-        if (node.id() == candidateNodeId) {
-            if (!node.nodeAddressList().isEmpty()) {
-                candidateNodeAddress = node.nodeAddressList().at(0).address();
-            }
-        }
-    }
-
-    if (candidateNodeAddress.isEmpty()) {
-        i++;
-        go(amountSatoshi, i);
-    }
-    else {
-        m_currentCandidateNodeId = candidateNodeId;
-        LightningModel::instance()->peersModel()->connectToPeer(candidateNodeId, candidateNodeAddress);
-    }
+    return candidateNodeId;
 }
 
 void AutoPilot::stop()
@@ -3,12 +3,17 @@
 
 #include <QObject>
 
+#include "NodesModel.h"
+
 class AutoPilot : public QObject
 {
     Q_OBJECT
 public:
     explicit AutoPilot(QObject *parent = nullptr);
 
+    // The node we should open a channel to in this iteration, see go()
+    static QString candidateNode(const QList<Node> &nodes, const QString &ourId, quint32 iteration);
+
 signals:
     void success(QString peerId);
     void failure();
@@ -0,0 +1,227 @@
+#include <QDebug>
+#include <QJsonDocument>
+
+#include "BulkInvoiceGenerator.h"
+#include "InvoicesModel.h"
+#include "macros.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
+
+static const int defaultMaxInFlight = 16;
+// Keeps progressChanged() from flooding the UI on fast daemons
+static const int progressEvery = 50;
+
+BulkInvoiceGenerator::BulkInvoiceGenerator(RpcConnectionPool *rpcSocket, InvoicesModel *invoicesModel,
+                                           QObject *parent) : QObject(parent)
+{
+    m_rpcSocket = rpcSocket;
+    m_invoicesModel = invoicesModel;
+
+    m_maxInFlight = defaultMaxInFlight;
+    m_running = false;
+    m_generation = 0;
+
+    m_expiryInSeconds = 0;
+    m_total = 0;
+    m_sent = 0;
+    m_inFlight = 0;
+    m_created = 0;
+    m_failed = 0;
+
+    m_exportFormat = JsonLines;
+    m_elapsed = 0;
+}
+
+bool BulkInvoiceGenerator::running() const
+{
+    return m_running;
+}
+
+int BulkInvoiceGenerator::total() const
+{
+    return m_total;
+}
+
+int BulkInvoiceGenerator::created() const
+{
+    return m_created;
+}
+
+int BulkInvoiceGenerator::failed() const
+{
+    return m_failed;
+}
+
+double BulkInvoiceGenerator::invoicesPerSecond() const
+{
+    qint64 elapsed = m_running ? m_clock.elapsed() : m_elapsed;
+    if (elapsed <= 0) {
+        return 0;
+    }
+    return m_created * 1000.0 / elapsed;
+}
+
+int BulkInvoiceGenerator::maxInFlight() const
+{
+    return m_maxInFlight;
+}
+
+void BulkInvoiceGenerator::setMaxInFlight(int maxInFlight)
+{
+    maxInFlight = qMax(1, maxInFlight);
+    if (m_maxInFlight == maxInFlight) {
+        return;
+    }
+    m_maxInFlight = maxInFlight;
+    emit maxInFlightChanged();
+
+    if (m_running) {
+        sendNext();
+    }
+}
+
+bool BulkInvoiceGenerator::generate(QString labelPrefix, int count, QString description,
+                                    QString amountInMsatoshi, int expiryInSeconds, QString exportPath)
+{
+    if (m_running || count <= 0) {
+        return false;
+    }
+
+    m_exportFile.setFileName(exportPath);
+    if (!m_exportFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit errorString(tr("Can't write invoices to %1: %2").arg(exportPath, m_exportFile.errorString()));
+        return false;
+    }
+
+    m_exportFormat = exportPath.endsWith(".csv", Qt::CaseInsensitive) ? Csv : JsonLines;
+    if (m_exportFormat == Csv) {
+        m_exportFile.write("label,bolt11,payment_hash,expires_at\n");
+    }
+
+    m_labelPrefix = labelPrefix;
+    m_description = description.simplified();
+    m_amountInMsatoshi = amountInMsatoshi;
+    m_expiryInSeconds = expiryInSeconds;
+
+    m_total = count;
+    m_sent = 0;
+    m_inFlight = 0;
+    m_created = 0;
+    m_failed = 0;
+
+    m_running = true;
+    m_clock.start();
+    emit runningChanged();
+    emit progressChanged();
+
+    sendNext();
+    return true;
+}
+
+void BulkInvoiceGenerator::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+    m_generation++;
+    m_inFlight = 0;
+    finish();
+}
+
+void BulkInvoiceGenerator::sendNext()
+{
+    while (m_running && m_inFlight < m_maxInFlight && m_sent < m_total) {
+        m_sent++;
+
+        QJsonObject paramsObject;
+        paramsObject.insert("label", QString("%1-%2").arg(m_labelPrefix).arg(m_sent, 5, 10, QChar('0')));
+        paramsObject.insert("description", m_description);
+        paramsObject.insert("msatoshi", m_amountInMsatoshi);
+        paramsObject.insert("expiry", QString::number(m_expiryInSeconds));
+
+        QJsonRpcMessage message = QJsonRpcMessage::createRequest("invoice", paramsObject);
+        SEND_MESSAGE_CONNECT_SLOT(message, &BulkInvoiceGenerator::invoiceRequestFinished)
+        reply->setProperty("generation", m_generation);
+        m_inFlight++;
+    }
+}
+
+void BulkInvoiceGenerator::invoiceRequestFinished()
+{
+    GET_MESSAGE_DISCONNECT_SLOT(message, &BulkInvoiceGenerator::invoiceRequestFinished)
+    if (!m_running || reply->property("generation").toInt() != m_generation) {
+        return;
+    }
+    m_inFlight--;
+
+    QString label = reply->request().params().toObject().value("label").toString();
+    if (message.type() == QJsonRpcMessage::Response) {
+        writeInvoice(label, message.toObject().value("result").toObject());
+        m_created++;
+    }
+    else {
+        // Most likely a label left over from an earlier batch, keep going
+        qDebug() << "Bulk invoice" << label << "failed:" << message.errorMessage();
+        m_failed++;
+    }
+
+    int done = m_created + m_failed;
+    if (done == m_total) {
+        finish();
+        return;
+    }
+    if (done % progressEvery == 0) {
+        emit progressChanged();
+    }
+
+    sendNext();
+}
+
+QString BulkInvoiceGenerator::csvField(const QString &field)
+{
+    if (!field.contains(',') && !field.contains('"') && !field.contains('\n')) {
+        return field;
+    }
+    return '"' + QString(field).replace('"', "\"\"") + '"';
+}
+
+void BulkInvoiceGenerator::writeInvoice(const QString &label, const QJsonObject &resultObject)
+{
+    QString bolt11 = resultObject.value("bolt11").toString();
+    QString hash = resultObject.value("payment_hash").toString();
+    qint64 expiresAt = (qint64)resultObject.value("expires_at").toDouble();
+
+    if (m_exportFormat == Csv) {
+        QString line = QStringList({ csvField(label), bolt11, hash, QString::number(expiresAt) }).join(',');
+        m_exportFile.write(line.toUtf8() + '\n');
+        return;
+    }
+
+    QJsonObject lineObject;
+    lineObject.insert("label", label);
+    lineObject.insert("bolt11", bolt11);
+    lineObject.insert("payment_hash", hash);
+    lineObject.insert("expires_at", expiresAt);
+    m_exportFile.write(QJsonDocument(lineObject).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void BulkInvoiceGenerator::finish()
+{
+    m_elapsed = m_clock.elapsed();
+    m_running = false;
+    m_exportFile.close();
+
+    qDebug() << "Bulk invoices:" << m_created << "created," << m_failed << "failed in" << m_elapsed << "ms,"
+             << invoicesPerSecond() << "invoices/s";
+
+    if (m_created + m_failed < m_total) {
+        emit errorString(tr("Stopped after %1 of %2 invoices, %3 has the %4 created")
+                         .arg(m_created + m_failed).arg(m_total).arg(m_exportFile.fileName()).arg(m_created));
+    }
+
+    // One refresh for the whole batch instead of one per invoice
+    m_invoicesModel->updateInvoices();
+
+    emit runningChanged();
+    emit progressChanged();
+    emit finished(m_created, m_failed, invoicesPerSecond());
+}
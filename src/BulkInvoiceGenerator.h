@@ -0,0 +1,94 @@
+#ifndef BULKINVOICEGENERATOR_H
+#define BULKINVOICEGENERATOR_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+
+#include "RpcConnectionPool.h"
+
+class InvoicesModel;
+
+// Creates a batch of invoices, e.g. tickets for an event, with a bounded
+// number of invoice requests in flight. Every bolt11 is appended to the
+// export file as it arrives, CSV for a .csv path and JSON lines otherwise.
+// The invoices list is only refreshed once the batch is done.
+class BulkInvoiceGenerator : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    Q_PROPERTY(int total READ total NOTIFY progressChanged)
+    Q_PROPERTY(int created READ created NOTIFY progressChanged)
+    Q_PROPERTY(int failed READ failed NOTIFY progressChanged)
+    Q_PROPERTY(double invoicesPerSecond READ invoicesPerSecond NOTIFY progressChanged)
+    Q_PROPERTY(int maxInFlight READ maxInFlight WRITE setMaxInFlight NOTIFY maxInFlightChanged)
+
+public:
+    BulkInvoiceGenerator(RpcConnectionPool *rpcSocket, InvoicesModel *invoicesModel, QObject *parent = 0);
+
+    bool running() const;
+    int total() const;
+    int created() const;
+    int failed() const;
+    double invoicesPerSecond() const;
+
+    int maxInFlight() const;
+    void setMaxInFlight(int maxInFlight);
+
+signals:
+    void runningChanged();
+    void progressChanged();
+    void maxInFlightChanged();
+    void finished(int created, int failed, double invoicesPerSecond);
+    void errorString(QString error);
+
+public slots:
+    // Labels are labelPrefix-00001 and so on. False if a batch is already
+    // running or the export can't be opened.
+    bool generate(QString labelPrefix, int count, QString description, QString amountInMsatoshi,
+                  int expiryInSeconds, QString exportPath);
+    // Replies still in flight are ignored, their invoices stay in the
+    // daemon. The export keeps the ones created so far.
+    void cancel();
+
+private slots:
+    void invoiceRequestFinished();
+
+private:
+    enum ExportFormat {
+        Csv,
+        JsonLines
+    };
+
+    static QString csvField(const QString &field);
+
+    void sendNext();
+    void writeInvoice(const QString &label, const QJsonObject &resultObject);
+    void finish();
+
+    RpcConnectionPool* m_rpcSocket;
+    InvoicesModel* m_invoicesModel;
+
+    int m_maxInFlight;
+    bool m_running;
+    int m_generation;
+
+    QString m_labelPrefix;
+    QString m_description;
+    QString m_amountInMsatoshi;
+    int m_expiryInSeconds;
+
+    int m_total;
+    int m_sent;
+    int m_inFlight;
+    int m_created;
+    int m_failed;
+
+    QFile m_exportFile;
+    ExportFormat m_exportFormat;
+
+    QElapsedTimer m_clock;
+    qint64 m_elapsed;
+};
+
+#endif // BULKINVOICEGENERATOR_H
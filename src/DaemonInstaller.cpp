@@ -0,0 +1,228 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "DaemonInstaller.h"
+
+// Bump when the manifest layout changes, old manifests are then ignored
+static const int manifestFormatVersion = 1;
+
+DaemonInstaller::DaemonInstaller(const QString &sourceDirectory, const QString &installDirectory)
+{
+    m_sourceDirectory = sourceDirectory;
+    m_installDirectory = installDirectory;
+
+    m_linkedCount = 0;
+    m_copiedCount = 0;
+    m_skippedCount = 0;
+    m_elapsed = 0;
+}
+
+void DaemonInstaller::setBinaries(const QStringList &binaries)
+{
+    m_binaries = binaries;
+}
+
+QStringList DaemonInstaller::binaries() const
+{
+    return m_binaries;
+}
+
+bool DaemonInstaller::install()
+{
+    QElapsedTimer installTimer;
+    installTimer.start();
+
+    m_linkedCount = 0;
+    m_copiedCount = 0;
+    m_skippedCount = 0;
+
+    QDir().mkpath(m_installDirectory);
+
+    QJsonObject manifest = readManifest();
+    QJsonObject binariesObject;
+    if (manifest.value("formatVersion").toInt() == manifestFormatVersion) {
+        binariesObject = manifest.value("binaries").toObject();
+    }
+
+    bool success = true;
+    bool manifestChanged = false;
+
+    foreach (QString binary, m_binaries) {
+        QJsonObject entry = binariesObject.value(binary).toObject();
+        QJsonObject previousEntry = entry;
+
+        if (isUpToDate(binary, entry)) {
+            m_skippedCount++;
+        }
+        else if (installBinary(binary)) {
+            QFileInfo sourceInfo(sourcePath(binary));
+            entry = QJsonObject();
+            entry.insert("size", sourceInfo.size());
+            entry.insert("mtime", sourceInfo.lastModified().toMSecsSinceEpoch());
+            entry.insert("sha256", QString(sha256(sourcePath(binary)).toHex()));
+        }
+        else {
+            qDebug() << "Couldn't install " << binary;
+            entry = QJsonObject();
+            success = false;
+        }
+
+        if (entry != previousEntry) {
+            binariesObject.insert(binary, entry);
+            manifestChanged = true;
+        }
+    }
+
+    if (manifestChanged) {
+        manifest = QJsonObject();
+        manifest.insert("formatVersion", manifestFormatVersion);
+        manifest.insert("binaries", binariesObject);
+        writeManifest(manifest);
+    }
+
+    m_elapsed = installTimer.elapsed();
+
+    qDebug() << "Daemon install took" << m_elapsed << "ms:"
+             << m_linkedCount << "linked," << m_copiedCount << "copied,"
+             << m_skippedCount << "up to date";
+
+    return success;
+}
+
+int DaemonInstaller::linkedCount() const
+{
+    return m_linkedCount;
+}
+
+int DaemonInstaller::copiedCount() const
+{
+    return m_copiedCount;
+}
+
+int DaemonInstaller::skippedCount() const
+{
+    return m_skippedCount;
+}
+
+qint64 DaemonInstaller::elapsed() const
+{
+    return m_elapsed;
+}
+
+QString DaemonInstaller::sourcePath(const QString &binary) const
+{
+    return m_sourceDirectory + "/lib" + binary + ".so";
+}
+
+QString DaemonInstaller::installPath(const QString &binary) const
+{
+    return m_installDirectory + "/" + binary;
+}
+
+QString DaemonInstaller::manifestPath() const
+{
+    return m_installDirectory + "/install-manifest.json";
+}
+
+QJsonObject DaemonInstaller::readManifest() const
+{
+    QFile manifestFile(manifestPath());
+    if (!manifestFile.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+
+    return QJsonDocument::fromJson(manifestFile.readAll()).object();
+}
+
+bool DaemonInstaller::writeManifest(const QJsonObject &manifest) const
+{
+    // Never leave a half written manifest behind, it would skip broken binaries
+    QSaveFile manifestFile(manifestPath());
+    if (!manifestFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    manifestFile.write(QJsonDocument(manifest).toJson());
+    return manifestFile.commit();
+}
+
+bool DaemonInstaller::isUpToDate(const QString &binary, QJsonObject &entry)
+{
+    QFileInfo sourceInfo(sourcePath(binary));
+    QFileInfo installInfo(installPath(binary));
+
+    if (entry.isEmpty() || !sourceInfo.exists() || !installInfo.exists()) {
+        return false;
+    }
+
+    if (installInfo.size() != sourceInfo.size()
+            || entry.value("size").toVariant().toLongLong() != sourceInfo.size()) {
+        return false;
+    }
+
+    qint64 sourceModified = sourceInfo.lastModified().toMSecsSinceEpoch();
+    if (entry.value("mtime").toVariant().toLongLong() == sourceModified) {
+        // Same size and time stamp, no need to read anything
+        return true;
+    }
+
+    // Touched but maybe not changed, e.g. the same package reinstalled
+    if (QString(sha256(sourcePath(binary)).toHex()) == entry.value("sha256").toString()) {
+        entry.insert("mtime", sourceModified);
+        return true;
+    }
+
+    return false;
+}
+
+bool DaemonInstaller::installBinary(const QString &binary)
+{
+    QString source = sourcePath(binary);
+    QString destination = installPath(binary);
+
+    if (!QFileInfo::exists(source)) {
+        return false;
+    }
+
+    QFile::remove(destination);
+
+#ifdef Q_OS_UNIX
+    // A hard link costs no flash I/O at all, lib/ is usually on the same partition
+    if (::link(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData()) == 0) {
+        m_linkedCount++;
+        return true;
+    }
+#endif
+
+    if (!QFile::copy(source, destination)) {
+        return false;
+    }
+
+    QFile::setPermissions(destination, QFile::permissions(destination)
+                          | QFile::ExeOwner | QFile::ReadOwner);
+    m_copiedCount++;
+    return true;
+}
+
+QByteArray DaemonInstaller::sha256(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(&file);
+    return hash.result();
+}
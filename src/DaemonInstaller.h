@@ -0,0 +1,51 @@
+#ifndef DAEMONINSTALLER_H
+#define DAEMONINSTALLER_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+// Installs the lightningd binaries shipped as lib*.so into the directory
+// lightningd runs from. Keeps a manifest of what was installed so binaries
+// that didn't change since the last start are left alone.
+class DaemonInstaller
+{
+public:
+    DaemonInstaller(const QString &sourceDirectory, const QString &installDirectory);
+
+    // Source file is sourceDirectory/lib<name>.so, installed as installDirectory/<name>
+    void setBinaries(const QStringList &binaries);
+    QStringList binaries() const;
+
+    // Returns false if any binary couldn't be installed
+    bool install();
+
+    int linkedCount() const;
+    int copiedCount() const;
+    int skippedCount() const;
+    qint64 elapsed() const;
+
+private:
+    QString sourcePath(const QString &binary) const;
+    QString installPath(const QString &binary) const;
+    QString manifestPath() const;
+
+    QJsonObject readManifest() const;
+    bool writeManifest(const QJsonObject &manifest) const;
+
+    bool isUpToDate(const QString &binary, QJsonObject &entry);
+    bool installBinary(const QString &binary);
+
+    static QByteArray sha256(const QString &path);
+
+    QString m_sourceDirectory;
+    QString m_installDirectory;
+    QStringList m_binaries;
+
+    int m_linkedCount;
+    int m_copiedCount;
+    int m_skippedCount;
+    qint64 m_elapsed;
+};
+
+#endif // DAEMONINSTALLER_H
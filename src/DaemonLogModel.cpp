@@ -0,0 +1,376 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+#include "DaemonLogModel.h"
+
+// Longest line we keep waiting for a newline on
+static const int maxPendingLine = 64 * 1024;
+static const int maxStandardErrorTail = 16 * 1024;
+static const qint64 maxLogFileSize = 4 * 1024 * 1024;
+static const int rotatedLogFiles = 3;
+
+QHash<int, QByteArray> DaemonLogModel::roleNames() const {
+    QHash<int, QByteArray> roles;
+    roles[TimestampRole] = "timestamp";
+    roles[LevelRole] = "level";
+    roles[LevelStringRole] = "levelstring";
+    roles[SubsystemRole] = "subsystem";
+    roles[MessageRole] = "message";
+    roles[StandardErrorRole] = "standarderror";
+    return roles;
+}
+
+DaemonLogModel::DaemonLogModel(int capacity, QObject *parent) : QAbstractListModel(parent)
+{
+    m_process = nullptr;
+
+    m_capacity = qMax(1, capacity);
+    m_entries = QVector<DaemonLogEntry>(m_capacity);
+    m_first = 0;
+    m_count = 0;
+    m_droppedLines = 0;
+
+    QString logDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/logs";
+    QDir().mkpath(logDirectory);
+    m_logFilePath = logDirectory + "/lightningd.log";
+    m_logFile.setFileName(m_logFilePath);
+}
+
+void DaemonLogModel::attachProcess(QProcess *process)
+{
+    if (m_process) {
+        QObject::disconnect(m_process, 0, this, 0);
+    }
+
+    m_process = process;
+    m_pendingStandardOutput.clear();
+    m_pendingStandardError.clear();
+
+    if (m_process) {
+        QObject::connect(m_process, &QProcess::readyReadStandardOutput, this, &DaemonLogModel::readStandardOutput);
+        QObject::connect(m_process, &QProcess::readyReadStandardError, this, &DaemonLogModel::readStandardError);
+    }
+}
+
+int DaemonLogModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_count;
+}
+
+QVariant DaemonLogModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_count)
+        return QVariant();
+
+    const DaemonLogEntry &entry = entryAt(index.row());
+    if (role == TimestampRole)
+        return QDateTime::fromMSecsSinceEpoch(entry.m_timestamp);
+    else if (role == LevelRole)
+        return entry.m_level;
+    else if (role == LevelStringRole)
+        return levelString(entry.m_level);
+    else if (role == SubsystemRole)
+        return entry.m_subsystem;
+    else if (role == MessageRole || role == Qt::DisplayRole)
+        return entry.m_message;
+    else if (role == StandardErrorRole)
+        return entry.m_standardError;
+    return QVariant();
+}
+
+int DaemonLogModel::capacity() const
+{
+    return m_capacity;
+}
+
+int DaemonLogModel::droppedLines() const
+{
+    return m_droppedLines;
+}
+
+QString DaemonLogModel::logFilePath() const
+{
+    return m_logFilePath;
+}
+
+QByteArray DaemonLogModel::standardErrorTail() const
+{
+    return m_standardErrorTail;
+}
+
+DaemonLogEntry DaemonLogModel::parseLine(const QString &line, bool standardError)
+{
+    // e.g. "2018-06-01T10:11:12.123Z lightning_gossipd(1234): UNUSUAL: Something"
+    // Timestamp, pid and level are all optional depending on the daemon version
+    static const QRegularExpression lineExpression(
+                "^(?:(\\d{4}-\\d\\d-\\d\\dT\\S+)\\s+)?"
+                "(?:(IO_IN|IO_OUT|IO|DEBUG|INFO|UNUSUAL|BROKEN)\\s+)?"
+                "([A-Za-z0-9_\\-]+)(?:\\(\\d+\\))?:\\s?"
+                "(?:(IO_IN|IO_OUT|IO|DEBUG|INFO|UNUSUAL|BROKEN):?\\s)?"
+                "(.*)$");
+
+    DaemonLogEntry entry;
+    entry.m_standardError = standardError;
+    entry.m_level = standardError ? DaemonLogEntry::Unusual : DaemonLogEntry::Info;
+
+    QRegularExpressionMatch match = lineExpression.match(line);
+    if (!match.hasMatch()) {
+        entry.m_timestamp = QDateTime::currentMSecsSinceEpoch();
+        entry.m_message = line;
+        return entry;
+    }
+
+    QDateTime timestamp = QDateTime::fromString(match.captured(1), Qt::ISODateWithMs);
+    entry.m_timestamp = timestamp.isValid() ? timestamp.toMSecsSinceEpoch() : QDateTime::currentMSecsSinceEpoch();
+
+    QString level = match.captured(2).isEmpty() ? match.captured(4) : match.captured(2);
+    if (level.startsWith("IO"))
+        entry.m_level = DaemonLogEntry::Io;
+    else if (level == "DEBUG")
+        entry.m_level = DaemonLogEntry::Debug;
+    else if (level == "INFO")
+        entry.m_level = DaemonLogEntry::Info;
+    else if (level == "UNUSUAL")
+        entry.m_level = DaemonLogEntry::Unusual;
+    else if (level == "BROKEN")
+        entry.m_level = DaemonLogEntry::Broken;
+
+    entry.m_subsystem = match.captured(3);
+    entry.m_message = match.captured(5);
+    return entry;
+}
+
+QString DaemonLogModel::levelString(DaemonLogEntry::Level level)
+{
+    switch (level) {
+    case DaemonLogEntry::Io:
+        return "IO";
+    case DaemonLogEntry::Debug:
+        return "DEBUG";
+    case DaemonLogEntry::Info:
+        return "INFO";
+    case DaemonLogEntry::Unusual:
+        return "UNUSUAL";
+    case DaemonLogEntry::Broken:
+        return "BROKEN";
+    }
+    return QString();
+}
+
+void DaemonLogModel::drain()
+{
+    if (!m_process) {
+        return;
+    }
+
+    readStandardOutput();
+    readStandardError();
+}
+
+void DaemonLogModel::clear()
+{
+    beginResetModel();
+    m_entries = QVector<DaemonLogEntry>(m_capacity);
+    m_first = 0;
+    m_count = 0;
+    endResetModel();
+}
+
+void DaemonLogModel::readStandardOutput()
+{
+    QByteArray data = m_process->readAllStandardOutput();
+    if (data.isEmpty()) {
+        return;
+    }
+
+    spillToFile(data);
+
+    QVector<DaemonLogEntry> entries;
+    splitLines(m_pendingStandardOutput, data, false, entries);
+    appendEntries(entries);
+}
+
+void DaemonLogModel::readStandardError()
+{
+    QByteArray data = m_process->readAllStandardError();
+    if (data.isEmpty()) {
+        return;
+    }
+
+    spillToFile(data);
+
+    m_standardErrorTail.append(data);
+    if (m_standardErrorTail.size() > maxStandardErrorTail) {
+        m_standardErrorTail = m_standardErrorTail.right(maxStandardErrorTail);
+    }
+
+    QVector<DaemonLogEntry> entries;
+    splitLines(m_pendingStandardError, data, true, entries);
+    appendEntries(entries);
+}
+
+void DaemonLogModel::splitLines(QByteArray &pending, const QByteArray &data, bool standardError, QVector<DaemonLogEntry> &entries)
+{
+    pending.append(data);
+
+    int lineStart = 0;
+    int lineEnd;
+    while ((lineEnd = pending.indexOf('\n', lineStart)) != -1) {
+        QByteArray line = pending.mid(lineStart, lineEnd - lineStart);
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        if (!line.isEmpty()) {
+            entries.append(parseLine(QString::fromUtf8(line), standardError));
+        }
+        lineStart = lineEnd + 1;
+    }
+    pending.remove(0, lineStart);
+
+    // Don't let a missing newline grow the buffer forever
+    if (pending.size() > maxPendingLine) {
+        entries.append(parseLine(QString::fromUtf8(pending), standardError));
+        pending.clear();
+    }
+}
+
+void DaemonLogModel::appendEntries(const QVector<DaemonLogEntry> &entries)
+{
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    int droppedLines = m_droppedLines;
+
+    // A burst larger than the whole buffer only keeps its tail
+    int firstNew = qMax(0, entries.size() - m_capacity);
+    int newCount = entries.size() - firstNew;
+    m_droppedLines += firstNew;
+
+    int overflow = m_count + newCount - m_capacity;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_first = (m_first + overflow) % m_capacity;
+        m_count -= overflow;
+        endRemoveRows();
+        m_droppedLines += overflow;
+    }
+
+    beginInsertRows(QModelIndex(), m_count, m_count + newCount - 1);
+    for (int i = 0; i < newCount; i++) {
+        m_entries[(m_first + m_count + i) % m_capacity] = entries.at(firstNew + i);
+    }
+    m_count += newCount;
+    endInsertRows();
+
+    if (droppedLines != m_droppedLines) {
+        emit droppedLinesChanged();
+    }
+}
+
+const DaemonLogEntry &DaemonLogModel::entryAt(int row) const
+{
+    return m_entries.at((m_first + row) % m_capacity);
+}
+
+void DaemonLogModel::spillToFile(const QByteArray &data)
+{
+    if (!m_logFile.isOpen() && !m_logFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return;
+    }
+
+    m_logFile.write(data);
+    m_logFile.flush();
+
+    if (m_logFile.size() > maxLogFileSize) {
+        rotateLogFiles();
+    }
+}
+
+void DaemonLogModel::rotateLogFiles()
+{
+    m_logFile.close();
+
+    // lightningd.log -> lightningd.log.1 -> ... -> lightningd.log.N
+    QFile::remove(m_logFilePath + "." + QString::number(rotatedLogFiles));
+    for (int i = rotatedLogFiles - 1; i >= 1; i--) {
+        QFile::rename(m_logFilePath + "." + QString::number(i),
+                      m_logFilePath + "." + QString::number(i + 1));
+    }
+    QFile::rename(m_logFilePath, m_logFilePath + ".1");
+}
+
+DaemonLogFilterModel::DaemonLogFilterModel(DaemonLogModel *logModel, QObject *parent) : QSortFilterProxyModel(parent)
+{
+    m_minimumLevel = DaemonLogEntry::Io;
+    setSourceModel(logModel);
+}
+
+int DaemonLogFilterModel::minimumLevel() const
+{
+    return m_minimumLevel;
+}
+
+void DaemonLogFilterModel::setMinimumLevel(int minimumLevel)
+{
+    if (m_minimumLevel == minimumLevel) {
+        return;
+    }
+    m_minimumLevel = minimumLevel;
+    invalidateFilter();
+    emit filterChanged();
+}
+
+QString DaemonLogFilterModel::subsystem() const
+{
+    return m_subsystem;
+}
+
+void DaemonLogFilterModel::setSubsystem(const QString &subsystem)
+{
+    if (m_subsystem == subsystem) {
+        return;
+    }
+    m_subsystem = subsystem;
+    invalidateFilter();
+    emit filterChanged();
+}
+
+QString DaemonLogFilterModel::searchText() const
+{
+    return m_searchText;
+}
+
+void DaemonLogFilterModel::setSearchText(const QString &searchText)
+{
+    if (m_searchText == searchText) {
+        return;
+    }
+    m_searchText = searchText;
+    invalidateFilter();
+    emit filterChanged();
+}
+
+bool DaemonLogFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+
+    if (index.data(DaemonLogModel::LevelRole).toInt() < m_minimumLevel) {
+        return false;
+    }
+
+    if (!m_subsystem.isEmpty() && index.data(DaemonLogModel::SubsystemRole).toString() != m_subsystem) {
+        return false;
+    }
+
+    if (!m_searchText.isEmpty()
+            && !index.data(DaemonLogModel::MessageRole).toString().contains(m_searchText, Qt::CaseInsensitive)) {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,143 @@
+#ifndef DAEMONLOGMODEL_H
+#define DAEMONLOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QFile>
+#include <QProcess>
+#include <QSortFilterProxyModel>
+#include <QVector>
+
+class DaemonLogEntry
+{
+public:
+    // Same order as c-lightning's log levels, most verbose first
+    enum Level {
+        Io,
+        Debug,
+        Info,
+        Unusual,
+        Broken
+    };
+
+    DaemonLogEntry()
+    {
+        m_timestamp = 0;
+        m_level = Info;
+        m_standardError = false;
+    }
+
+    qint64 m_timestamp;
+    Level m_level;
+    QString m_subsystem;
+    QString m_message;
+    bool m_standardError;
+};
+
+// Drains lightningd's stdout and stderr as they arrive into a fixed size
+// ring buffer, so a chatty daemon never blocks on a full pipe and we never
+// hold more than capacity lines. Everything is also spilled to rotating files.
+class DaemonLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int capacity READ capacity CONSTANT)
+    Q_PROPERTY(int droppedLines READ droppedLines NOTIFY droppedLinesChanged)
+    Q_PROPERTY(QString logFilePath READ logFilePath CONSTANT)
+
+public:
+    enum DaemonLogRoles {
+        TimestampRole = Qt::UserRole + 1,
+        LevelRole,
+        LevelStringRole,
+        SubsystemRole,
+        MessageRole,
+        StandardErrorRole
+    };
+
+    QHash<int, QByteArray> roleNames() const;
+
+    DaemonLogModel(int capacity = 2000, QObject *parent = 0);
+
+    void attachProcess(QProcess *process);
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    int capacity() const;
+    int droppedLines() const;
+    QString logFilePath() const;
+
+    // Last few kB of stderr, for checking why the daemon went away
+    QByteArray standardErrorTail() const;
+
+    static DaemonLogEntry parseLine(const QString &line, bool standardError);
+    static QString levelString(DaemonLogEntry::Level level);
+
+public slots:
+    // Reads whatever the process has buffered, never waits for more
+    void drain();
+    void clear();
+
+signals:
+    void droppedLinesChanged();
+
+private slots:
+    void readStandardOutput();
+    void readStandardError();
+
+private:
+    void splitLines(QByteArray &pending, const QByteArray &data, bool standardError, QVector<DaemonLogEntry> &entries);
+    void appendEntries(const QVector<DaemonLogEntry> &entries);
+    const DaemonLogEntry &entryAt(int row) const;
+
+    void spillToFile(const QByteArray &data);
+    void rotateLogFiles();
+
+    QProcess* m_process;
+
+    QVector<DaemonLogEntry> m_entries;
+    int m_capacity;
+    int m_first;
+    int m_count;
+    int m_droppedLines;
+
+    QByteArray m_pendingStandardOutput;
+    QByteArray m_pendingStandardError;
+    QByteArray m_standardErrorTail;
+
+    QFile m_logFile;
+    QString m_logFilePath;
+};
+
+// Level, subsystem and text filter on top of the ring buffer for the log page
+class DaemonLogFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int minimumLevel READ minimumLevel WRITE setMinimumLevel NOTIFY filterChanged)
+    Q_PROPERTY(QString subsystem READ subsystem WRITE setSubsystem NOTIFY filterChanged)
+    Q_PROPERTY(QString searchText READ searchText WRITE setSearchText NOTIFY filterChanged)
+
+public:
+    DaemonLogFilterModel(DaemonLogModel *logModel, QObject *parent = 0);
+
+    int minimumLevel() const;
+    void setMinimumLevel(int minimumLevel);
+
+    QString subsystem() const;
+    void setSubsystem(const QString &subsystem);
+
+    QString searchText() const;
+    void setSearchText(const QString &searchText);
+
+signals:
+    void filterChanged();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+
+private:
+    int m_minimumLevel;
+    QString m_subsystem;
+    QString m_searchText;
+};
+
+#endif // DAEMONLOGMODEL_H
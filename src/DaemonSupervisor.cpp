@@ -0,0 +1,198 @@
+#include <QDebug>
+
+#include "DaemonSupervisor.h"
+#include "macros.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
+
+static const int initialRestartDelay = 1000;
+static const int maxRestartDelay = 60000;
+// Running this long without trouble starts the backoff over
+static const int stableTime = 60000;
+
+DaemonSupervisor::DaemonSupervisor(RpcConnectionPool *rpcSocket, QObject *parent) : QObject(parent)
+{
+    m_rpcSocket = rpcSocket;
+
+    m_recovering = false;
+    m_backoffStep = 0;
+    m_restartCount = 0;
+    m_lastRecoveryTime = 0;
+    m_probeLatency = 0;
+
+    m_probeTimer = new QTimer(this);
+    m_probeTimer->setInterval(10000);
+    QObject::connect(m_probeTimer, &QTimer::timeout, this, &DaemonSupervisor::sendProbe);
+
+    m_hangTimer = new QTimer(this);
+    m_hangTimer->setInterval(15000);
+    m_hangTimer->setSingleShot(true);
+    QObject::connect(m_hangTimer, &QTimer::timeout, this, &DaemonSupervisor::probeTimedOut);
+
+    m_restartTimer = new QTimer(this);
+    m_restartTimer->setSingleShot(true);
+    QObject::connect(m_restartTimer, &QTimer::timeout, this, &DaemonSupervisor::restartTimeout);
+
+    m_stableTimer = new QTimer(this);
+    m_stableTimer->setInterval(stableTime);
+    m_stableTimer->setSingleShot(true);
+    QObject::connect(m_stableTimer, &QTimer::timeout, this, &DaemonSupervisor::resetBackoff);
+}
+
+bool DaemonSupervisor::recovering() const
+{
+    return m_recovering;
+}
+
+int DaemonSupervisor::restartCount() const
+{
+    return m_restartCount;
+}
+
+int DaemonSupervisor::lastRecoveryTime() const
+{
+    return m_lastRecoveryTime;
+}
+
+int DaemonSupervisor::probeLatency() const
+{
+    return m_probeLatency;
+}
+
+int DaemonSupervisor::probeInterval() const
+{
+    return m_probeTimer->interval();
+}
+
+void DaemonSupervisor::setProbeInterval(int probeInterval)
+{
+    m_probeTimer->setInterval(probeInterval);
+}
+
+int DaemonSupervisor::hangTimeout() const
+{
+    return m_hangTimer->interval();
+}
+
+void DaemonSupervisor::setHangTimeout(int hangTimeout)
+{
+    m_hangTimer->setInterval(hangTimeout);
+}
+
+void DaemonSupervisor::daemonConnected()
+{
+    m_restartTimer->stop();
+    m_probeReply = nullptr;
+    m_probeTimer->start();
+    m_stableTimer->start();
+
+    if (m_recovering) {
+        m_recovering = false;
+        m_lastRecoveryTime = m_downElapsed.elapsed();
+        qDebug() << "Daemon recovered after" << m_lastRecoveryTime << "ms, restarts:" << m_restartCount;
+        emit stateChanged();
+    }
+}
+
+void DaemonSupervisor::daemonExited(bool restart)
+{
+    m_probeTimer->stop();
+    m_hangTimer->stop();
+    m_stableTimer->stop();
+    m_probeReply = nullptr;
+
+    if (!m_recovering) {
+        m_recovering = true;
+        m_downElapsed.start();
+    }
+
+    if (restart) {
+        scheduleRestart();
+    }
+    else {
+        m_recovering = false;
+    }
+
+    emit stateChanged();
+}
+
+void DaemonSupervisor::stop()
+{
+    m_probeTimer->stop();
+    m_hangTimer->stop();
+    m_restartTimer->stop();
+    m_stableTimer->stop();
+    m_probeReply = nullptr;
+
+    if (m_recovering) {
+        m_recovering = false;
+        emit stateChanged();
+    }
+}
+
+void DaemonSupervisor::scheduleRestart()
+{
+    if (m_restartTimer->isActive()) {
+        return;
+    }
+
+    int delay = qMin(initialRestartDelay << m_backoffStep, maxRestartDelay);
+    if (delay < maxRestartDelay) {
+        m_backoffStep++;
+    }
+
+    qDebug() << "Restarting daemon in" << delay << "ms";
+    m_restartTimer->start(delay);
+}
+
+void DaemonSupervisor::restartTimeout()
+{
+    m_restartCount++;
+    emit stateChanged();
+    emit restartRequested();
+}
+
+void DaemonSupervisor::resetBackoff()
+{
+    m_backoffStep = 0;
+}
+
+void DaemonSupervisor::sendProbe()
+{
+    if (m_probeReply) {
+        // Previous probe still out, the hang timer takes care of it
+        return;
+    }
+
+    // On its own connection, behind a slow listnodes a healthy daemon
+    // would look hung
+    QJsonRpcMessage message = QJsonRpcMessage::createRequest("getinfo", QJsonValue());
+    QJsonRpcServiceReply* reply = m_rpcSocket->sendMessage(message, RpcConnectionPool::ProbeLane);
+    QObject::connect(reply, &QJsonRpcServiceReply::finished, this, &DaemonSupervisor::probeRequestFinished);
+    m_probeReply = reply;
+    m_probeElapsed.start();
+    m_hangTimer->start();
+}
+
+void DaemonSupervisor::probeRequestFinished()
+{
+    GET_MESSAGE_DISCONNECT_SLOT(message, &DaemonSupervisor::probeRequestFinished)
+    if (reply != m_probeReply) {
+        // Answer to a probe we already gave up on
+        return;
+    }
+
+    m_hangTimer->stop();
+    m_probeReply = nullptr;
+
+    if (message.type() == QJsonRpcMessage::Response) {
+        m_probeLatency = m_probeElapsed.elapsed();
+        emit probeLatencyChanged();
+    }
+}
+
+void DaemonSupervisor::probeTimedOut()
+{
+    qDebug() << "Daemon didn't answer getinfo within" << m_hangTimer->interval() << "ms";
+    m_probeReply = nullptr;
+    emit hangDetected();
+}
@@ -0,0 +1,80 @@
+#ifndef DAEMONSUPERVISOR_H
+#define DAEMONSUPERVISOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include "RpcConnectionPool.h"
+
+class QJsonRpcServiceReply;
+
+// Keeps an eye on the daemon we launched. Probes it with getinfo while
+// connected and asks for a restart, with exponential backoff, when it
+// crashes or stops answering.
+class DaemonSupervisor : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool recovering READ recovering NOTIFY stateChanged)
+    Q_PROPERTY(int restartCount READ restartCount NOTIFY stateChanged)
+    Q_PROPERTY(int lastRecoveryTime READ lastRecoveryTime NOTIFY stateChanged)
+    Q_PROPERTY(int probeLatency READ probeLatency NOTIFY probeLatencyChanged)
+
+public:
+    DaemonSupervisor(RpcConnectionPool *rpcSocket, QObject *parent = 0);
+
+    bool recovering() const;
+    int restartCount() const;
+    int lastRecoveryTime() const;
+    int probeLatency() const;
+
+    int probeInterval() const;
+    void setProbeInterval(int probeInterval);
+
+    int hangTimeout() const;
+    void setHangTimeout(int hangTimeout);
+
+public slots:
+    // Call once the RPC connection is up, starts the probes
+    void daemonConnected();
+    // Daemon went away, schedules a restart unless it exited on purpose
+    void daemonExited(bool restart = true);
+    void stop();
+
+signals:
+    void restartRequested();
+    // Daemon is alive but getinfo didn't come back in time
+    void hangDetected();
+    void stateChanged();
+    void probeLatencyChanged();
+
+private slots:
+    void sendProbe();
+    void probeRequestFinished();
+    void probeTimedOut();
+    void resetBackoff();
+    void restartTimeout();
+
+private:
+    void scheduleRestart();
+
+    RpcConnectionPool* m_rpcSocket;
+
+    QTimer* m_probeTimer;
+    QTimer* m_hangTimer;
+    QTimer* m_restartTimer;
+    QTimer* m_stableTimer;
+
+    QPointer<QJsonRpcServiceReply> m_probeReply;
+    QElapsedTimer m_probeElapsed;
+    QElapsedTimer m_downElapsed;
+
+    bool m_recovering;
+    int m_backoffStep;
+    int m_restartCount;
+    int m_lastRecoveryTime;
+    int m_probeLatency;
+};
+
+#endif // DAEMONSUPERVISOR_H
@@ -0,0 +1,161 @@
+#include <QAbstractItemModel>
+#include <QMetaEnum>
+
+#include "HeadlessService.h"
+#include "AutoPilot.h"
+#include "LightningModel.h"
+#include "RevenueBucketModel.h"
+#include "RpcDiagnostics.h"
+
+HeadlessService::HeadlessService(LightningModel *lightningModel, AutoPilot *autoPilot, QObject *parent)
+    : QJsonRpcService(parent)
+{
+    m_lightningModel = lightningModel;
+    m_autoPilot = autoPilot;
+}
+
+QVariantList HeadlessService::modelRows(QAbstractItemModel *model)
+{
+    QHash<int, QByteArray> roleNames = model->roleNames();
+
+    QVariantList rows;
+    rows.reserve(model->rowCount());
+    for (int row = 0; row < model->rowCount(); row++) {
+        QModelIndex index = model->index(row, 0);
+        QVariantMap rowMap;
+        for (QHash<int, QByteArray>::const_iterator it = roleNames.constBegin(); it != roleNames.constEnd(); ++it) {
+            rowMap.insert(QString::fromLatin1(it.value()), model->data(index, it.key()));
+        }
+        rows.append(rowMap);
+    }
+    return rows;
+}
+
+QVariantMap HeadlessService::getInfo() const
+{
+    QMetaEnum startupPhaseEnum = QMetaEnum::fromType<LightningModel::StartupPhase>();
+
+    QVariantMap info;
+    info.insert("id", m_lightningModel->id());
+    info.insert("address", m_lightningModel->address());
+    info.insert("port", m_lightningModel->port());
+    info.insert("version", m_lightningModel->version());
+    info.insert("blockheight", m_lightningModel->blockheight());
+    info.insert("network", m_lightningModel->network());
+    info.insert("connectedToDaemon", m_lightningModel->connectedToDaemon());
+    info.insert("startupPhase", QString::fromLatin1(startupPhaseEnum.valueToKey(m_lightningModel->startupPhase())));
+    info.insert("startupTimings", m_lightningModel->startupTimings());
+    info.insert("recovering", m_lightningModel->daemonSupervisor()->recovering());
+    info.insert("restartCount", m_lightningModel->daemonSupervisor()->restartCount());
+    return info;
+}
+
+QVariantMap HeadlessService::getBalance() const
+{
+    QVariantMap balance;
+    balance.insert("onChainSatoshi", m_lightningModel->walletModel()->totalAvailableFunds());
+    balance.insert("channelSatoshi", m_lightningModel->peersModel()->totalAvailableFunds() / 1000);
+    balance.insert("spendableMsatoshi", m_lightningModel->peersModel()->spendableMsatoshi());
+    balance.insert("receivableMsatoshi", m_lightningModel->peersModel()->receivableMsatoshi());
+    balance.insert("confirmedSatoshi", m_lightningModel->walletModel()->confirmedSatoshi());
+    balance.insert("unconfirmedSatoshi", m_lightningModel->walletModel()->unconfirmedSatoshi());
+    return balance;
+}
+
+QVariantList HeadlessService::listInvoices() const
+{
+    return modelRows(m_lightningModel->invoicesModel());
+}
+
+QVariantList HeadlessService::listPayments() const
+{
+    return modelRows(m_lightningModel->paymentsModel());
+}
+
+QVariantList HeadlessService::listPeers() const
+{
+    return modelRows(m_lightningModel->peersModel());
+}
+
+QVariantList HeadlessService::listFunds() const
+{
+    return modelRows(m_lightningModel->walletModel());
+}
+
+QVariantList HeadlessService::listRevenue(QString granularity) const
+{
+    RevenueAggregator::Granularity bucketGranularity = RevenueAggregator::Day;
+    if (granularity == "hour") {
+        bucketGranularity = RevenueAggregator::Hour;
+    }
+    else if (granularity == "month") {
+        bucketGranularity = RevenueAggregator::Month;
+    }
+
+    RevenueBucketModel revenueModel(m_lightningModel->revenueAggregator(), bucketGranularity);
+    return modelRows(&revenueModel);
+}
+
+bool HeadlessService::createInvoice(QString label, QString description, QString amountInMsatoshi, int expiryInSeconds)
+{
+    if (!m_lightningModel->connectedToDaemon()) {
+        return false;
+    }
+    m_lightningModel->invoicesModel()->addInvoice(label, description, amountInMsatoshi, expiryInSeconds);
+    return true;
+}
+
+bool HeadlessService::createInvoices(QString labelPrefix, int count, QString description,
+                                     QString amountInMsatoshi, int expiryInSeconds, QString exportPath)
+{
+    if (!m_lightningModel->connectedToDaemon()) {
+        return false;
+    }
+    return m_lightningModel->bulkInvoiceGenerator()->generate(labelPrefix, count, description, amountInMsatoshi,
+                                                              expiryInSeconds, exportPath);
+}
+
+bool HeadlessService::pay(QString bolt11, int msatoshiAmount)
+{
+    if (!m_lightningModel->connectedToDaemon()) {
+        return false;
+    }
+    m_lightningModel->paymentsModel()->pay(bolt11, msatoshiAmount);
+    return true;
+}
+
+bool HeadlessService::startAutoPilot(int amountSatoshi)
+{
+    if (!m_lightningModel->connectedToDaemon()) {
+        return false;
+    }
+    m_autoPilot->go(amountSatoshi);
+    return true;
+}
+
+bool HeadlessService::refresh()
+{
+    if (!m_lightningModel->connectedToDaemon()) {
+        return false;
+    }
+    m_lightningModel->updateModels();
+    return true;
+}
+
+QVariantMap HeadlessService::diagnostics() const
+{
+    QVariantMap diagnostics;
+    if (RpcDiagnostics::instance()) {
+        diagnostics = RpcDiagnostics::instance()->toJson().toVariantMap();
+    }
+
+    BulkInvoiceGenerator *generator = m_lightningModel->bulkInvoiceGenerator();
+    QVariantMap bulkInvoices;
+    bulkInvoices.insert("running", generator->running());
+    bulkInvoices.insert("total", generator->total());
+    bulkInvoices.insert("created", generator->created());
+    bulkInvoices.insert("failed", generator->failed());
+    bulkInvoices.insert("invoicesPerSecond", generator->invoicesPerSecond());
+    diagnostics.insert("bulkInvoices", bulkInvoices);
+    return diagnostics;
+}
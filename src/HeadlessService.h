@@ -0,0 +1,52 @@
+#ifndef HEADLESSSERVICE_H
+#define HEADLESSSERVICE_H
+
+#include <QVariantList>
+#include <QVariantMap>
+
+#include "./3rdparty/qjsonrpc/src/qjsonrpcservice.h"
+
+class QAbstractItemModel;
+class AutoPilot;
+class LightningModel;
+
+// What the UI can see and do, as JSON-RPC methods for automation when
+// running without one, e.g. {"method": "presto.listInvoices"}. Actions only
+// start the request like their buttons do, the result shows up in the lists.
+class HeadlessService : public QJsonRpcService
+{
+    Q_OBJECT
+    Q_CLASSINFO("serviceName", "presto")
+
+public:
+    HeadlessService(LightningModel *lightningModel, AutoPilot *autoPilot, QObject *parent = 0);
+
+public slots:
+    QVariantMap getInfo() const;
+    QVariantMap getBalance() const;
+
+    QVariantList listInvoices() const;
+    QVariantList listPayments() const;
+    QVariantList listPeers() const;
+    QVariantList listFunds() const;
+    // "hour", "day" or "month"
+    QVariantList listRevenue(QString granularity) const;
+
+    bool createInvoice(QString label, QString description, QString amountInMsatoshi, int expiryInSeconds);
+    // Progress is in diagnostics, bulkInvoices
+    bool createInvoices(QString labelPrefix, int count, QString description, QString amountInMsatoshi,
+                        int expiryInSeconds, QString exportPath);
+    bool pay(QString bolt11, int msatoshiAmount);
+    bool startAutoPilot(int amountSatoshi);
+    bool refresh();
+
+    QVariantMap diagnostics() const;
+
+private:
+    static QVariantList modelRows(QAbstractItemModel *model);
+
+    LightningModel* m_lightningModel;
+    AutoPilot* m_autoPilot;
+};
+
+#endif // HEADLESSSERVICE_H
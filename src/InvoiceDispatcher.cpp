@@ -0,0 +1,223 @@
+#include <QDateTime>
+#include <QDebug>
+
+#include "InvoiceDispatcher.h"
+#include "InvoicesModel.h"
+#include "PeersModel.h"
+#include "Tracer.h"
+#include "macros.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
+
+static const int retryInterval = 5000;
+static const int expiryCheckInterval = 5000;
+static const int balanceRefreshDelay = 250;
+
+InvoiceDispatcher::InvoiceDispatcher(RpcConnectionPool *rpcSocket, InvoicesModel *invoicesModel,
+                                     PeersModel *peersModel, QObject *parent) : QObject(parent)
+{
+    m_rpcSocket = rpcSocket;
+    m_invoicesModel = invoicesModel;
+    m_peersModel = peersModel;
+
+    m_running = false;
+    m_waitingForList = false;
+    m_generation = 0;
+    m_lastPayIndex = 0;
+
+    m_paymentCount = 0;
+    m_lastPaymentLatency = 0;
+    m_totalPaymentLatency = 0;
+    m_maxPaymentLatency = 0;
+
+    QObject::connect(m_invoicesModel, &InvoicesModel::invoicesRefreshed, this, &InvoiceDispatcher::invoicesRefreshed);
+
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setInterval(retryInterval);
+    m_retryTimer->setSingleShot(true);
+    QObject::connect(m_retryTimer, &QTimer::timeout, this, &InvoiceDispatcher::retryWait);
+
+    m_expiryTimer = new QTimer(this);
+    m_expiryTimer->setInterval(expiryCheckInterval);
+    QObject::connect(m_expiryTimer, &QTimer::timeout, this, &InvoiceDispatcher::checkWaiters);
+
+    m_balanceTimer = new QTimer(this);
+    m_balanceTimer->setInterval(balanceRefreshDelay);
+    m_balanceTimer->setSingleShot(true);
+    QObject::connect(m_balanceTimer, &QTimer::timeout, m_peersModel, &PeersModel::updatePeers);
+}
+
+void InvoiceDispatcher::start()
+{
+    m_running = true;
+    m_waitingForList = true;
+}
+
+void InvoiceDispatcher::stop()
+{
+    m_running = false;
+    m_waitingForList = false;
+    m_generation++;
+    m_retryTimer->stop();
+}
+
+void InvoiceDispatcher::invoicesRefreshed()
+{
+    if (!m_running || !m_waitingForList) {
+        return;
+    }
+    m_waitingForList = false;
+
+    // Anything paid since this list comes in through waitanyinvoice
+    m_lastPayIndex = m_invoicesModel->maxPayIndex();
+    sendWaitAnyInvoice();
+
+    // Paid while we weren't listening
+    checkWaiters();
+}
+
+void InvoiceDispatcher::sendWaitAnyInvoice()
+{
+    QJsonObject paramsObject;
+    paramsObject.insert("lastpay_index", m_lastPayIndex);
+
+    QJsonRpcMessage message = QJsonRpcMessage::createRequest("waitanyinvoice", paramsObject);
+    SEND_MESSAGE_CONNECT_SLOT(message, &InvoiceDispatcher::waitAnyInvoiceRequestFinished)
+    reply->setProperty("generation", m_generation);
+}
+
+void InvoiceDispatcher::retryWait()
+{
+    if (m_running && !m_waitingForList) {
+        sendWaitAnyInvoice();
+    }
+}
+
+void InvoiceDispatcher::waitAnyInvoiceRequestFinished()
+{
+    GET_MESSAGE_DISCONNECT_SLOT(message, &InvoiceDispatcher::waitAnyInvoiceRequestFinished)
+    if (!m_running || reply->property("generation").toInt() != m_generation) {
+        return;
+    }
+
+    if (message.type() != QJsonRpcMessage::Response) {
+        qDebug() << "waitanyinvoice failed:" << message.errorMessage();
+        m_retryTimer->start();
+        return;
+    }
+
+    QJsonObject invoiceObject = message.toObject().value("result").toObject();
+    QString label = invoiceObject.value("label").toString();
+    QString hash = invoiceObject.value("payment_hash").toString();
+    TRACE_INSTANT("invoice", "invoicePaid");
+
+    m_lastPayIndex = qMax(m_lastPayIndex, invoiceObject.value("pay_index").toInt());
+    // Keep the next one coming before doing anything else
+    sendWaitAnyInvoice();
+
+    m_invoicesModel->updateInvoiceFromJson(invoiceObject);
+    settle(label, hash, invoiceObject.value("status").toString());
+
+    // Money arrived over a channel, that's all that changed
+    m_balanceTimer->start();
+
+    qint64 paidAt = (qint64)invoiceObject.value("paid_at").toDouble() * 1000;
+    if (paidAt > 0) {
+        m_lastPaymentLatency = (int)qMax(Q_INT64_C(0), QDateTime::currentMSecsSinceEpoch() - paidAt);
+        m_totalPaymentLatency += m_lastPaymentLatency;
+        m_maxPaymentLatency = qMax(m_maxPaymentLatency, m_lastPaymentLatency);
+        m_paymentCount++;
+        qDebug() << "Invoice" << label << "paid, delivered after" << m_lastPaymentLatency << "ms";
+    }
+    emit statisticsChanged();
+}
+
+void InvoiceDispatcher::waitFor(const QString &label, const QString &hash)
+{
+    Invoice invoice = m_invoicesModel->findInvoice(label, hash);
+    if (!invoice.label().isEmpty() && invoice.status() != InvoiceTypes::UNPAID) {
+        emit invoiceSettled(invoice.label(), invoice.statusString());
+        return;
+    }
+
+    Waiter waiter;
+    waiter.label = label;
+    waiter.hash = hash;
+    m_waiters.append(waiter);
+
+    if (!m_expiryTimer->isActive()) {
+        m_expiryTimer->start();
+    }
+    emit statisticsChanged();
+}
+
+void InvoiceDispatcher::settle(const QString &label, const QString &hash, const QString &status)
+{
+    bool waitedFor = false;
+    for (int i = m_waiters.size() - 1; i >= 0; i--) {
+        const Waiter &waiter = m_waiters.at(i);
+        if ((!waiter.label.isEmpty() && waiter.label == label) || (!waiter.hash.isEmpty() && waiter.hash == hash)) {
+            m_waiters.removeAt(i);
+            waitedFor = true;
+        }
+    }
+
+    if (waitedFor) {
+        emit invoiceSettled(label, status);
+        emit statisticsChanged();
+    }
+
+    if (m_waiters.isEmpty()) {
+        m_expiryTimer->stop();
+    }
+}
+
+void InvoiceDispatcher::checkWaiters()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    // waitanyinvoice only tells about paid ones, expiry is up to us
+    QList<Waiter> waiters = m_waiters;
+    foreach (const Waiter &waiter, waiters) {
+        Invoice invoice = m_invoicesModel->findInvoice(waiter.label, waiter.hash);
+        if (invoice.label().isEmpty()) {
+            // Not in the model yet
+            continue;
+        }
+
+        if (invoice.status() == InvoiceTypes::PAID) {
+            settle(invoice.label(), invoice.hash(), "paid");
+        }
+        else if (invoice.status() == InvoiceTypes::EXPIRED
+                 || (invoice.expiresAtTime() > 0 && invoice.expiresAtTime() < now)) {
+            settle(invoice.label(), invoice.hash(), "expired");
+        }
+    }
+}
+
+int InvoiceDispatcher::waiterCount() const
+{
+    return m_waiters.size();
+}
+
+int InvoiceDispatcher::paymentCount() const
+{
+    return m_paymentCount;
+}
+
+int InvoiceDispatcher::lastPaymentLatency() const
+{
+    return m_lastPaymentLatency;
+}
+
+int InvoiceDispatcher::averagePaymentLatency() const
+{
+    if (m_paymentCount == 0) {
+        return 0;
+    }
+    return (int)(m_totalPaymentLatency / m_paymentCount);
+}
+
+int InvoiceDispatcher::maxPaymentLatency() const
+{
+    return m_maxPaymentLatency;
+}
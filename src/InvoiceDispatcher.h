@@ -0,0 +1,88 @@
+#ifndef INVOICEDISPATCHER_H
+#define INVOICEDISPATCHER_H
+
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+#include "RpcConnectionPool.h"
+
+class InvoicesModel;
+class PeersModel;
+
+// Keeps exactly one waitanyinvoice in flight and hands each paid invoice
+// to whoever waits for it, by label or payment hash. Only the paid row and
+// the channel balances get refreshed, not every model.
+class InvoiceDispatcher : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int waiterCount READ waiterCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int paymentCount READ paymentCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int lastPaymentLatency READ lastPaymentLatency NOTIFY statisticsChanged)
+    Q_PROPERTY(int averagePaymentLatency READ averagePaymentLatency NOTIFY statisticsChanged)
+    Q_PROPERTY(int maxPaymentLatency READ maxPaymentLatency NOTIFY statisticsChanged)
+
+public:
+    InvoiceDispatcher(RpcConnectionPool *rpcSocket, InvoicesModel *invoicesModel,
+                      PeersModel *peersModel, QObject *parent = 0);
+
+    // Starts the loop after the first full listinvoices, so we don't get
+    // walked through every invoice ever paid
+    void start();
+    void stop();
+
+    // Either may be empty. Waiters for an invoice that's already paid or
+    // expired are answered right away.
+    void waitFor(const QString &label, const QString &hash = QString());
+
+    int waiterCount() const;
+    int paymentCount() const;
+    // From paid_at to the status change being emitted (ms), paid_at only
+    // has second resolution so this is at most a second pessimistic
+    int lastPaymentLatency() const;
+    int averagePaymentLatency() const;
+    int maxPaymentLatency() const;
+
+signals:
+    void invoiceSettled(QString label, QString status);
+    void statisticsChanged();
+
+private slots:
+    void invoicesRefreshed();
+    void waitAnyInvoiceRequestFinished();
+    void retryWait();
+    void checkWaiters();
+
+private:
+    struct Waiter {
+        QString label;
+        QString hash;
+    };
+
+    void sendWaitAnyInvoice();
+    void settle(const QString &label, const QString &hash, const QString &status);
+
+    RpcConnectionPool* m_rpcSocket;
+    InvoicesModel* m_invoicesModel;
+    PeersModel* m_peersModel;
+
+    bool m_running;
+    bool m_waitingForList;
+    // Replies from before a stop() are ignored
+    int m_generation;
+    int m_lastPayIndex;
+
+    QList<Waiter> m_waiters;
+
+    int m_paymentCount;
+    int m_lastPaymentLatency;
+    qint64 m_totalPaymentLatency;
+    int m_maxPaymentLatency;
+
+    QTimer* m_retryTimer;
+    QTimer* m_expiryTimer;
+    // Several payments in a row get a single balance refresh
+    QTimer* m_balanceTimer;
+};
+
+#endif // INVOICEDISPATCHER_H
@@ -0,0 +1,206 @@
+#include <QtConcurrent>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "InvoiceHistoryStore.h"
+
+InvoiceHistoryStore::InvoiceHistoryStore(QObject *parent) : QObject(parent)
+{
+    QString historyDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(historyDirectory);
+    m_filePath = historyDirectory + "/invoice-history.jsonl";
+
+    m_searchLimit = 0;
+    m_searchPending = false;
+    QObject::connect(&m_searchWatcher, &QFutureWatcher<QVariantList>::finished,
+                     this, &InvoiceHistoryStore::searchWorkerFinished);
+
+    loadPaymentHashes();
+}
+
+InvoiceHistoryStore::~InvoiceHistoryStore()
+{
+    m_searchWatcher.waitForFinished();
+}
+
+QString InvoiceHistoryStore::filePath() const
+{
+    return m_filePath;
+}
+
+int InvoiceHistoryStore::count() const
+{
+    return m_paymentHashes.size();
+}
+
+bool InvoiceHistoryStore::contains(const QString &paymentHash) const
+{
+    return m_paymentHashes.contains(paymentHash);
+}
+
+void InvoiceHistoryStore::loadPaymentHashes()
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        QJsonObject invoiceObject = QJsonDocument::fromJson(line).object();
+        if (!invoiceObject.isEmpty()) {
+            m_paymentHashes.insert(invoiceObject.value("payment_hash").toString());
+        }
+    }
+}
+
+bool InvoiceHistoryStore::archive(const QJsonArray &invoices)
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Couldn't open invoice history" << m_filePath << file.errorString();
+        return false;
+    }
+
+    qint64 archivedAt = QDateTime::currentDateTimeUtc().toTime_t();
+    QSet<QString> added;
+    QByteArray lines;
+    foreach (const QJsonValue &v, invoices) {
+        QJsonObject invoiceObject = v.toObject();
+        QString paymentHash = invoiceObject.value("payment_hash").toString();
+        if (m_paymentHashes.contains(paymentHash) || added.contains(paymentHash)) {
+            continue;
+        }
+        invoiceObject.insert("archived_at", archivedAt);
+        lines += QJsonDocument(invoiceObject).toJson(QJsonDocument::Compact) + '\n';
+        added.insert(paymentHash);
+    }
+
+    if (lines.isEmpty()) {
+        return true;
+    }
+
+    if (file.write(lines) != lines.size() || !file.flush()) {
+        qDebug() << "Couldn't write invoice history" << m_filePath << file.errorString();
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    // The sweep deletes these from the daemon next, they have to survive a power cut
+    if (fsync(file.handle()) != 0) {
+        qDebug() << "Couldn't sync invoice history" << m_filePath;
+        return false;
+    }
+#endif
+
+    m_paymentHashes.unite(added);
+    emit countChanged();
+    return true;
+}
+
+QList<QJsonObject> InvoiceHistoryStore::read(qint64 *offset, int maxCount, const QByteArray &filter) const
+{
+    QList<QJsonObject> invoices;
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(*offset)) {
+        return invoices;
+    }
+
+    while (invoices.size() < maxCount && !file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (!line.endsWith('\n')) {
+            // Half written, leave it for next time
+            break;
+        }
+        *offset = file.pos();
+
+        if (!filter.isEmpty() && !line.contains(filter)) {
+            continue;
+        }
+        QJsonObject invoiceObject = QJsonDocument::fromJson(line).object();
+        if (!invoiceObject.isEmpty()) {
+            invoices.append(invoiceObject);
+        }
+    }
+
+    return invoices;
+}
+
+void InvoiceHistoryStore::search(QString text, int limit)
+{
+    m_searchText = text;
+    m_searchLimit = limit;
+    m_searchPending = true;
+
+    if (!m_searchWatcher.isRunning()) {
+        startSearch();
+    }
+}
+
+void InvoiceHistoryStore::startSearch()
+{
+    m_searchPending = false;
+    m_runningSearchText = m_searchText;
+    m_searchWatcher.setFuture(QtConcurrent::run(&InvoiceHistoryStore::scan, m_filePath, m_searchText, m_searchLimit));
+}
+
+void InvoiceHistoryStore::searchWorkerFinished()
+{
+    if (m_searchPending) {
+        // Typed on meanwhile, that one is outdated
+        startSearch();
+        return;
+    }
+    emit searchFinished(m_runningSearchText, m_searchWatcher.result());
+}
+
+QVariantList InvoiceHistoryStore::scan(const QString &filePath, const QString &text, int limit)
+{
+    QVariantList results;
+
+    // Appends only ever add whole lines, reading alongside them is fine
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return results;
+    }
+
+    QByteArray needle = text.toUtf8().toLower();
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (!line.endsWith('\n')) {
+            // Being appended right now
+            break;
+        }
+        // Cheap reject on the raw line before parsing it
+        if (!needle.isEmpty() && !line.toLower().contains(needle)) {
+            continue;
+        }
+
+        QJsonObject invoiceObject = QJsonDocument::fromJson(line).object();
+        if (invoiceObject.isEmpty()) {
+            continue;
+        }
+        QString label = invoiceObject.value("label").toString();
+        if (needle.isEmpty()
+                || label.contains(text, Qt::CaseInsensitive)
+                || invoiceObject.value("description").toString().contains(text, Qt::CaseInsensitive)
+                || invoiceObject.value("bolt11").toString().contains(text, Qt::CaseInsensitive)
+                || invoiceObject.value("payment_hash").toString().contains(text, Qt::CaseInsensitive)) {
+            results.prepend(invoiceObject.toVariantMap());
+            if (limit > 0 && results.size() > limit) {
+                results.removeLast();
+            }
+        }
+    }
+
+    return results;
+}
@@ -0,0 +1,65 @@
+#ifndef INVOICEHISTORYSTORE_H
+#define INVOICEHISTORYSTORE_H
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QVariantList>
+
+// Invoices that were deleted from the daemon, kept as the JSON lines
+// listinvoices gave us. Only ever appended to, searching reads it back.
+// Keyed by payment hash, the daemon hands out a label again once its
+// invoice is deleted.
+class InvoiceHistoryStore : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    InvoiceHistoryStore(QObject *parent = 0);
+    ~InvoiceHistoryStore();
+
+    QString filePath() const;
+    int count() const;
+
+    bool contains(const QString &paymentHash) const;
+    // Appends the ones not archived yet, false if they didn't reach the disk
+    bool archive(const QJsonArray &invoices);
+    // Up to maxCount archived invoices from *offset on, moving *offset past
+    // them. Lines without filter in them are skipped without parsing.
+    QList<QJsonObject> read(qint64 *offset, int maxCount, const QByteArray &filter = QByteArray()) const;
+
+public slots:
+    // Looks for archived invoices whose label, description, bolt11 or
+    // payment hash contain text on a worker, searchFinished() has them.
+    // Only the latest of the searches started meanwhile is run.
+    void search(QString text, int limit = 100);
+
+signals:
+    void countChanged();
+    // Newest first
+    void searchFinished(QString text, QVariantList results);
+
+private slots:
+    void searchWorkerFinished();
+
+private:
+    void loadPaymentHashes();
+    void startSearch();
+    static QVariantList scan(const QString &filePath, const QString &text, int limit);
+
+    QString m_filePath;
+    QSet<QString> m_paymentHashes;
+
+    QFutureWatcher<QVariantList> m_searchWatcher;
+    QString m_searchText;
+    int m_searchLimit;
+    QString m_runningSearchText;
+    bool m_searchPending;
+};
+
+#endif // INVOICEHISTORYSTORE_H
@@ -0,0 +1,296 @@
+#include <QDebug>
+
+#include <algorithm>
+#include <iterator>
+
+#include "InvoiceSearchIndex.h"
+#include "Tracer.h"
+
+// Hashes are long and rarely typed in full, their start is enough
+static const int indexedHashLength = 16;
+
+static bool shorterPostingList(const QVector<int> *a, const QVector<int> *b)
+{
+    return a->size() < b->size();
+}
+
+InvoiceSearchIndex::InvoiceSearchIndex(InvoicesModel *invoicesModel, QObject *parent) : QObject(parent)
+{
+    m_invoicesModel = invoicesModel;
+    m_liveCount = 0;
+    m_resetPending = false;
+
+    // The model lists every row again after a reset, wait for that. Also
+    // compacts, never while the model is in the middle of a change.
+    m_retireTimer = new QTimer(this);
+    m_retireTimer->setInterval(0);
+    m_retireTimer->setSingleShot(true);
+    QObject::connect(m_retireTimer, &QTimer::timeout, this, &InvoiceSearchIndex::retireMissing);
+
+    QObject::connect(m_invoicesModel, &QAbstractItemModel::rowsInserted, this, &InvoiceSearchIndex::rowsInserted);
+    QObject::connect(m_invoicesModel, &QAbstractItemModel::dataChanged, this, &InvoiceSearchIndex::rowsChanged);
+    QObject::connect(m_invoicesModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &InvoiceSearchIndex::rowsAboutToBeRemoved);
+    QObject::connect(m_invoicesModel, &QAbstractItemModel::modelReset, this, &InvoiceSearchIndex::modelReset);
+
+    indexRows(0, m_invoicesModel->rowCount() - 1);
+}
+
+QString InvoiceSearchIndex::stripHtml(const QString &html)
+{
+    if (!html.contains('<') && !html.contains('&')) {
+        return html;
+    }
+
+    QString text;
+    text.reserve(html.size());
+    bool inTag = false;
+    for (int i = 0; i < html.size(); i++) {
+        QChar c = html.at(i);
+        if (c == '<') {
+            inTag = true;
+        }
+        else if (c == '>') {
+            inTag = false;
+            // <td>a</td><td>b</td> is two words
+            text += ' ';
+        }
+        else if (!inTag) {
+            text += c;
+        }
+    }
+
+    text.replace("&nbsp;", " ");
+    text.replace("&lt;", "<");
+    text.replace("&gt;", ">");
+    text.replace("&quot;", "\"");
+    text.replace("&#39;", "'");
+    text.replace("&amp;", "&");
+    return text;
+}
+
+QByteArrayList InvoiceSearchIndex::queryWords(const QString &query)
+{
+    QByteArrayList words;
+    foreach (const QString &word, query.toLower().split(' ', QString::SkipEmptyParts)) {
+        words.append(word.toUtf8());
+    }
+    return words;
+}
+
+QByteArray InvoiceSearchIndex::documentText(int row) const
+{
+    QModelIndex index = m_invoicesModel->index(row);
+    qint64 msatoshi = m_invoicesModel->data(index, InvoicesModel::MSatoshiRole).toLongLong();
+
+    QString text = m_invoicesModel->data(index, InvoicesModel::LabelRole).toString() + ' '
+            + stripHtml(m_invoicesModel->data(index, InvoicesModel::DescriptionRole).toString()) + ' '
+            + m_invoicesModel->data(index, InvoicesModel::HashRole).toString().left(indexedHashLength) + ' '
+            + QString::number(msatoshi) + ' ' + QString::number(msatoshi / 1000);
+    return text.simplified().toLower().toUtf8();
+}
+
+quint32 InvoiceSearchIndex::trigram(const char *text)
+{
+    return ((quint32)(uchar)text[0] << 16) | ((quint32)(uchar)text[1] << 8) | (quint32)(uchar)text[2];
+}
+
+int InvoiceSearchIndex::documentCount() const
+{
+    return m_liveCount;
+}
+
+int InvoiceSearchIndex::documentId(const QString &label) const
+{
+    return m_documentIds.value(label, -1);
+}
+
+void InvoiceSearchIndex::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+    indexRows(first, last);
+}
+
+void InvoiceSearchIndex::rowsChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    indexRows(topLeft.row(), bottomRight.row());
+}
+
+void InvoiceSearchIndex::rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+    for (int row = first; row <= last; row++) {
+        int documentId = m_documentIds.value(m_invoicesModel->data(m_invoicesModel->index(row), InvoicesModel::LabelRole).toString(), -1);
+        if (documentId >= 0) {
+            retire(documentId);
+        }
+    }
+    m_retireTimer->start();
+}
+
+void InvoiceSearchIndex::modelReset()
+{
+    m_resetPending = true;
+    m_seenSinceReset.clear();
+    m_retireTimer->start();
+
+    indexRows(0, m_invoicesModel->rowCount() - 1);
+}
+
+void InvoiceSearchIndex::indexRows(int first, int last)
+{
+    for (int row = first; row <= last; row++) {
+        QString label = m_invoicesModel->data(m_invoicesModel->index(row), InvoicesModel::LabelRole).toString();
+        if (m_resetPending) {
+            m_seenSinceReset.insert(label);
+        }
+        indexInvoice(label, documentText(row));
+    }
+}
+
+void InvoiceSearchIndex::indexInvoice(const QString &label, const QByteArray &text)
+{
+    int existing = m_documentIds.value(label, -1);
+    if (existing >= 0) {
+        if (m_texts.at(existing) == text) {
+            return;
+        }
+        retire(existing);
+    }
+
+    int documentId = m_labels.size();
+    m_labels.append(label);
+    m_texts.append(text);
+    m_live.resize(documentId + 1);
+    m_live.setBit(documentId);
+    m_liveCount++;
+    m_documentIds.insert(label, documentId);
+
+    // Each trigram once, ids only ever grow so the lists stay sorted
+    QVector<quint32> trigrams;
+    trigrams.reserve(text.size());
+    for (int i = 0; i + 3 <= text.size(); i++) {
+        trigrams.append(trigram(text.constData() + i));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    foreach (quint32 t, trigrams) {
+        m_postings[t].append(documentId);
+    }
+}
+
+void InvoiceSearchIndex::retire(int documentId)
+{
+    if (!m_live.testBit(documentId)) {
+        return;
+    }
+    m_live.clearBit(documentId);
+    m_liveCount--;
+    m_texts[documentId] = QByteArray();
+    if (m_documentIds.value(m_labels.at(documentId)) == documentId) {
+        m_documentIds.remove(m_labels.at(documentId));
+    }
+}
+
+void InvoiceSearchIndex::retireMissing()
+{
+    if (m_resetPending) {
+        m_resetPending = false;
+
+        for (int documentId = 0; documentId < m_labels.size(); documentId++) {
+            if (m_live.testBit(documentId) && !m_seenSinceReset.contains(m_labels.at(documentId))) {
+                retire(documentId);
+            }
+        }
+        m_seenSinceReset.clear();
+    }
+
+    // Retired ids only cost memory and posting list length, until they
+    // outnumber the live ones
+    if (m_labels.size() - m_liveCount > qMax(1000, m_liveCount)) {
+        compact();
+    }
+}
+
+void InvoiceSearchIndex::compact()
+{
+    TRACE_SCOPE("model", "compactInvoiceSearchIndex");
+
+    QVector<QString> labels = m_labels;
+    QVector<QByteArray> texts = m_texts;
+    QBitArray live = m_live;
+
+    m_labels.clear();
+    m_texts.clear();
+    m_live.clear();
+    m_liveCount = 0;
+    m_documentIds.clear();
+    m_postings.clear();
+
+    for (int documentId = 0; documentId < labels.size(); documentId++) {
+        if (live.testBit(documentId)) {
+            indexInvoice(labels.at(documentId), texts.at(documentId));
+        }
+    }
+
+    emit changed();
+}
+
+bool InvoiceSearchIndex::matches(int documentId, const QByteArrayList &words) const
+{
+    if (documentId < 0 || documentId >= m_labels.size() || !m_live.testBit(documentId)) {
+        return false;
+    }
+    foreach (const QByteArray &word, words) {
+        if (!m_texts.at(documentId).contains(word)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QVector<int> InvoiceSearchIndex::search(const QByteArrayList &words) const
+{
+    TRACE_SCOPE("model", "searchInvoices");
+
+    // The posting lists of every trigram in the query, shortest first
+    QList<const QVector<int> *> lists;
+    foreach (const QByteArray &word, words) {
+        for (int i = 0; i + 3 <= word.size(); i++) {
+            QHash<quint32, QVector<int> >::const_iterator it = m_postings.constFind(trigram(word.constData() + i));
+            if (it == m_postings.constEnd()) {
+                return QVector<int>();
+            }
+            lists.append(&it.value());
+        }
+    }
+    std::sort(lists.begin(), lists.end(), shorterPostingList);
+
+    QVector<int> candidates;
+    if (lists.isEmpty()) {
+        // Only words shorter than a trigram, nothing narrows it down
+        candidates.reserve(m_liveCount);
+        for (int documentId = 0; documentId < m_labels.size(); documentId++) {
+            candidates.append(documentId);
+        }
+    }
+    else {
+        candidates = *lists.first();
+        for (int i = 1; i < lists.size() && !candidates.isEmpty(); i++) {
+            QVector<int> intersection;
+            std::set_intersection(candidates.constBegin(), candidates.constEnd(),
+                                  lists.at(i)->constBegin(), lists.at(i)->constEnd(),
+                                  std::back_inserter(intersection));
+            candidates = intersection;
+        }
+    }
+
+    // Trigrams can match in the wrong order or across words
+    QVector<int> results;
+    foreach (int documentId, candidates) {
+        if (matches(documentId, words)) {
+            results.append(documentId);
+        }
+    }
+    return results;
+}
@@ -0,0 +1,77 @@
+#ifndef INVOICESEARCHINDEX_H
+#define INVOICESEARCHINDEX_H
+
+#include <QBitArray>
+#include <QByteArrayList>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include "InvoicesModel.h"
+
+// Trigram index over the invoices' labels, descriptions without their
+// HTML, amounts (msat and sat) and payment hashes, kept in step with the
+// InvoicesModel. A query only touches the posting lists of its trigrams
+// and then checks the few candidates, never every invoice.
+class InvoiceSearchIndex : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int documentCount READ documentCount NOTIFY changed)
+
+public:
+    InvoiceSearchIndex(InvoicesModel *invoicesModel, QObject *parent = 0);
+
+    // Lower case words of the query, what the other calls take
+    static QByteArrayList queryWords(const QString &query);
+    // Tags dropped and the common entities decoded
+    static QString stripHtml(const QString &html);
+
+    int documentCount() const;
+    // -1 if the label isn't indexed
+    int documentId(const QString &label) const;
+    // Ids of the live documents containing every word, ascending
+    QVector<int> search(const QByteArrayList &words) const;
+    bool matches(int documentId, const QByteArrayList &words) const;
+
+signals:
+    // Ids were handed out afresh, earlier results are invalid
+    void changed();
+
+private slots:
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void modelReset();
+    void retireMissing();
+
+private:
+    QByteArray documentText(int row) const;
+    static quint32 trigram(const char *text);
+
+    void indexRows(int first, int last);
+    void indexInvoice(const QString &label, const QByteArray &text);
+    void retire(int documentId);
+    void compact();
+
+    InvoicesModel* m_invoicesModel;
+
+    // Per document id. Retired documents keep their slot, with no text,
+    // until the next compaction.
+    QVector<QString> m_labels;
+    QVector<QByteArray> m_texts;
+    QBitArray m_live;
+    int m_liveCount;
+
+    QHash<QString, int> m_documentIds;
+    // Trigram to ascending document ids, retired ones included
+    QHash<quint32, QVector<int> > m_postings;
+
+    // Labels the model listed since it was last reset
+    QSet<QString> m_seenSinceReset;
+    bool m_resetPending;
+    QTimer* m_retireTimer;
+};
+
+#endif // INVOICESEARCHINDEX_H
@@ -0,0 +1,59 @@
+#include "InvoiceSearchModel.h"
+
+InvoiceSearchModel::InvoiceSearchModel(InvoicesModel *invoicesModel, InvoiceSearchIndex *searchIndex, QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+    m_searchIndex = searchIndex;
+
+    // After the index, so it has seen new rows before they get filtered
+    setSourceModel(invoicesModel);
+
+    QObject::connect(m_searchIndex, &InvoiceSearchIndex::changed, this, &InvoiceSearchModel::runQuery);
+}
+
+QString InvoiceSearchModel::query() const
+{
+    return m_query;
+}
+
+void InvoiceSearchModel::setQuery(const QString &query)
+{
+    if (m_query == query) {
+        return;
+    }
+    m_query = query;
+    emit queryChanged();
+
+    runQuery();
+}
+
+void InvoiceSearchModel::runQuery()
+{
+    m_words = InvoiceSearchIndex::queryWords(m_query);
+
+    m_matches = QBitArray();
+    if (!m_words.isEmpty()) {
+        QVector<int> results = m_searchIndex->search(m_words);
+        m_matches.resize(results.isEmpty() ? 0 : results.last() + 1);
+        foreach (int documentId, results) {
+            m_matches.setBit(documentId);
+        }
+    }
+
+    invalidateFilter();
+}
+
+bool InvoiceSearchModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (m_words.isEmpty()) {
+        return true;
+    }
+
+    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+    int documentId = m_searchIndex->documentId(sourceModel()->data(index, InvoicesModel::LabelRole).toString());
+    if (documentId >= 0 && documentId < m_matches.size()) {
+        return m_matches.testBit(documentId);
+    }
+    // Indexed after the query ran, or beyond the last match anyway
+    return m_searchIndex->matches(documentId, m_words);
+}
@@ -0,0 +1,41 @@
+#ifndef INVOICESEARCHMODEL_H
+#define INVOICESEARCHMODEL_H
+
+#include <QBitArray>
+#include <QByteArrayList>
+#include <QSortFilterProxyModel>
+
+#include "InvoiceSearchIndex.h"
+
+// The invoices matching query, answered from the search index. Rows the
+// model adds after a query are checked against it one by one.
+class InvoiceSearchModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+
+public:
+    InvoiceSearchModel(InvoicesModel *invoicesModel, InvoiceSearchIndex *searchIndex, QObject *parent = 0);
+
+    QString query() const;
+    void setQuery(const QString &query);
+
+signals:
+    void queryChanged();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+
+private slots:
+    void runQuery();
+
+private:
+    InvoiceSearchIndex* m_searchIndex;
+
+    QString m_query;
+    QByteArrayList m_words;
+    // By document id, only as long as the index was at query time
+    QBitArray m_matches;
+};
+
+#endif // INVOICESEARCHMODEL_H
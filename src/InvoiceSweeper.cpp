@@ -0,0 +1,307 @@
+#include <QDebug>
+#include <QSettings>
+
+#include "InvoiceSweeper.h"
+#include "InvoiceHistoryStore.h"
+#include "InvoicesModel.h"
+#include "macros.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
+
+static const int scheduleCheckInterval = 10 * 60 * 1000;
+static const int deleteBatchSize = 25;
+// Gap between batches for the requests the user is waiting on
+static const int deleteBatchPause = 500;
+
+InvoiceSweeper::InvoiceSweeper(RpcConnectionPool *rpcSocket, InvoicesModel *invoicesModel,
+                               InvoiceHistoryStore *historyStore, QObject *parent) : QObject(parent)
+{
+    m_rpcSocket = rpcSocket;
+    m_invoicesModel = invoicesModel;
+    m_historyStore = historyStore;
+
+    QSettings settings;
+    m_enabled = settings.value("invoiceSweeper/enabled", true).toBool();
+    m_expiredRetentionHours = settings.value("invoiceSweeper/expiredRetentionHours", 24).toInt();
+    m_paidRetentionDays = settings.value("invoiceSweeper/paidRetentionDays", 30).toInt();
+    m_offPeakHour = settings.value("invoiceSweeper/offPeakHour", 3).toInt();
+    m_lastSweep = settings.value("invoiceSweeper/lastSweep").toDateTime();
+
+    m_running = false;
+    m_sweeping = false;
+    m_generation = 0;
+    m_maxExpiryTime = 0;
+    m_batchInFlight = 0;
+    m_archivedCount = 0;
+    m_lastArchivedCount = 0;
+
+    m_scheduleTimer = new QTimer(this);
+    m_scheduleTimer->setInterval(scheduleCheckInterval);
+    QObject::connect(m_scheduleTimer, &QTimer::timeout, this, &InvoiceSweeper::checkSchedule);
+
+    m_batchTimer = new QTimer(this);
+    m_batchTimer->setInterval(deleteBatchPause);
+    m_batchTimer->setSingleShot(true);
+    QObject::connect(m_batchTimer, &QTimer::timeout, this, &InvoiceSweeper::sendNextBatch);
+}
+
+bool InvoiceSweeper::enabled() const
+{
+    return m_enabled;
+}
+
+void InvoiceSweeper::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    QSettings().setValue("invoiceSweeper/enabled", enabled);
+    emit policyChanged();
+}
+
+int InvoiceSweeper::expiredRetentionHours() const
+{
+    return m_expiredRetentionHours;
+}
+
+void InvoiceSweeper::setExpiredRetentionHours(int expiredRetentionHours)
+{
+    if (m_expiredRetentionHours == expiredRetentionHours) {
+        return;
+    }
+    m_expiredRetentionHours = qMax(0, expiredRetentionHours);
+    QSettings().setValue("invoiceSweeper/expiredRetentionHours", m_expiredRetentionHours);
+    emit policyChanged();
+}
+
+int InvoiceSweeper::paidRetentionDays() const
+{
+    return m_paidRetentionDays;
+}
+
+void InvoiceSweeper::setPaidRetentionDays(int paidRetentionDays)
+{
+    if (m_paidRetentionDays == paidRetentionDays) {
+        return;
+    }
+    m_paidRetentionDays = qMax(0, paidRetentionDays);
+    QSettings().setValue("invoiceSweeper/paidRetentionDays", m_paidRetentionDays);
+    emit policyChanged();
+}
+
+int InvoiceSweeper::offPeakHour() const
+{
+    return m_offPeakHour;
+}
+
+void InvoiceSweeper::setOffPeakHour(int offPeakHour)
+{
+    if (m_offPeakHour == offPeakHour) {
+        return;
+    }
+    m_offPeakHour = qBound(0, offPeakHour, 23);
+    QSettings().setValue("invoiceSweeper/offPeakHour", m_offPeakHour);
+    emit policyChanged();
+}
+
+bool InvoiceSweeper::sweeping() const
+{
+    return m_sweeping;
+}
+
+QDateTime InvoiceSweeper::lastSweep() const
+{
+    return m_lastSweep;
+}
+
+int InvoiceSweeper::lastArchivedCount() const
+{
+    return m_lastArchivedCount;
+}
+
+void InvoiceSweeper::start()
+{
+    m_running = true;
+    m_scheduleTimer->start();
+    checkSchedule();
+}
+
+void InvoiceSweeper::stop()
+{
+    m_running = false;
+    m_generation++;
+    m_scheduleTimer->stop();
+    m_batchTimer->stop();
+    m_pendingLabels.clear();
+    m_batchInFlight = 0;
+
+    // Whatever was archived stays archived, the rest is picked up next time
+    if (m_sweeping) {
+        m_sweeping = false;
+        emit statisticsChanged();
+    }
+}
+
+void InvoiceSweeper::checkSchedule()
+{
+    if (!m_enabled || QTime::currentTime().hour() != m_offPeakHour) {
+        return;
+    }
+    // Once per night, the timer fires several times within the hour
+    if (m_lastSweep.isValid() && m_lastSweep.secsTo(QDateTime::currentDateTime()) < 20 * 60 * 60) {
+        return;
+    }
+    sweepNow();
+}
+
+void InvoiceSweeper::sweepNow()
+{
+    if (!m_running || m_sweeping) {
+        return;
+    }
+    m_sweeping = true;
+    m_archivedCount = 0;
+    emit statisticsChanged();
+
+    // The daemon's own copy with every field, the model's may be behind
+    QJsonRpcMessage message = QJsonRpcMessage::createRequest("listinvoices", QJsonValue());
+    SEND_MESSAGE_CONNECT_SLOT(message, &InvoiceSweeper::listInvoicesRequestFinished)
+    reply->setProperty("generation", m_generation);
+}
+
+void InvoiceSweeper::listInvoicesRequestFinished()
+{
+    GET_MESSAGE_DISCONNECT_SLOT(message, &InvoiceSweeper::listInvoicesRequestFinished)
+    if (!m_sweeping || reply->property("generation").toInt() != m_generation) {
+        return;
+    }
+
+    if (message.type() != QJsonRpcMessage::Response) {
+        qDebug() << "Invoice sweep couldn't list invoices:" << message.errorMessage();
+        finishSweep();
+        return;
+    }
+
+    qint64 now = QDateTime::currentDateTimeUtc().toTime_t();
+    m_maxExpiryTime = now - m_expiredRetentionHours * 3600;
+    qint64 maxPaidAt = now - (qint64)m_paidRetentionDays * 24 * 3600;
+
+    QJsonArray expired;
+    QJsonArray paid;
+    QJsonArray invoices = message.toObject().value("result").toObject().value("invoices").toArray();
+    foreach (const QJsonValue &v, invoices) {
+        QJsonObject invoiceObject = v.toObject();
+        QString status = invoiceObject.value("status").toString();
+        if (status == "expired" && (qint64)invoiceObject.value("expires_at").toDouble() <= m_maxExpiryTime) {
+            expired.append(invoiceObject);
+        }
+        else if (status == "paid" && (qint64)invoiceObject.value("paid_at").toDouble() <= maxPaidAt) {
+            paid.append(invoiceObject);
+        }
+    }
+
+    if (expired.isEmpty() && paid.isEmpty()) {
+        finishSweep();
+        return;
+    }
+
+    // Nothing leaves the daemon that isn't safely on disk
+    QJsonArray archive = expired;
+    foreach (const QJsonValue &v, paid) {
+        archive.append(v);
+    }
+    if (!m_historyStore->archive(archive)) {
+        finishSweep();
+        return;
+    }
+    m_archivedCount = archive.size();
+
+    foreach (const QJsonValue &v, paid) {
+        m_pendingLabels.append(v.toObject().value("label").toString());
+    }
+
+    if (expired.isEmpty()) {
+        sendNextBatch();
+        return;
+    }
+
+    // All of the expired ones go in one call
+    QJsonObject paramsObject;
+    paramsObject.insert("maxexpirytime", m_maxExpiryTime);
+
+    QJsonRpcMessage delMessage = QJsonRpcMessage::createRequest("delexpiredinvoice", paramsObject);
+    QJsonRpcServiceReply* delReply = m_rpcSocket->sendMessage(delMessage);
+    QObject::connect(delReply, &QJsonRpcServiceReply::finished, this, &InvoiceSweeper::delExpiredInvoiceRequestFinished);
+    delReply->setProperty("generation", m_generation);
+}
+
+void InvoiceSweeper::delExpiredInvoiceRequestFinished()
+{
+    GET_MESSAGE_DISCONNECT_SLOT(message, &InvoiceSweeper::delExpiredInvoiceRequestFinished)
+    if (!m_sweeping || reply->property("generation").toInt() != m_generation) {
+        return;
+    }
+
+    if (message.type() != QJsonRpcMessage::Response) {
+        qDebug() << "delexpiredinvoice failed:" << message.errorMessage();
+    }
+    sendNextBatch();
+}
+
+void InvoiceSweeper::sendNextBatch()
+{
+    if (!m_sweeping) {
+        return;
+    }
+    if (m_pendingLabels.isEmpty()) {
+        finishSweep();
+        return;
+    }
+
+    int batchSize = qMin(deleteBatchSize, m_pendingLabels.size());
+    for (int i = 0; i < batchSize; i++) {
+        QJsonObject paramsObject;
+        paramsObject.insert("label", m_pendingLabels.takeFirst());
+        paramsObject.insert("status", QString("paid"));
+
+        QJsonRpcMessage message = QJsonRpcMessage::createRequest("delinvoice", paramsObject);
+        SEND_MESSAGE_CONNECT_SLOT(message, &InvoiceSweeper::delInvoiceRequestFinished)
+        reply->setProperty("generation", m_generation);
+        m_batchInFlight++;
+    }
+}
+
+void InvoiceSweeper::delInvoiceRequestFinished()
+{
+    GET_MESSAGE_DISCONNECT_SLOT(message, &InvoiceSweeper::delInvoiceRequestFinished)
+    if (!m_sweeping || reply->property("generation").toInt() != m_generation) {
+        return;
+    }
+
+    if (message.type() != QJsonRpcMessage::Response) {
+        qDebug() << "Invoice sweep couldn't delete"
+                 << reply->request().params().toObject().value("label").toString() << message.errorMessage();
+    }
+
+    if (--m_batchInFlight == 0) {
+        m_batchTimer->start();
+    }
+}
+
+void InvoiceSweeper::finishSweep()
+{
+    m_sweeping = false;
+    m_batchInFlight = 0;
+    m_lastSweep = QDateTime::currentDateTime();
+    m_lastArchivedCount = m_archivedCount;
+    QSettings().setValue("invoiceSweeper/lastSweep", m_lastSweep);
+
+    qDebug() << "Invoice sweep archived" << m_archivedCount << "invoices";
+
+    if (m_archivedCount > 0) {
+        m_invoicesModel->updateInvoices();
+    }
+
+    emit statisticsChanged();
+    emit sweepFinished(m_archivedCount);
+}
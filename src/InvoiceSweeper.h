@@ -0,0 +1,96 @@
+#ifndef INVOICESWEEPER_H
+#define INVOICESWEEPER_H
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+#include "RpcConnectionPool.h"
+
+class InvoiceHistoryStore;
+class InvoicesModel;
+
+// Keeps the daemon's invoice list from growing forever. Once a night,
+// expired invoices and paid ones past their retention are copied into the
+// history store and then deleted from the daemon, the paid ones in small
+// batches so the node stays responsive.
+class InvoiceSweeper : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY policyChanged)
+    Q_PROPERTY(int expiredRetentionHours READ expiredRetentionHours WRITE setExpiredRetentionHours NOTIFY policyChanged)
+    Q_PROPERTY(int paidRetentionDays READ paidRetentionDays WRITE setPaidRetentionDays NOTIFY policyChanged)
+    Q_PROPERTY(int offPeakHour READ offPeakHour WRITE setOffPeakHour NOTIFY policyChanged)
+    Q_PROPERTY(bool sweeping READ sweeping NOTIFY statisticsChanged)
+    Q_PROPERTY(QDateTime lastSweep READ lastSweep NOTIFY statisticsChanged)
+    Q_PROPERTY(int lastArchivedCount READ lastArchivedCount NOTIFY statisticsChanged)
+
+public:
+    InvoiceSweeper(RpcConnectionPool *rpcSocket, InvoicesModel *invoicesModel,
+                   InvoiceHistoryStore *historyStore, QObject *parent = 0);
+
+    // Policy, kept in QSettings
+    bool enabled() const;
+    void setEnabled(bool enabled);
+    int expiredRetentionHours() const;
+    void setExpiredRetentionHours(int expiredRetentionHours);
+    int paidRetentionDays() const;
+    void setPaidRetentionDays(int paidRetentionDays);
+    // Local hour of the day at which the nightly sweep may start
+    int offPeakHour() const;
+    void setOffPeakHour(int offPeakHour);
+
+    bool sweeping() const;
+    QDateTime lastSweep() const;
+    int lastArchivedCount() const;
+
+    void start();
+    void stop();
+
+signals:
+    void policyChanged();
+    void statisticsChanged();
+    void sweepFinished(int archived);
+
+public slots:
+    // Regardless of the hour
+    void sweepNow();
+
+private slots:
+    void checkSchedule();
+    void listInvoicesRequestFinished();
+    void delExpiredInvoiceRequestFinished();
+    void delInvoiceRequestFinished();
+    void sendNextBatch();
+
+private:
+    void finishSweep();
+
+    RpcConnectionPool* m_rpcSocket;
+    InvoicesModel* m_invoicesModel;
+    InvoiceHistoryStore* m_historyStore;
+
+    bool m_enabled;
+    int m_expiredRetentionHours;
+    int m_paidRetentionDays;
+    int m_offPeakHour;
+
+    bool m_running;
+    bool m_sweeping;
+    int m_generation;
+    qint64 m_maxExpiryTime;
+    // Paid invoices still to delete
+    QStringList m_pendingLabels;
+    int m_batchInFlight;
+    int m_archivedCount;
+
+    QDateTime m_lastSweep;
+    int m_lastArchivedCount;
+
+    QTimer* m_scheduleTimer;
+    QTimer* m_batchTimer;
+};
+
+#endif // INVOICESWEEPER_H
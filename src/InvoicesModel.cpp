@@ -1,69 +1,36 @@
 #include "InvoicesModel.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
 #include "macros.h"
+#include "RpcDiagnostics.h"
+#include "Tracer.h"
 #include "LightningModel.h"
 
-InvoicesModel::InvoicesModel(QJsonRpcSocket *rpcSocket)
+static constexpr KeyedListModelField<Invoice> invoiceFields[] = {
+    KEYED_FIELD(Invoice, InvoicesModel::LabelRole, "invoicelabel", label),
+    KEYED_FIELD(Invoice, InvoicesModel::HashRole, "hash", hash),
+    KEYED_FIELD(Invoice, InvoicesModel::MSatoshiRole, "msatoshi", msatoshi),
+    KEYED_FIELD(Invoice, InvoicesModel::StatusRole, "status", status),
+    KEYED_FIELD(Invoice, InvoicesModel::StatusStringRole, "statusString", statusString),
+    KEYED_FIELD(Invoice, InvoicesModel::PayIndexRole, "payIndex", payIndex),
+    KEYED_FIELD(Invoice, InvoicesModel::MSatishiReceivedRole, "msatoshiReceived", msatoshiReceived),
+    KEYED_FIELD(Invoice, InvoicesModel::PaidTimestampRole, "paidTimestamp", paidTimestamp),
+    KEYED_FIELD(Invoice, InvoicesModel::PaidAtTimestampRole, "paidAtTimestamp", paidAtTimestamp),
+    KEYED_FIELD(Invoice, InvoicesModel::ExpiryTimeRole, "expiryTime", expiryTime),
+    KEYED_FIELD(Invoice, InvoicesModel::ExpiresAtRole, "expiresAt", expiresAtTime),
+    KEYED_FIELD(Invoice, InvoicesModel::Bolt11Role, "bolt11", bolt11),
+    KEYED_FIELD(Invoice, InvoicesModel::DescriptionRole, "description", description)
+};
+
+InvoicesModel::InvoicesModel(RpcConnectionPool *rpcSocket)
+    : KeyedListModel<Invoice, QString>(invoiceFields, &InvoicesModel::invoiceKey)
 {
     m_rpcSocket = rpcSocket;
-    m_invoices = QList<Invoice>();
-}
-
-QHash<int, QByteArray> InvoicesModel::roleNames() const
-{
-    QHash<int, QByteArray> roles;
-    roles[LabelRole] = "invoicelabel";
-    roles[HashRole] = "hash";
-    roles[MSatoshiRole] = "msatoshi";
-    roles[StatusRole] = "status";
-    roles[StatusStringRole] = "statusString";
-    roles[PayIndexRole] = "payIndex";
-    roles[MSatishiReceivedRole] = "msatoshiReceived";
-    roles[PaidTimestampRole] = "paidTimestamp";
-    roles[PaidAtTimestampRole] = "paidAtTimestamp";
-    roles[ExpiryTimeRole] = "expiryTime";
-    roles[ExpiresAtRole] = "expiresAt";
-    roles[Bolt11Role] = "bolt11";
-    return roles;
-}
-
-int InvoicesModel::rowCount(const QModelIndex &parent) const
-{
-    Q_UNUSED(parent);
-    return m_invoices.count();
-}
-
-QVariant InvoicesModel::data(const QModelIndex &index, int role) const
-{
-    if (index.row() < 0 || index.row() >= m_invoices.count())
-        return QVariant();
-
-    const Invoice &invoice = m_invoices[index.row()];
-    if (role == LabelRole)
-        return invoice.label();
-    else if (role == HashRole)
-        return invoice.hash();
-    else if (role == MSatoshiRole)
-        return invoice.msatoshi();
-    else if (role == StatusRole)
-        return invoice.status();
-    else if (role == StatusStringRole)
-        return invoice.statusString();
-    else if (role == PayIndexRole)
-        return invoice.payIndex();
-    else if (role == MSatishiReceivedRole)
-        return invoice.msatoshiReceived();
-    else if (role == PaidTimestampRole)
-        return invoice.paidTimestamp();
-    else if (role == PaidAtTimestampRole)
-        return invoice.paidAtTimestamp();
-    else if (role == ExpiryTimeRole)
-        return invoice.expiryTime();
-    else if (role == ExpiresAtRole)
-        return invoice.expiresAtTime();
-    else if (role == Bolt11Role)
-        return invoice.bolt11();
-    return QVariant();
+    m_maxPayIndex = 0;
+}
+
+QString InvoicesModel::invoiceKey(const Invoice &invoice)
+{
+    return invoice.label();
 }
 
 void InvoicesModel::updateInvoices()
@@ -75,6 +42,7 @@ void InvoicesModel::updateInvoices()
 void InvoicesModel::listInvoicesRequestFinished()
 {
     GET_MESSAGE_DISCONNECT_SLOT(message, &InvoicesModel::listInvoicesRequestFinished);
+    RpcApplyTimer applyTimer("listinvoices");
     if (message.type() == QJsonRpcMessage::Response)
     {
         QJsonObject jsonObject = message.toObject();
@@ -83,45 +51,90 @@ void InvoicesModel::listInvoicesRequestFinished()
         {
             QJsonObject resultObject = jsonObject.value("result").toObject();
             populateInvoicesFromJson(resultObject.value("invoices").toArray());
+            emit invoicesRefreshed();
         }
     }
 }
 
 void InvoicesModel::populateInvoicesFromJson(QJsonArray jsonArray)
 {
-    m_invoices.clear();
-    endResetModel();
+    TRACE_SCOPE("model", "populateInvoicesFromJson");
 
+    QVector<Invoice> invoices;
+    invoices.reserve(jsonArray.size());
+    m_maxPayIndex = 0;
     foreach (const QJsonValue &v, jsonArray)
     {
-        beginInsertRows(QModelIndex(), rowCount(), rowCount());
+        Invoice invoice = invoiceFromJson(v.toObject());
+        m_maxPayIndex = qMax(m_maxPayIndex, invoice.payIndex());
+        invoices.append(invoice);
+    }
+
+    setRecords(invoices);
+}
+
+Invoice InvoicesModel::invoiceFromJson(const QJsonObject &invoiceJsonObject)
+{
+    Invoice invoice;
+    invoice.setLabel(invoiceJsonObject.value("label").toString());
+    invoice.setHash(invoiceJsonObject.value("payment_hash").toString());
+    // Doubles are exact up to 2^53 msat, toInt() gives 0 above 21 mBTC
+    invoice.setMsatoshi((qint64)invoiceJsonObject.value("msatoshi").toDouble());
+
+    QString status = invoiceJsonObject.value("status").toString();
 
-        QJsonObject invoiceJsonObject = v.toObject();
-        Invoice invoice;
-        invoice.setLabel(invoiceJsonObject.value("label").toString());
-        invoice.setHash(invoiceJsonObject.value("payment_hash").toString());
-        invoice.setMsatoshi(invoiceJsonObject.value("msatoshi").toInt());
+    if (status.toLower() == "paid") invoice.setStatus(InvoiceTypes::InvoiceStatus::PAID);
+    else if (status.toLower() == "unpaid") invoice.setStatus(InvoiceTypes::InvoiceStatus::UNPAID);
+    else if (status.toLower() == "expired") invoice.setStatus(InvoiceTypes::InvoiceStatus::EXPIRED);
 
-        QString status = invoiceJsonObject.value("status").toString();
+    invoice.setStatusString(status);
 
-        if (status.toLower() == "paid") invoice.setStatus(InvoiceTypes::InvoiceStatus::PAID);
-        else if (status.toLower() == "unpaid") invoice.setStatus(InvoiceTypes::InvoiceStatus::UNPAID);
-        else if (status.toLower() == "expired") invoice.setStatus(InvoiceTypes::InvoiceStatus::EXPIRED);
+    invoice.setPayIndex(invoiceJsonObject.value("pay_index").toInt());
+    invoice.setMsatoshiReceived((qint64)invoiceJsonObject.value("msatoshi_received").toDouble());
+    invoice.setPaidTimestamp(invoiceJsonObject.value("paid_timestamp").toInt()); // TODO: Fix this
+    invoice.setPaidAtTimestamp(invoiceJsonObject.value("paid_at").toInt());
+    invoice.setExpiryTime(invoiceJsonObject.value("expiry_time").toInt());
+    invoice.setExpiresAtTime(invoiceJsonObject.value("expires_at").toInt());
+    invoice.setBolt11(invoiceJsonObject.value("bolt11").toString());
+    invoice.setDescription(invoiceJsonObject.value("description").toString());
+    return invoice;
+}
 
-        invoice.setStatusString(status);
+void InvoicesModel::updateInvoiceFromJson(QJsonObject invoiceJsonObject)
+{
+    Invoice invoice = invoiceFromJson(invoiceJsonObject);
 
-        invoice.setPayIndex(invoiceJsonObject.value("pay_index").toInt());
-        invoice.setMsatoshiReceived(invoiceJsonObject.value("msatoshi_received").toInt());
-        invoice.setPaidTimestamp(invoiceJsonObject.value("paid_timestamp").toInt()); // TODO: Fix this
-        invoice.setPaidAtTimestamp(invoiceJsonObject.value("paid_at").toInt());
-        invoice.setExpiryTime(invoiceJsonObject.value("expiry_time").toInt());
-        invoice.setExpiresAtTime(invoiceJsonObject.value("expires_at").toInt());
-        invoice.setBolt11(invoiceJsonObject.value("bolt11").toString());
+    int row = rowOfKey(invoice.label());
+    if (row >= 0) {
+        // waitanyinvoice leaves out what didn't change
+        if (invoice.bolt11().isEmpty()) {
+            invoice.setBolt11(records().at(row).bolt11());
+        }
+        if (invoice.description().isEmpty()) {
+            invoice.setDescription(records().at(row).description());
+        }
+    }
+    upsertRecord(invoice);
+}
 
-        m_invoices.append(invoice);
+Invoice InvoicesModel::findInvoice(const QString &label, const QString &hash) const
+{
+    if (!label.isEmpty()) {
+        int row = rowOfKey(label);
+        return row >= 0 ? records().at(row) : Invoice();
+    }
 
-        endInsertRows();
+    foreach (const Invoice &invoice, records()) {
+        if (invoice.hash() == hash) {
+            return invoice;
+        }
     }
+    return Invoice();
+}
+
+int InvoicesModel::maxPayIndex() const
+{
+    return m_maxPayIndex;
 }
 
 void InvoicesModel::addInvoice(QString label, QString description, QString amountInMsatoshi, int expiryInSeconds)
@@ -139,9 +152,12 @@ void InvoicesModel::addInvoice(QString label, QString description, QString amoun
 void InvoicesModel::addInvoiceRequestFinished()
 {
     GET_MESSAGE_DISCONNECT_SLOT(message, &InvoicesModel::addInvoiceRequestFinished)
+    QString label = reply->request().params().toObject().value("label").toString();
     if (message.type() == QJsonRpcMessage::Error)
     {
-        emit errorString(message.toObject().value("error").toObject().value("message").toString());
+        QString error = message.toObject().value("error").toObject().value("message").toString();
+        emit errorString(error);
+        emit invoiceCreationFailed(label, error);
     }
 
     if (message.type() == QJsonRpcMessage::Response)
@@ -152,56 +168,26 @@ void InvoicesModel::addInvoiceRequestFinished()
 
         if (bolt11.length() > 0)
         {
-            updateInvoices();
-            emit invoiceAdded(bolt11);
-        }
+            // The reply and the request have the whole row, no need to list
+            // every invoice again for it
+            QJsonObject paramsObject = reply->request().params().toObject();
+            QJsonObject invoiceJsonObject = jsonObject.value("result").toObject();
+            invoiceJsonObject.insert("label", label);
+            invoiceJsonObject.insert("description", paramsObject.value("description"));
+            invoiceJsonObject.insert("msatoshi", paramsObject.value("msatoshi").toString().toDouble());
+            invoiceJsonObject.insert("status", QString("unpaid"));
+            updateInvoiceFromJson(invoiceJsonObject);
 
-        if (jsonObject.contains("result"))
-        {
-            QJsonObject resultObject = jsonObject.value("result").toObject();
-            if (resultObject.contains("id"))
-            {
-                // TODO: notify GUI that we've connected
-                updateInvoices();
-            }
+            emit invoiceAdded(bolt11);
+            emit invoiceCreated(label, bolt11);
         }
     }
 }
 
 void InvoicesModel::waitInvoice(QString label)
 {
-    QJsonObject paramsObject;
-    paramsObject.insert("label", label);
-
-    QJsonRpcMessage message = QJsonRpcMessage::createRequest("waitinvoice", paramsObject);
-    SEND_MESSAGE_CONNECT_SLOT(message, &InvoicesModel::waitInvoiceRequestFinished)
-}
-
-void InvoicesModel::waitInvoiceRequestFinished()
-{
-    GET_MESSAGE_DISCONNECT_SLOT(message, &InvoicesModel::waitInvoiceRequestFinished)
-    if (message.type() == QJsonRpcMessage::Error)
-    {
-        emit errorString(message.toObject().value("error").toObject().value("message").toString());
-    }
-
-    if (message.type() == QJsonRpcMessage::Response)
-    {
-        QJsonObject jsonObject = message.toObject();
-
-        if (jsonObject.contains("result"))
-        {
-            QJsonObject resultObject = jsonObject.value("result").toObject();
-            if (resultObject.contains("status"))
-            {
-                // Update the balance and everything else
-                LightningModel::instance()->updateModels();
-                //updateInvoices();
-                emit (invoiceStatusChanged(resultObject.value("label").toString(),
-                                           resultObject.value("status").toString()));
-            }
-        }
-    }
+    // One waitanyinvoice for all of them instead of a waitinvoice each
+    LightningModel::instance()->invoiceDispatcher()->waitFor(label);
 }
 
 void InvoicesModel::deleteInvoice(QString label, QString status)
@@ -229,13 +215,23 @@ void InvoicesModel::deleteInvoiceRequestFinished()
 
         if (jsonObject.contains("result"))
         {
-            updateInvoices();
+            // No need to list them all again for one row
+            removeRecord(reply->request().params().toObject().value("label").toString());
         }
     }
 }
 
 Invoice::Invoice()
-{}
+{
+    m_msatoshi = 0;
+    m_status = InvoiceTypes::UNPAID;
+    m_payIndex = 0;
+    m_msatoshiReceived = 0;
+    m_paidTimestamp = 0;
+    m_paidAtTimestamp = 0;
+    m_expiryTime = 0;
+    m_expiresAtTime = 0;
+}
 
 QString Invoice::label() const
 {
@@ -257,12 +253,12 @@ void Invoice::setHash(const QString &hash)
     m_hash = hash;
 }
 
-int Invoice::msatoshi() const
+qint64 Invoice::msatoshi() const
 {
     return m_msatoshi;
 }
 
-void Invoice::setMsatoshi(int msatoshi)
+void Invoice::setMsatoshi(qint64 msatoshi)
 {
     m_msatoshi = msatoshi;
 }
@@ -287,12 +283,12 @@ void Invoice::setPayIndex(int payIndex)
     m_payIndex = payIndex;
 }
 
-int Invoice::msatoshiReceived() const
+qint64 Invoice::msatoshiReceived() const
 {
     return m_msatoshiReceived;
 }
 
-void Invoice::setMsatoshiReceived(int msatoshiReceived)
+void Invoice::setMsatoshiReceived(qint64 msatoshiReceived)
 {
     m_msatoshiReceived = msatoshiReceived;
 }
@@ -356,3 +352,13 @@ void Invoice::setStatusString(const QString &statusString)
 {
     m_statusString = statusString;
 }
+
+QString Invoice::description() const
+{
+    return m_description;
+}
+
+void Invoice::setDescription(const QString &description)
+{
+    m_description = description;
+}
@@ -4,7 +4,8 @@
 #include <QObject>
 #include <QAbstractItemModel>
 
-#include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
+#include "KeyedListModel.h"
+#include "RpcConnectionPool.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
 
 namespace InvoiceTypes
@@ -29,8 +30,8 @@ public:
     QString hash() const;
     void setHash(const QString &hash);
 
-    int msatoshi() const;
-    void setMsatoshi(int msatoshi);
+    qint64 msatoshi() const;
+    void setMsatoshi(qint64 msatoshi);
 
     InvoiceTypes::InvoiceStatus status() const;
     void setStatus(const InvoiceTypes::InvoiceStatus &status);
@@ -38,8 +39,8 @@ public:
     int payIndex() const;
     void setPayIndex(int payIndex);
 
-    int msatoshiReceived() const;
-    void setMsatoshiReceived(int msatoshiReceived);
+    qint64 msatoshiReceived() const;
+    void setMsatoshiReceived(qint64 msatoshiReceived);
 
     int paidTimestamp() const;
     void setPaidTimestamp(int paidTimestamp);
@@ -56,25 +57,29 @@ public:
     QString bolt11() const;
     void setBolt11(const QString &bolt11);
 
+    QString description() const;
+    void setDescription(const QString &description);
+
     QString statusString() const;
     void setStatusString(const QString &statusString);
 
 private:
     QString m_label;
     QString m_hash;
-    int m_msatoshi;
+    qint64 m_msatoshi;
     InvoiceTypes::InvoiceStatus m_status;
     QString m_statusString;
     int m_payIndex;
-    int m_msatoshiReceived;
+    qint64 m_msatoshiReceived;
     int m_paidTimestamp;
     int m_paidAtTimestamp;
     int m_expiryTime;
     int m_expiresAtTime;
     QString m_bolt11;
+    QString m_description;
 };
 
-class InvoicesModel : public QAbstractListModel
+class InvoicesModel : public KeyedListModel<Invoice, QString>
 {
     Q_OBJECT
 public:
@@ -90,39 +95,49 @@ public:
         PaidAtTimestampRole,
         ExpiryTimeRole,
         ExpiresAtRole,
-        Bolt11Role
+        Bolt11Role,
+        DescriptionRole
     };
 
-    InvoicesModel(QJsonRpcSocket* rpcSocket = 0);
-
-    QHash<int, QByteArray> roleNames() const;
-
-    int rowCount(const QModelIndex & parent = QModelIndex()) const;
-    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    InvoicesModel(RpcConnectionPool* rpcSocket = 0);
 
     void updateInvoices();
 
+    // Replaces the row with the same label, or adds one
+    void updateInvoiceFromJson(QJsonObject invoiceJsonObject);
+    // By label, or by hash if label is empty. An empty label if there is none.
+    Invoice findInvoice(const QString &label, const QString &hash = QString()) const;
+    // Highest pay_index of the last full list
+    int maxPayIndex() const;
+
 signals:
     void errorString(QString error);
     void invoiceAdded(QString bolt11);
+    void invoiceCreated(QString label, QString bolt11);
+    void invoiceCreationFailed(QString label, QString error);
     void invoiceStatusChanged(QString label, QString status);
+    // A full listinvoices from the daemon was applied
+    void invoicesRefreshed();
 
 private slots:
     void listInvoicesRequestFinished();
     void addInvoiceRequestFinished();
-    void waitInvoiceRequestFinished();
     void deleteInvoiceRequestFinished();
 
-private:
+public:
     void populateInvoicesFromJson(QJsonArray jsonArray);
 
 private:
-    QList<Invoice> m_invoices;
-    QJsonRpcSocket* m_rpcSocket;
+    static Invoice invoiceFromJson(const QJsonObject &invoiceJsonObject);
+    static QString invoiceKey(const Invoice &invoice);
+
+    RpcConnectionPool* m_rpcSocket;
+    int m_maxPayIndex;
 
 public slots:
     void addInvoice(QString label, QString description, QString amountInMsatoshi, int expiryInSeconds);
     void deleteInvoice(QString label, QString status);
+    // invoiceStatusChanged() once it is paid or expired
     void waitInvoice(QString label);
 };
 
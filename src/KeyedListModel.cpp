@@ -0,0 +1,31 @@
+#include "KeyedListModel.h"
+
+KeyedListModelBase::KeyedListModelBase(QObject *parent) : QAbstractListModel(parent)
+{
+    m_changedFirst = -1;
+    m_changedLast = -1;
+}
+
+void KeyedListModelBase::rowChanged(int row, const QVector<int> &roles)
+{
+    if (m_changedFirst >= 0 && row == m_changedLast + 1 && roles == m_changedRoles) {
+        m_changedLast = row;
+        return;
+    }
+
+    flushChangedRows();
+    m_changedFirst = row;
+    m_changedLast = row;
+    m_changedRoles = roles;
+}
+
+void KeyedListModelBase::flushChangedRows()
+{
+    if (m_changedFirst < 0) {
+        return;
+    }
+
+    emit dataChanged(index(m_changedFirst), index(m_changedLast), m_changedRoles);
+    m_changedFirst = -1;
+    m_changedLast = -1;
+}
@@ -0,0 +1,317 @@
+#ifndef KEYEDLISTMODEL_H
+#define KEYEDLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QVector>
+
+#include <type_traits>
+#include <utility>
+
+// One role of a record: its number, its name in QML and how to read it.
+// Tables of these are constexpr, see KEYED_FIELD.
+template <typename Record>
+struct KeyedListModelField
+{
+    int role;
+    const char *name;
+    QVariant (*value)(const Record &record);
+};
+
+// Enums go to QML as their int, like data() always returned them
+template <typename T>
+typename std::enable_if<!std::is_enum<T>::value, QVariant>::type keyedFieldVariant(const T &value)
+{
+    return QVariant::fromValue(value);
+}
+
+template <typename T>
+typename std::enable_if<std::is_enum<T>::value, QVariant>::type keyedFieldVariant(const T &value)
+{
+    return QVariant((int)value);
+}
+
+template <typename Record, typename T, T (Record::*Getter)() const>
+QVariant keyedFieldValue(const Record &record)
+{
+    return keyedFieldVariant((record.*Getter)());
+}
+
+#define KEYED_FIELD(Record, role, name, getter) \
+    { role, name, &keyedFieldValue<Record, decltype(std::declval<const Record &>().getter()), &Record::getter> }
+
+// What doesn't depend on the record type
+class KeyedListModelBase : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    KeyedListModelBase(QObject *parent = 0);
+
+protected:
+    // Adjacent rows with the same changed roles go out as one dataChanged
+    void rowChanged(int row, const QVector<int> &roles);
+    void flushChangedRows();
+
+private:
+    int m_changedFirst;
+    int m_changedLast;
+    QVector<int> m_changedRoles;
+};
+
+// A list model of records with a unique key. The roles come from a field
+// table, and a fresh list from the daemon is merged in by key: vanished
+// rows are removed and new ones inserted in ranges, and rows that stayed
+// only report the roles whose values changed. Only a reordering falls
+// back to a reset.
+template <typename Record, typename Key>
+class KeyedListModel : public KeyedListModelBase
+{
+public:
+    typedef KeyedListModelField<Record> Field;
+    typedef Key (*KeyFunction)(const Record &record);
+
+    template <std::size_t FieldCount>
+    KeyedListModel(const Field (&fields)[FieldCount], KeyFunction keyOf, QObject *parent = 0)
+        : KeyedListModelBase(parent)
+    {
+        m_fields = fields;
+        m_fieldCount = (int)FieldCount;
+        m_keyOf = keyOf;
+        m_keyIndexValid = true;
+    }
+
+    QHash<int, QByteArray> roleNames() const
+    {
+        QHash<int, QByteArray> roles;
+        for (int i = 0; i < m_fieldCount; i++) {
+            roles[m_fields[i].role] = m_fields[i].name;
+        }
+        return roles;
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const
+    {
+        Q_UNUSED(parent);
+        return m_records.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const
+    {
+        if (index.row() < 0 || index.row() >= m_records.size())
+            return QVariant();
+
+        const Field *f = field(role);
+        if (!f)
+            return QVariant();
+        return f->value(m_records.at(index.row()));
+    }
+
+    const QVector<Record> &records() const
+    {
+        return m_records;
+    }
+
+    // -1 if there is none
+    int rowOfKey(const Key &key) const
+    {
+        if (!m_keyIndexValid) {
+            m_keyIndex.clear();
+            m_keyIndex.reserve(m_records.size());
+            for (int row = 0; row < m_records.size(); row++) {
+                m_keyIndex.insert(m_keyOf(m_records.at(row)), row);
+            }
+            m_keyIndexValid = true;
+        }
+        return m_keyIndex.value(key, -1);
+    }
+
+protected:
+    void setRecords(const QVector<Record> &records)
+    {
+        QHash<Key, int> newRows;
+        newRows.reserve(records.size());
+        for (int i = 0; i < records.size(); i++) {
+            newRows.insert(m_keyOf(records.at(i)), i);
+        }
+        if (newRows.size() != records.size()) {
+            // Duplicate keys, nothing to match rows by
+            resetRecords(records);
+            return;
+        }
+
+        // Vanished rows, in runs from the back so the row numbers hold
+        int last = -1;
+        for (int row = m_records.size() - 1; row >= -1; row--) {
+            if (row >= 0 && !newRows.contains(m_keyOf(m_records.at(row)))) {
+                if (last < 0) {
+                    last = row;
+                }
+                continue;
+            }
+            if (last >= 0) {
+                removeRecordRange(row + 1, last);
+                last = -1;
+            }
+        }
+
+        // Moves aren't worth tracking, the daemon lists in a stable order
+        int previous = -1;
+        for (int row = 0; row < m_records.size(); row++) {
+            int position = newRows.value(m_keyOf(m_records.at(row)));
+            if (position < previous) {
+                resetRecords(records);
+                return;
+            }
+            previous = position;
+        }
+
+        int row = 0;
+        int i = 0;
+        while (i < records.size()) {
+            if (row < m_records.size() && m_keyOf(m_records.at(row)) == m_keyOf(records.at(i))) {
+                replaceRecord(row, records.at(i));
+                row++;
+                i++;
+                continue;
+            }
+
+            // New ones up to the next row we already have
+            int end = i + 1;
+            if (row < m_records.size()) {
+                Key nextKey = m_keyOf(m_records.at(row));
+                while (end < records.size() && !(m_keyOf(records.at(end)) == nextKey)) {
+                    end++;
+                }
+            }
+            else {
+                end = records.size();
+            }
+
+            flushChangedRows();
+            beginInsertRows(QModelIndex(), row, row + end - i - 1);
+            m_records.insert(row, end - i, Record());
+            for (int j = i; j < end; j++) {
+                m_records[row + j - i] = records.at(j);
+                recordAdded(records.at(j));
+            }
+            m_keyIndexValid = false;
+            endInsertRows();
+
+            row += end - i;
+            i = end;
+        }
+
+        flushChangedRows();
+    }
+
+    // Replaces the record with the same key, or appends it
+    void upsertRecord(const Record &record)
+    {
+        int row = rowOfKey(m_keyOf(record));
+        if (row >= 0) {
+            replaceRecord(row, record);
+            flushChangedRows();
+            return;
+        }
+
+        beginInsertRows(QModelIndex(), m_records.size(), m_records.size());
+        m_records.append(record);
+        m_keyIndex.insert(m_keyOf(record), m_records.size() - 1);
+        recordAdded(record);
+        endInsertRows();
+    }
+
+    bool removeRecord(const Key &key)
+    {
+        int row = rowOfKey(key);
+        if (row < 0) {
+            return false;
+        }
+        removeRecordRange(row, row);
+        return true;
+    }
+
+    // Every record entering or leaving the model, for running totals. A
+    // changed record leaves before its replacement enters.
+    virtual void recordAdded(const Record &record)
+    {
+        Q_UNUSED(record);
+    }
+
+    virtual void recordRemoved(const Record &record)
+    {
+        Q_UNUSED(record);
+    }
+
+private:
+    const Field *field(int role) const
+    {
+        // Roles are usually numbered in table order
+        int i = role - m_fields[0].role;
+        if (i >= 0 && i < m_fieldCount && m_fields[i].role == role) {
+            return &m_fields[i];
+        }
+        for (i = 0; i < m_fieldCount; i++) {
+            if (m_fields[i].role == role) {
+                return &m_fields[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void replaceRecord(int row, const Record &record)
+    {
+        QVector<int> roles;
+        for (int i = 0; i < m_fieldCount; i++) {
+            if (m_fields[i].value(m_records.at(row)) != m_fields[i].value(record)) {
+                roles.append(m_fields[i].role);
+            }
+        }
+        if (roles.isEmpty()) {
+            return;
+        }
+
+        recordRemoved(m_records.at(row));
+        m_records[row] = record;
+        recordAdded(record);
+        rowChanged(row, roles);
+    }
+
+    void removeRecordRange(int first, int last)
+    {
+        flushChangedRows();
+        beginRemoveRows(QModelIndex(), first, last);
+        for (int row = first; row <= last; row++) {
+            recordRemoved(m_records.at(row));
+        }
+        m_records.remove(first, last - first + 1);
+        m_keyIndexValid = false;
+        endRemoveRows();
+    }
+
+    void resetRecords(const QVector<Record> &records)
+    {
+        flushChangedRows();
+        beginResetModel();
+        foreach (const Record &record, m_records) {
+            recordRemoved(record);
+        }
+        m_records = records;
+        foreach (const Record &record, m_records) {
+            recordAdded(record);
+        }
+        m_keyIndexValid = false;
+        endResetModel();
+    }
+
+    const Field *m_fields;
+    int m_fieldCount;
+    KeyFunction m_keyOf;
+
+    QVector<Record> m_records;
+    mutable QHash<Key, int> m_keyIndex;
+    mutable bool m_keyIndexValid;
+};
+
+#endif // KEYEDLISTMODEL_H
@@ -1,8 +1,15 @@
+#include <QtConcurrent>
 #include <QDir>
+#include <QFileInfo>
+#include <QMetaEnum>
 #include <QSettings>
 
 #include "LightningModel.h"
+#include "DaemonInstaller.h"
 #include "macros.h"
+#include "RpcDiagnostics.h"
+#include "SnapshotCache.h"
+#include "Tracer.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
 
 #ifdef Q_OS_ANDROID
@@ -13,6 +20,21 @@
 
 LightningModel *LightningModel::sInstance = 0;
 
+// Runs on a worker, hashing the binaries takes a while on a phone
+static bool installDaemon(QString sourceDirectory, QString installDirectory)
+{
+    // Only touches binaries that changed since the last start
+    DaemonInstaller installer(sourceDirectory, installDirectory);
+    installer.setBinaries(QStringList() << "lightning_channeld"
+                                        << "lightning_closingd"
+                                        << "lightning_gossipd"
+                                        << "lightning_hsmd"
+                                        << "lightning_onchaind"
+                                        << "lightning_openingd"
+                                        << "lightningd");
+    return installer.install();
+}
+
 PeersModel *LightningModel::peersModel() const
 {
     return m_peersModel;
@@ -77,29 +99,41 @@ void LightningModel::launchDaemon()
     QDir programDir = QDir::home();
     programDir.cdUp();
 
-    if (m_firstStart) {
-        QStringList lightningBinaries;
-
-        lightningBinaries << "lightning_channeld"
-                          << "lightning_closingd"
-                          << "lightning_gossipd"
-                          << "lightning_hsmd"
-                          << "lightning_onchaind"
-                          << "lightning_openingd"
-                          << "lightningd";
+    if (m_installWatcher.isRunning()) {
+        return;
+    }
+    setStartupPhase(InstallingDaemon);
 
-        foreach (QString binaryName, lightningBinaries) {
-            QFile::copy(programDir.absolutePath() + "/lib/lib" + binaryName + ".so",
-                        cLightningDir.absolutePath() + "/" + binaryName);
-        }
+    // Carries on in daemonInstalled, the UI stays responsive meanwhile
+    m_installWatcher.setFuture(QtConcurrent::run(installDaemon, programDir.absolutePath() + "/lib",
+                                                 cLightningDir.absolutePath()));
+#else
+    startDaemonProcess();
+#endif
+}
 
-        m_firstStart = false;
+void LightningModel::daemonInstalled()
+{
+    if (!m_installWatcher.result()) {
+        emit errorString("Couldn't install the lightning daemon");
     }
+    startDaemonProcess();
+}
 
-    QString program = cLightningDir.absolutePath() + "/lightningd";
+void LightningModel::startDaemonProcess()
+{
+#ifdef Q_OS_ANDROID
+    QDir programDir = QDir::home();
+    programDir.cdUp();
+
+    setStartupPhase(LaunchingDaemon);
+
+    QString program = QDir::homePath() + "/libexec/c-lightning/lightningd";
 #else
     QDir programDir = QDir::home();
     QString program = programDir.absolutePath() + "/Code/mine/lightning/lightningd/lightningd"; // Hardcode some location within a snap?
+
+    setStartupPhase(LaunchingDaemon);
 #endif
 
     qDebug() << "Starting: " << program;
@@ -144,16 +178,30 @@ void LightningModel::launchDaemon()
 
     qDebug() << "Arguments: " << arguments;
 
+    // Carries on in lightningProcessStarted or lightningProcessError
     m_lightningDaemonProcess->start(program, arguments);
-    if (m_lightningDaemonProcess->waitForStarted())
-    {
-        qDebug()<<"Daemon started";
-        retryRpcConnection();
-    }
-    else
+}
+
+void LightningModel::lightningProcessStarted()
+{
+    qDebug()<<"Daemon started";
+    setStartupPhase(WaitingForRpcSocket);
+    watchRpcSocket();
+
+    // The watcher tells us when the socket shows up,
+    // this is only a fallback for filesystems it can't see
+    m_connectionRetryTimer->start();
+    retryRpcConnection();
+}
+
+void LightningModel::lightningProcessError(QProcess::ProcessError processError)
+{
+    if (processError == QProcess::FailedToStart)
     {
-        qDebug() << "Couldn't start daemon: " << m_lightningDaemonProcess->error();
+        qDebug() << "Couldn't start daemon: " << processError;
         setConnectedToDaemon(false);
+        m_daemonSupervisor->stop();
+        setStartupPhase(Failed);
     }
 }
 
@@ -176,6 +224,7 @@ void LightningModel::updateInfo()
 void LightningModel::updateInfoRequestFinished()
 {
     GET_MESSAGE_DISCONNECT_SLOT(message, &LightningModel::updateInfoRequestFinished)
+    RpcApplyTimer applyTimer("getinfo");
     if (message.type() == QJsonRpcMessage::Error)
     {
         //emit errorString(message.toObject().value("error").toObject().value("message").toString());
@@ -183,34 +232,71 @@ void LightningModel::updateInfoRequestFinished()
 
     if (message.type() == QJsonRpcMessage::Response)
     {
-        QJsonObject resultsObject = message.toObject().value("result").toObject();
+        populateInfoFromJson(message.toObject().value("result").toObject());
+    }
+}
+
+void LightningModel::populateInfoFromJson(QJsonObject resultsObject)
+{
+    QJsonArray addressesArray = resultsObject.value("address").toArray();
 
-        QJsonArray addressesArray = resultsObject.value("address").toArray();
 
+    m_address = addressesArray[0].toObject().value("address").toString();
+    m_blockheight = resultsObject.value("blockheight").toInt();
+    setId(resultsObject.value("id").toString());
+    m_network = resultsObject.value("network").toString();
+    m_port = resultsObject.value("port").toInt();
+    m_version = resultsObject.value("version").toString();
 
-        m_address = addressesArray[0].toObject().value("address").toString();
-        m_blockheight = resultsObject.value("blockheight").toInt();
-        setId(resultsObject.value("id").toString());
-        m_network = resultsObject.value("network").toString();
-        m_port = resultsObject.value("port").toInt();
-        m_version = resultsObject.value("version").toString();
+    emit infoChanged();
+}
 
-        emit infoChanged();
+void LightningModel::applySnapshot()
+{
+    SnapshotCache *snapshotCache = SnapshotCache::instance();
+    if (!snapshotCache || !snapshotCache->load()) {
+        return;
     }
+
+    TRACE_SCOPE("startup", "applySnapshot");
+
+    // The daemon's answers replace all of this as they come in
+    QJsonObject infoObject = snapshotCache->result("getinfo");
+    if (!infoObject.isEmpty()) {
+        populateInfoFromJson(infoObject);
+    }
+    m_paymentsModel->populatePaymentsFromJson(snapshotCache->result("listpayments").value("payments").toArray());
+    m_walletModel->populateFundsFromJson(snapshotCache->result("listfunds").value("outputs").toArray());
+    m_invoicesModel->populateInvoicesFromJson(snapshotCache->result("listinvoices").value("invoices").toArray());
+    m_peersModel->populatePeersFromJson(snapshotCache->result("listpeers").value("peers").toArray());
+    m_nodesModel->populateNodesFromJson(snapshotCache->result("listnodes").value("nodes").toArray());
 }
 
 void LightningModel::lightningProcessFinished(int exitCode)
 {
     qDebug() << "Lightning daemon finished, exit code: " << exitCode;
-    //qDebug() << m_lightningDaemonProcess->readAllStandardOutput();
-    QString stdError = m_lightningDaemonProcess->readAllStandardError();
-    if (stdError.contains("Could not locate RPC credentials")) {
+    // Pick up whatever was written after the last readyRead
+    m_daemonLogModel->drain();
+    QString stdError = m_daemonLogModel->standardErrorTail();
+    m_credentialsError = stdError.contains("Could not locate RPC credentials");
+    if (m_credentialsError) {
         emit errorString("Wrong RPC Credentials"); // Fixme: handle this properly
         emit rpcConnectionError();
     }
-    qDebug() << stdError;
-    m_lightningDaemonProcess->deleteLater();
     setConnectedToDaemon(false);
+
+    m_connectionRetryTimer->stop();
+    m_updatesTimer->stop();
+
+    // The process object gets reused for the restart, the models keep
+    // their last state so the UI doesn't empty out in the meantime
+    if (m_credentialsError) {
+        m_daemonSupervisor->daemonExited(false);
+        setStartupPhase(Failed);
+    }
+    else {
+        m_daemonSupervisor->daemonExited(true);
+    }
 }
 
 LightningModel::LightningModel(QString serverName, QObject *parent) {
@@ -230,19 +316,28 @@ LightningModel::LightningModel(QString serverName, QObject *parent) {
             m_lightningRpcSocket = serverName;
         }
 
-        m_firstStart = true;
-
         QSettings settings;
 
         m_bitcoinRpcServerName = settings.value("nodeAddress").toString();
         m_bitcoinRpcUser = settings.value("nodeRpcUsername").toString();
         m_bitcoinRpcPassword = settings.value("nodeRpcPassword").toString();
 
+        m_credentialsError = false;
         m_lightningDaemonProcess = new QProcess(this);
+        m_daemonLogModel = new DaemonLogModel(2000, this);
+        m_daemonLogModel->attachProcess(m_lightningDaemonProcess);
         QObject::connect(m_lightningDaemonProcess, SIGNAL(finished(int)),
                          this, SLOT(lightningProcessFinished(int)));
+        QObject::connect(m_lightningDaemonProcess, &QProcess::started,
+                         this, &LightningModel::lightningProcessStarted);
+        QObject::connect(m_lightningDaemonProcess, &QProcess::errorOccurred,
+                         this, &LightningModel::lightningProcessError);
+        QObject::connect(&m_installWatcher, &QFutureWatcher<bool>::finished,
+                         this, &LightningModel::daemonInstalled);
 
-        setConnectedToDaemon(false);
+        m_connectedToDaemon = false;
+        m_startupPhase = NotStarted;
+        m_startupTimer.start();
 
         m_address = QString();
         m_blockheight = 0;
@@ -251,11 +346,30 @@ LightningModel::LightningModel(QString serverName, QObject *parent) {
         m_port = 0;
         m_version = QString();
 
-        m_connectionRetryTimer = new QTimer();
+        m_connectionRetryTimer = new QTimer(this);
+        m_connectionRetryTimer->setInterval(5000);
         QObject::connect(m_connectionRetryTimer, &QTimer::timeout, this, &LightningModel::retryRpcConnection);
 
-        m_unixSocket = new QLocalSocket();
-        m_rpcSocket = new QJsonRpcSocket(m_unixSocket);
+        // Usually, if we wait longer than 5 secs there is something wrong
+        // with an already running daemon
+        m_connectionTimeoutTimer = new QTimer(this);
+        m_connectionTimeoutTimer->setInterval(5000);
+        m_connectionTimeoutTimer->setSingleShot(true);
+        QObject::connect(m_connectionTimeoutTimer, &QTimer::timeout, this, &LightningModel::connectionTimedOut);
+
+        m_rpcSocketWatcher = new QFileSystemWatcher(this);
+        QObject::connect(m_rpcSocketWatcher, &QFileSystemWatcher::directoryChanged,
+                         this, &LightningModel::rpcSocketDirectoryChanged);
+
+        m_updatesTimer = new QTimer(this);
+        // Update the models every 15 secs
+        m_updatesTimer->setInterval(15000);
+        m_updatesTimer->setSingleShot(false);
+        QObject::connect(m_updatesTimer, &QTimer::timeout, this, &LightningModel::updateModels);
+
+        // Slow calls like pay get their own connections
+        m_rpcSocket = new RpcConnectionPool(2, this);
+        m_unixSocket = m_rpcSocket->primarySocket();
 
         m_peersModel = new PeersModel(m_rpcSocket);
         m_paymentsModel = new PaymentsModel(m_rpcSocket);
@@ -264,28 +378,39 @@ LightningModel::LightningModel(QString serverName, QObject *parent) {
 
         m_nodesModel = new NodesModel(m_rpcSocket);
 
+        m_invoiceDispatcher = new InvoiceDispatcher(m_rpcSocket, m_invoicesModel, m_peersModel, this);
+        QObject::connect(m_invoiceDispatcher, &InvoiceDispatcher::invoiceSettled,
+                         m_invoicesModel, &InvoicesModel::invoiceStatusChanged);
+
+        m_bulkInvoiceGenerator = new BulkInvoiceGenerator(m_rpcSocket, m_invoicesModel, this);
+
+        m_invoiceHistoryStore = new InvoiceHistoryStore(this);
+        m_invoiceSweeper = new InvoiceSweeper(m_rpcSocket, m_invoicesModel, m_invoiceHistoryStore, this);
+        m_revenueAggregator = new RevenueAggregator(m_invoicesModel, m_paymentsModel, m_invoiceHistoryStore, this);
+        m_invoiceSearchIndex = new InvoiceSearchIndex(m_invoicesModel, this);
+
+        m_daemonSupervisor = new DaemonSupervisor(m_rpcSocket, this);
+        QObject::connect(m_daemonSupervisor, &DaemonSupervisor::restartRequested, this, &LightningModel::launchDaemon);
+        QObject::connect(m_daemonSupervisor, &DaemonSupervisor::hangDetected, this, &LightningModel::daemonHung);
+
         QObject::connect(m_unixSocket, SIGNAL(error(QLocalSocket::LocalSocketError)),
                          this, SLOT(unixSocketError(QLocalSocket::LocalSocketError)));
 
+        QObject::connect(m_unixSocket, SIGNAL(connected()),
+                         this, SLOT(rpcConnected()));
+
         QObject::connect(m_unixSocket, SIGNAL(disconnected()),
                          this, SLOT(unixSocketDisconnected()));
 
-        QObject::connect(m_rpcSocket, &QJsonRpcAbstractSocket::messageReceived, this, &LightningModel::rpcMessageReceived);
+        QObject::connect(m_rpcSocket, &RpcConnectionPool::messageReceived, this, &LightningModel::rpcMessageReceived);
 
-        m_unixSocket->connectToServer(m_lightningRpcSocket);
-
-        // Usually, if we wait longer than 5 secs there is something wrong
-        // with an already running daemon
-        if (m_unixSocket->waitForConnected(5000))
-        {
-            rpcConnected();
-        }
-        else
-        {
-            // No daemon so lets launch our own
-            launchDaemon();
-        }
+        // Show the last known state until the daemon answers
+        applySnapshot();
 
+        // Nothing in here blocks, the UI comes up while we connect
+        setStartupPhase(ConnectingToRunningDaemon);
+        m_connectionTimeoutTimer->start();
+        m_unixSocket->connectToServer(m_lightningRpcSocket);
     }
 }
 
@@ -296,46 +421,124 @@ LightningModel *LightningModel::instance()
 
 void LightningModel::rpcConnected()
 {
+    m_connectionTimeoutTimer->stop();
     m_connectionRetryTimer->stop();
+    m_rpcSocketWatcher->removePaths(m_rpcSocketWatcher->directories());
+
+    setStartupPhase(Connected);
     setConnectedToDaemon(true);
 
+    m_rpcSocket->connectBlockingLane(m_lightningRpcSocket);
+
+    // Picks up the listinvoices below to know where to wait from
+    m_invoiceDispatcher->start();
     updateModels();
+    m_invoiceSweeper->start();
 
     // Don't update the nodes all the time
     m_nodesModel->updateNodes();
 
-    m_updatesTimer = new QTimer();
-
-    // Update the models every 15 secs
-    m_updatesTimer->setInterval(15000);
-    m_updatesTimer->setSingleShot(false);
-    QObject::connect(m_updatesTimer, &QTimer::timeout, this, &LightningModel::updateModels);
     m_updatesTimer->start();
+
+    m_daemonSupervisor->daemonConnected();
 }
 
-void LightningModel::retryRpcConnection()
+void LightningModel::daemonHung()
 {
-    m_connectionRetryTimer->stop();
+    if (m_lightningDaemonProcess->state() == QProcess::NotRunning) {
+        // Not ours, nothing we can do but keep probing
+        emit errorString("Lightning daemon is not responding");
+        return;
+    }
 
-    // Let's retry every sec
-    m_connectionRetryTimer->setInterval(1000);
-    m_connectionRetryTimer->setSingleShot(true);
+    // Restarts through lightningProcessFinished
+    qDebug() << "Killing unresponsive daemon";
+    m_lightningDaemonProcess->kill();
+}
 
-    // Reentrant slot right here
-    m_connectionRetryTimer->start();
+void LightningModel::connectionTimedOut()
+{
+    if (m_startupPhase == ConnectingToRunningDaemon)
+    {
+        qDebug() << "Running daemon doesn't answer, launching our own";
+        m_unixSocket->abort();
+        launchDaemon();
+    }
+}
+
+void LightningModel::retryRpcConnection()
+{
+    if (m_startupPhase == Connected || m_startupPhase == Failed) {
+        return;
+    }
 
-    if (m_unixSocket->state() == QLocalSocket::UnconnectedState) {
+    if (m_unixSocket->state() == QLocalSocket::UnconnectedState
+            && QFileInfo::exists(m_lightningRpcSocket)) {
+        setStartupPhase(ConnectingToRpcSocket);
         m_unixSocket->connectToServer(m_lightningRpcSocket);
-        if (m_unixSocket->waitForConnected())
-        {
-            rpcConnected();
-        }
     }
 }
 
+void LightningModel::watchRpcSocket()
+{
+    // The daemon creates its directory on first run, watch the parent till then
+    QFileInfo rpcSocketInfo(m_lightningRpcSocket);
+    QString directory = rpcSocketInfo.absolutePath();
+    if (!QFileInfo::exists(directory)) {
+        directory = QFileInfo(directory).absolutePath();
+    }
+
+    if (!m_rpcSocketWatcher->directories().contains(directory)) {
+        m_rpcSocketWatcher->addPath(directory);
+    }
+}
+
+void LightningModel::rpcSocketDirectoryChanged()
+{
+    watchRpcSocket();
+    retryRpcConnection();
+}
+
+LightningModel::StartupPhase LightningModel::startupPhase() const
+{
+    return m_startupPhase;
+}
+
+QVariantMap LightningModel::startupTimings() const
+{
+    return m_startupTimings;
+}
+
+void LightningModel::setStartupPhase(StartupPhase startupPhase)
+{
+    if (m_startupPhase == startupPhase) {
+        return;
+    }
+
+    QMetaEnum phaseEnum = QMetaEnum::fromType<StartupPhase>();
+    if (m_startupPhase != NotStarted) {
+        TRACE_ASYNC_END("startup", phaseEnum.valueToKey(m_startupPhase), this);
+    }
+    TRACE_ASYNC_BEGIN("startup", phaseEnum.valueToKey(startupPhase), this);
+
+    m_startupPhase = startupPhase;
+
+    QString phaseName = phaseEnum.valueToKey(startupPhase);
+    qint64 elapsed = m_startupTimer.elapsed();
+    if (!m_startupTimings.contains(phaseName)) {
+        m_startupTimings.insert(phaseName, elapsed);
+    }
+    qDebug() << "Startup phase" << phaseName << "after" << elapsed << "ms";
+
+    emit startupPhaseChanged();
+}
+
 void LightningModel::setConnectedToDaemon(bool connectedToDaemon)
 {
-    m_connectedToDaemon = connectedToDaemon;
+    if (m_connectedToDaemon != connectedToDaemon) {
+        m_connectedToDaemon = connectedToDaemon;
+        emit infoChanged();
+    }
 }
 
 void LightningModel::setId(const QString &id)
@@ -360,6 +563,51 @@ NodesModel *LightningModel::nodesModel() const
     return m_nodesModel;
 }
 
+DaemonLogModel *LightningModel::daemonLogModel() const
+{
+    return m_daemonLogModel;
+}
+
+InvoiceDispatcher *LightningModel::invoiceDispatcher() const
+{
+    return m_invoiceDispatcher;
+}
+
+BulkInvoiceGenerator *LightningModel::bulkInvoiceGenerator() const
+{
+    return m_bulkInvoiceGenerator;
+}
+
+InvoiceHistoryStore *LightningModel::invoiceHistoryStore() const
+{
+    return m_invoiceHistoryStore;
+}
+
+InvoiceSweeper *LightningModel::invoiceSweeper() const
+{
+    return m_invoiceSweeper;
+}
+
+RevenueAggregator *LightningModel::revenueAggregator() const
+{
+    return m_revenueAggregator;
+}
+
+InvoiceSearchIndex *LightningModel::invoiceSearchIndex() const
+{
+    return m_invoiceSearchIndex;
+}
+
+DaemonSupervisor *LightningModel::daemonSupervisor() const
+{
+    return m_daemonSupervisor;
+}
+
+RpcConnectionPool *LightningModel::rpcConnectionPool() const
+{
+    return m_rpcSocket;
+}
+
 QString LightningModel::manualAddress() const
 {
     return m_manualAddress;
@@ -434,22 +682,47 @@ void LightningModel::rpcMessageReceived(QJsonRpcMessage message)
 void LightningModel::unixSocketError(QLocalSocket::LocalSocketError socketError)
 {
     //qDebug() << "Couldn't connect to daemon: " << socketError;
-    if (socketError != QLocalSocket::OperationError) {
-        //launchDaemon();
+    if (socketError == QLocalSocket::OperationError) {
+        return;
+    }
+
+    if (m_startupPhase == ConnectingToRunningDaemon) {
+        // No daemon so lets launch our own
+        m_connectionTimeoutTimer->stop();
+        launchDaemon();
+    }
+    else if (m_startupPhase == ConnectingToRpcSocket) {
+        // Socket file is there but nobody listens yet
+        setStartupPhase(WaitingForRpcSocket);
     }
 }
 
 void LightningModel::unixSocketDisconnected()
 {
     setConnectedToDaemon(false);
+    m_updatesTimer->stop();
+    m_invoiceDispatcher->stop();
+    m_invoiceSweeper->stop();
+    // The rest of the batch would only fail one by one
+    m_bulkInvoiceGenerator->cancel();
+    m_rpcSocket->disconnectBlockingLane();
+
+    if (m_startupPhase == Connected) {
+        // Reconnect if the daemon comes back
+        setStartupPhase(WaitingForRpcSocket);
+        watchRpcSocket();
+        m_connectionRetryTimer->start();
+    }
 }
 
 void LightningModel::updateModels()
 {
+    TRACE_SCOPE("model", "updateModels");
+
+    // All of these go over the fast lane connection and are answered in order
     m_paymentsModel->updatePayments();
     m_walletModel->updateFunds();
     m_invoicesModel->updateInvoices();
     updateInfo();
-    // This calls needs to go last cause it hates concurrency
     m_peersModel->updatePeers();
 }
@@ -4,6 +4,10 @@
 #include <QLocalSocket>
 #include <QTimer>
 #include <QProcess>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QVariantMap>
 
 #include "PeersModel.h"
 #include "PaymentsModel.h"
@@ -11,6 +15,15 @@
 #include "InvoicesModel.h"
 
 #include "NodesModel.h"
+#include "DaemonLogModel.h"
+#include "DaemonSupervisor.h"
+#include "InvoiceDispatcher.h"
+#include "BulkInvoiceGenerator.h"
+#include "InvoiceHistoryStore.h"
+#include "InvoiceSweeper.h"
+#include "RevenueAggregator.h"
+#include "InvoiceSearchIndex.h"
+#include "RpcConnectionPool.h"
 
 #include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
@@ -30,7 +43,22 @@ class LightningModel : public QObject
 
     Q_PROPERTY(QString serverName READ serverName WRITE setServerName NOTIFY serverNameChanged)
 
+    Q_PROPERTY(StartupPhase startupPhase READ startupPhase NOTIFY startupPhaseChanged)
+    Q_PROPERTY(QVariantMap startupTimings READ startupTimings NOTIFY startupPhaseChanged)
+
 public:
+    enum StartupPhase {
+        NotStarted,
+        ConnectingToRunningDaemon,
+        InstallingDaemon,
+        LaunchingDaemon,
+        WaitingForRpcSocket,
+        ConnectingToRpcSocket,
+        Connected,
+        Failed
+    };
+    Q_ENUM(StartupPhase)
+
     LightningModel(QString serverName = QString(""), QObject *parent = 0);
 
     static LightningModel* instance();
@@ -73,6 +101,19 @@ public:
     void setManualAddress(const QString &manualAddress);
 
     NodesModel *nodesModel() const;
+    DaemonLogModel *daemonLogModel() const;
+    InvoiceDispatcher *invoiceDispatcher() const;
+    BulkInvoiceGenerator *bulkInvoiceGenerator() const;
+    InvoiceHistoryStore *invoiceHistoryStore() const;
+    InvoiceSweeper *invoiceSweeper() const;
+    RevenueAggregator *revenueAggregator() const;
+    InvoiceSearchIndex *invoiceSearchIndex() const;
+    DaemonSupervisor *daemonSupervisor() const;
+    RpcConnectionPool *rpcConnectionPool() const;
+
+    StartupPhase startupPhase() const;
+    // Milliseconds since construction at which each phase was first entered
+    QVariantMap startupTimings() const;
 
 public slots:
     void updateModels();
@@ -82,13 +123,18 @@ private:
 
 private:
     void updateInfo();
+    void populateInfoFromJson(QJsonObject resultsObject);
+    void applySnapshot();
     void launchDaemon();
+    void startDaemonProcess();
     void retryRpcConnection();
     void setConnectedToDaemon(bool connectedToDaemon);
+    void setStartupPhase(StartupPhase startupPhase);
+    void watchRpcSocket();
 
 private:
     QLocalSocket* m_unixSocket;
-    QJsonRpcSocket* m_rpcSocket;
+    RpcConnectionPool* m_rpcSocket;
     QList<QJsonRpcServiceReply*> m_repliesList;
     PeersModel* m_peersModel;
     PaymentsModel* m_paymentsModel;
@@ -96,14 +142,30 @@ private:
     InvoicesModel* m_invoicesModel;
 
     NodesModel* m_nodesModel;
+    InvoiceDispatcher* m_invoiceDispatcher;
+    BulkInvoiceGenerator* m_bulkInvoiceGenerator;
+    InvoiceHistoryStore* m_invoiceHistoryStore;
+    InvoiceSweeper* m_invoiceSweeper;
+    RevenueAggregator* m_revenueAggregator;
+    InvoiceSearchIndex* m_invoiceSearchIndex;
+    DaemonLogModel* m_daemonLogModel;
+    DaemonSupervisor* m_daemonSupervisor;
+    bool m_credentialsError;
 
     QTimer* m_updatesTimer;
 
     QString m_lightningRpcSocket;
     QTimer* m_connectionRetryTimer;
+    QTimer* m_connectionTimeoutTimer;
+    QFileSystemWatcher* m_rpcSocketWatcher;
     bool m_connectedToDaemon;
 
+    StartupPhase m_startupPhase;
+    QElapsedTimer m_startupTimer;
+    QVariantMap m_startupTimings;
+
     QProcess* m_lightningDaemonProcess;
+    QFutureWatcher<bool> m_installWatcher;
 
     QString m_id;
     int m_port;
@@ -124,11 +186,15 @@ private:
     int m_autopilotChannelAmount;
     QString m_autopilotPeerId;
 
-    bool m_firstStart;
-
 
 private slots:
     void rpcConnected();
+    void connectionTimedOut();
+    void daemonHung();
+    void daemonInstalled();
+    void lightningProcessStarted();
+    void lightningProcessError(QProcess::ProcessError processError);
+    void rpcSocketDirectoryChanged();
     void rpcMessageReceived(QJsonRpcMessage message);
     void unixSocketError(QLocalSocket::LocalSocketError unixSocketError);
     void unixSocketDisconnected();
@@ -140,6 +206,7 @@ signals:
     void serverNameChanged();
     void errorString(QString error);
     void rpcConnectionError();
+    void startupPhaseChanged();
 
 };
 
@@ -0,0 +1,237 @@
+#include <QDebug>
+#include <QThread>
+#include <QtGlobal>
+
+#include "LoopbackNfcTransceiver.h"
+#include "Tracer.h"
+
+LoopbackNfcTransceiver::LoopbackNfcTransceiver()
+{
+    m_tagPresent = false;
+    m_tagPresentMs = 0;
+    m_tagAwayMs = 0;
+    m_latency = 0;
+    m_packetLossPercent = 0;
+    m_maxApduSize = 261; // Short APDU with extended header
+    m_online = true;
+    m_peerId = QByteArray(33, 0x02);
+
+    resetStatistics();
+}
+
+bool LoopbackNfcTransceiver::initialize()
+{
+    qDebug() << "Using loopback NFC transceiver";
+    return true;
+}
+
+bool LoopbackNfcTransceiver::tagPresent() const
+{
+    if (m_tagPresentMs > 0) {
+        return m_tagCycleClock.elapsed() % (m_tagPresentMs + m_tagAwayMs) < m_tagPresentMs;
+    }
+    return m_tagPresent;
+}
+
+int LoopbackNfcTransceiver::transceive(const unsigned char *command, int commandLength,
+                                       unsigned char *response, int responseLength,
+                                       int timeout)
+{
+    TRACE_SCOPE("nfc", "transceive");
+
+    m_transceiveCount++;
+
+    if (!tagPresent() || commandLength > m_maxApduSize) {
+        m_failedTransceiveCount++;
+        return 0;
+    }
+
+    if (m_latency > 0) {
+        // Transceiving blocks on real hardware as well
+        QThread::msleep(qMin(m_latency, timeout));
+    }
+
+    if (m_latency > timeout || (m_packetLossPercent > 0 && (qrand() % 100) < m_packetLossPercent)) {
+        m_failedTransceiveCount++;
+        return 0;
+    }
+
+    m_bytesSent += commandLength;
+
+    QByteArray reply = processCommandApdu(QByteArray((const char*)command, commandLength));
+    if (reply.size() > responseLength) {
+        // The reader would truncate this too
+        reply.truncate(responseLength);
+    }
+
+    memcpy(response, reply.constData(), reply.size());
+    m_bytesReceived += reply.size();
+
+    return reply.size();
+}
+
+QByteArray LoopbackNfcTransceiver::processCommandApdu(const QByteArray &commandApdu)
+{
+    // Mirrors LightningApduService::processCommandApdu
+    if (commandApdu == QByteArray((const char*)SELECT_LIGHTNING, sizeof(SELECT_LIGHTNING))) {
+        return QByteArray((const char*)SELECT_OK, sizeof(SELECT_OK));
+    }
+    else if (commandApdu.size() >= 3 && (unsigned char)commandApdu.at(0) == BOLT11_COMMAND) {
+        int seqNo = (unsigned char)commandApdu.at(1);
+        int totalPackets = (unsigned char)commandApdu.at(2);
+
+        if (seqNo == 0) {
+            m_bolt11ReceiveBuffer.clear();
+        }
+
+        m_bolt11ReceiveBuffer.append(commandApdu.mid(3));
+
+        if (totalPackets > 1 && seqNo != totalPackets - 1) {
+            return QByteArray(1, DATA_RESPONSE_OK);
+        }
+
+        return checkIfWeAreOnlineAndReply();
+    }
+    else if (commandApdu.size() >= 1 && (unsigned char)commandApdu.at(0) == NFC_SOCKET_STREAM) {
+        m_socketReceiveBuffer.append(commandApdu.mid(1));
+
+        if (m_socketSendBuffer.isEmpty()) {
+            // Nothing to send
+            return QByteArray(1, NFC_SOCKET_STREAM_NO_DATA);
+        }
+
+        QByteArray reply(1, NFC_SOCKET_STREAM);
+        reply.append(m_socketSendBuffer);
+        m_socketSendBuffer.clear();
+        return reply;
+    }
+
+    return QByteArray(1, UNKNOWN_COMMAND_RESPONSE);
+}
+
+QByteArray LoopbackNfcTransceiver::checkIfWeAreOnlineAndReply()
+{
+    m_lastBolt11 = QString::fromUtf8(m_bolt11ReceiveBuffer);
+    m_bolt11ReceiveBuffer.clear();
+
+    if (!m_online) {
+        QByteArray reply(1, NFC_SOCKET_COMMAND);
+        reply.append(m_peerId);
+        return reply;
+    }
+
+    return QByteArray(1, BOLT11_RECEIVED_NO_SOCKET);
+}
+
+void LoopbackNfcTransceiver::setTagPresent(bool tagPresent)
+{
+    m_tagPresentMs = 0;
+    m_tagPresent = tagPresent;
+}
+
+void LoopbackNfcTransceiver::setTagCycle(int presentMs, int awayMs)
+{
+    m_tagPresentMs = qMax(0, presentMs);
+    m_tagAwayMs = qMax(0, awayMs);
+    m_tagCycleClock.start();
+}
+
+int LoopbackNfcTransceiver::latency() const
+{
+    return m_latency;
+}
+
+void LoopbackNfcTransceiver::setLatency(int latency)
+{
+    m_latency = latency;
+}
+
+int LoopbackNfcTransceiver::packetLossPercent() const
+{
+    return m_packetLossPercent;
+}
+
+void LoopbackNfcTransceiver::setPacketLossPercent(int packetLossPercent)
+{
+    m_packetLossPercent = packetLossPercent;
+}
+
+int LoopbackNfcTransceiver::maxApduSize() const
+{
+    return m_maxApduSize;
+}
+
+void LoopbackNfcTransceiver::setMaxApduSize(int maxApduSize)
+{
+    m_maxApduSize = maxApduSize;
+}
+
+bool LoopbackNfcTransceiver::online() const
+{
+    return m_online;
+}
+
+void LoopbackNfcTransceiver::setOnline(bool online)
+{
+    m_online = online;
+}
+
+QByteArray LoopbackNfcTransceiver::peerId() const
+{
+    return m_peerId;
+}
+
+void LoopbackNfcTransceiver::setPeerId(const QByteArray &peerId)
+{
+    m_peerId = peerId;
+}
+
+QString LoopbackNfcTransceiver::lastBolt11() const
+{
+    return m_lastBolt11;
+}
+
+QByteArray LoopbackNfcTransceiver::takeReceivedSocketData()
+{
+    QByteArray socketData = m_socketReceiveBuffer;
+    m_socketReceiveBuffer.clear();
+    return socketData;
+}
+
+void LoopbackNfcTransceiver::queueSocketData(const QByteArray &socketData)
+{
+    m_socketSendBuffer.append(socketData);
+}
+
+int LoopbackNfcTransceiver::queuedSocketDataSize() const
+{
+    return m_socketSendBuffer.size();
+}
+
+int LoopbackNfcTransceiver::transceiveCount() const
+{
+    return m_transceiveCount;
+}
+
+int LoopbackNfcTransceiver::failedTransceiveCount() const
+{
+    return m_failedTransceiveCount;
+}
+
+qint64 LoopbackNfcTransceiver::bytesSent() const
+{
+    return m_bytesSent;
+}
+
+qint64 LoopbackNfcTransceiver::bytesReceived() const
+{
+    return m_bytesReceived;
+}
+
+void LoopbackNfcTransceiver::resetStatistics()
+{
+    m_transceiveCount = 0;
+    m_failedTransceiveCount = 0;
+    m_bytesSent = 0;
+    m_bytesReceived = 0;
+}
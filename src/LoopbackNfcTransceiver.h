@@ -0,0 +1,83 @@
+#ifndef LOOPBACKNFCTRANSCEIVER_H
+#define LOOPBACKNFCTRANSCEIVER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include "NfcTransceiver.h"
+
+// In-process stand-in for a phone running LightningApduService
+// Lets the NFC path run without a reader attached
+class LoopbackNfcTransceiver : public NfcTransceiver
+{
+public:
+    LoopbackNfcTransceiver();
+
+    bool initialize();
+    bool tagPresent() const;
+    int transceive(const unsigned char *command, int commandLength,
+                   unsigned char *response, int responseLength,
+                   int timeout);
+
+    void setTagPresent(bool tagPresent);
+
+    // Keeps tapping a phone: present for presentMs, then away for awayMs.
+    // setTagPresent() stops it
+    void setTagCycle(int presentMs, int awayMs);
+
+    int latency() const;
+    void setLatency(int latency);
+
+    int packetLossPercent() const;
+    void setPacketLossPercent(int packetLossPercent);
+
+    int maxApduSize() const;
+    void setMaxApduSize(int maxApduSize);
+
+    bool online() const;
+    void setOnline(bool online);
+
+    QByteArray peerId() const;
+    void setPeerId(const QByteArray &peerId);
+
+    // What the emulated phone has received
+    QString lastBolt11() const;
+    QByteArray takeReceivedSocketData();
+
+    // Queue data for the emulated phone to tunnel back to us
+    void queueSocketData(const QByteArray &socketData);
+    int queuedSocketDataSize() const;
+
+    int transceiveCount() const;
+    int failedTransceiveCount() const;
+    qint64 bytesSent() const;
+    qint64 bytesReceived() const;
+    void resetStatistics();
+
+private:
+    QByteArray processCommandApdu(const QByteArray &commandApdu);
+    QByteArray checkIfWeAreOnlineAndReply();
+
+private:
+    bool m_tagPresent;
+    int m_tagPresentMs;
+    int m_tagAwayMs;
+    QElapsedTimer m_tagCycleClock;
+    int m_latency;
+    int m_packetLossPercent;
+    int m_maxApduSize;
+    bool m_online;
+    QByteArray m_peerId;
+
+    QByteArray m_bolt11ReceiveBuffer;
+    QString m_lastBolt11;
+    QByteArray m_socketSendBuffer;
+    QByteArray m_socketReceiveBuffer;
+
+    int m_transceiveCount;
+    int m_failedTransceiveCount;
+    qint64 m_bytesSent;
+    qint64 m_bytesReceived;
+};
+
+#endif // LOOPBACKNFCTRANSCEIVER_H
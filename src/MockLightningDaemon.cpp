@@ -0,0 +1,912 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStringList>
+
+#include "MockLightningDaemon.h"
+
+// Datasets, so the same index gives the same row in every list
+enum MockKind {
+    NodeIdKind = 1,
+    InvoiceKind,
+    PaymentKind,
+    PeerKind,
+    OutputKind,
+    NodeKind,
+    LatencyKind
+};
+
+static QByteArray jsonString(const QString &string)
+{
+    QByteArray array = QJsonDocument(QJsonArray() << string).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
+
+static QByteArray jsonValue(const QJsonValue &value)
+{
+    QByteArray array = QJsonDocument(QJsonArray() << value).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
+
+// Finds the end of the first complete JSON object in buffer, -1 if there is none yet
+static int jsonObjectEnd(const QByteArray &buffer)
+{
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+
+    for (int i = 0; i < buffer.size(); i++) {
+        char character = buffer.at(i);
+        if (inString) {
+            if (escaped)
+                escaped = false;
+            else if (character == '\\')
+                escaped = true;
+            else if (character == '"')
+                inString = false;
+            continue;
+        }
+
+        if (character == '"') {
+            inString = true;
+        }
+        else if (character == '{' || character == '[') {
+            depth++;
+        }
+        else if (character == '}' || character == ']') {
+            depth--;
+            if (depth == 0) {
+                return i + 1;
+            }
+        }
+    }
+    return -1;
+}
+
+MockLightningDaemon::MockLightningDaemon(QObject *parent) : QObject(parent)
+{
+    m_server = new QLocalServer(this);
+    QObject::connect(m_server, &QLocalServer::newConnection, this, &MockLightningDaemon::newConnection);
+
+    m_responseTimer = new QTimer(this);
+    m_responseTimer->setSingleShot(true);
+    QObject::connect(m_responseTimer, &QTimer::timeout, this, &MockLightningDaemon::sendDueResponses);
+    m_clock.start();
+
+    m_invoiceCount = 1000;
+    m_paymentCount = 1000;
+    m_peerCount = 10;
+    m_outputCount = 100;
+    m_nodeCount = 1000;
+    m_latency = 0;
+    m_latencyJitter = 0;
+    m_payLatency = 500;
+    m_autoPayDelay = -1;
+    m_seed = 1;
+    // Fixed, so two runs produce byte identical datasets
+    m_baseTimestamp = 1525132800;
+
+    m_lastPayIndex = m_invoiceCount;
+    m_paymentsMade = 0;
+    m_requestCount = 0;
+}
+
+bool MockLightningDaemon::listen(const QString &serverName)
+{
+    QLocalServer::removeServer(serverName);
+    if (!m_server->listen(serverName)) {
+        qDebug() << "Mock daemon couldn't listen on" << serverName << m_server->errorString();
+        return false;
+    }
+
+    qDebug() << "Mock daemon listening on" << m_server->fullServerName()
+             << "invoices:" << m_invoiceCount << "payments:" << m_paymentCount
+             << "peers:" << m_peerCount << "outputs:" << m_outputCount
+             << "nodes:" << m_nodeCount << "latency:" << m_latency;
+    return true;
+}
+
+QString MockLightningDaemon::serverName() const
+{
+    return m_server->fullServerName();
+}
+
+void MockLightningDaemon::setScale(const QString &scale)
+{
+    foreach (QString setting, scale.split(',', QString::SkipEmptyParts)) {
+        QString key = setting.section('=', 0, 0).trimmed();
+        int value = setting.section('=', 1, 1).trimmed().toInt();
+
+        if (key == "invoices")
+            setInvoiceCount(value);
+        else if (key == "payments")
+            setPaymentCount(value);
+        else if (key == "peers")
+            setPeerCount(value);
+        else if (key == "outputs")
+            setOutputCount(value);
+        else if (key == "nodes")
+            setNodeCount(value);
+        else if (key == "latency")
+            setLatency(value);
+        else if (key == "jitter")
+            setLatencyJitter(value);
+        else if (key == "paylatency")
+            setPayLatency(value);
+        else if (key == "autopay")
+            setAutoPayDelay(value);
+        else if (key == "seed")
+            setSeed(value);
+        else
+            qDebug() << "Unknown mock daemon setting" << key;
+    }
+}
+
+int MockLightningDaemon::invoiceCount() const
+{
+    return m_invoiceCount;
+}
+
+void MockLightningDaemon::setInvoiceCount(int invoiceCount)
+{
+    m_invoiceCount = invoiceCount;
+    m_lastPayIndex = qMax(m_lastPayIndex, invoiceCount);
+}
+
+int MockLightningDaemon::paymentCount() const
+{
+    return m_paymentCount;
+}
+
+void MockLightningDaemon::setPaymentCount(int paymentCount)
+{
+    m_paymentCount = paymentCount;
+}
+
+int MockLightningDaemon::peerCount() const
+{
+    return m_peerCount;
+}
+
+void MockLightningDaemon::setPeerCount(int peerCount)
+{
+    m_peerCount = peerCount;
+}
+
+int MockLightningDaemon::outputCount() const
+{
+    return m_outputCount;
+}
+
+void MockLightningDaemon::setOutputCount(int outputCount)
+{
+    m_outputCount = outputCount;
+}
+
+int MockLightningDaemon::nodeCount() const
+{
+    return m_nodeCount;
+}
+
+void MockLightningDaemon::setNodeCount(int nodeCount)
+{
+    m_nodeCount = nodeCount;
+}
+
+int MockLightningDaemon::latency() const
+{
+    return m_latency;
+}
+
+void MockLightningDaemon::setLatency(int latency)
+{
+    m_latency = latency;
+}
+
+int MockLightningDaemon::latencyJitter() const
+{
+    return m_latencyJitter;
+}
+
+void MockLightningDaemon::setLatencyJitter(int latencyJitter)
+{
+    m_latencyJitter = latencyJitter;
+}
+
+int MockLightningDaemon::payLatency() const
+{
+    return m_payLatency;
+}
+
+void MockLightningDaemon::setPayLatency(int payLatency)
+{
+    m_payLatency = payLatency;
+}
+
+int MockLightningDaemon::autoPayDelay() const
+{
+    return m_autoPayDelay;
+}
+
+void MockLightningDaemon::setAutoPayDelay(int autoPayDelay)
+{
+    m_autoPayDelay = autoPayDelay;
+}
+
+quint64 MockLightningDaemon::seed() const
+{
+    return m_seed;
+}
+
+void MockLightningDaemon::setSeed(quint64 seed)
+{
+    m_seed = seed;
+}
+
+int MockLightningDaemon::requestCount() const
+{
+    return m_requestCount;
+}
+
+quint64 MockLightningDaemon::randomValue(quint64 kind, quint64 index) const
+{
+    // splitmix64, stateless so any row can be generated on its own
+    quint64 z = m_seed * Q_UINT64_C(0x9E3779B97F4A7C15) + (kind << 48) + index;
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+QString MockLightningDaemon::randomHex(quint64 kind, quint64 index, int length) const
+{
+    QString hex;
+    hex.reserve(length + 16);
+    quint64 round = 0;
+    while (hex.size() < length) {
+        hex += QString::number(randomValue(kind, index * 8 + round), 16).rightJustified(16, '0');
+        round++;
+    }
+    hex.truncate(length);
+    return hex;
+}
+
+void MockLightningDaemon::newConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QLocalSocket *socket = m_server->nextPendingConnection();
+        QObject::connect(socket, &QLocalSocket::readyRead, this, &MockLightningDaemon::socketReadyRead);
+        QObject::connect(socket, &QLocalSocket::disconnected, this, &MockLightningDaemon::socketDisconnected);
+        m_buffers.insert(socket, QByteArray());
+    }
+}
+
+void MockLightningDaemon::socketDisconnected()
+{
+    QLocalSocket *socket = static_cast<QLocalSocket *>(sender());
+    m_buffers.remove(socket);
+    m_lastDueAt.remove(socket);
+    socket->deleteLater();
+}
+
+void MockLightningDaemon::socketReadyRead()
+{
+    QLocalSocket *socket = static_cast<QLocalSocket *>(sender());
+    QByteArray &buffer = m_buffers[socket];
+    buffer.append(socket->readAll());
+
+    int end;
+    while ((end = jsonObjectEnd(buffer)) != -1) {
+        QByteArray requestData = buffer.left(end);
+        buffer.remove(0, end);
+
+        QJsonParseError parseError;
+        QJsonDocument requestDocument = QJsonDocument::fromJson(requestData.trimmed(), &parseError);
+        if (parseError.error != QJsonParseError::NoError || !requestDocument.isObject()) {
+            respondError(socket, QJsonValue(), -32700, "Parse error");
+            continue;
+        }
+
+        handleRequest(socket, requestDocument.object());
+    }
+}
+
+void MockLightningDaemon::handleRequest(QLocalSocket *socket, const QJsonObject &request)
+{
+    QString method = request.value("method").toString();
+    QJsonValue id = request.value("id");
+
+    m_requestCount++;
+    emit requestReceived(method);
+
+    int extraLatency = 0;
+    bool deferred = false;
+    QByteArray result = handleMethod(socket, method, id, request.value("params"), extraLatency, deferred);
+
+    if (deferred || id.isUndefined()) {
+        // Answered later, or a notification that needs no answer
+        return;
+    }
+
+    if (result.isNull()) {
+        respondError(socket, id, -32601, "Unknown command '" + method + "'");
+        return;
+    }
+
+    if (result.startsWith('!')) {
+        // Error message from the handler
+        respondError(socket, id, -1, QString::fromUtf8(result.mid(1)));
+        return;
+    }
+
+    respond(socket, id, result, extraLatency);
+}
+
+QByteArray MockLightningDaemon::handleMethod(QLocalSocket *socket, const QString &method, const QJsonValue &id,
+                                             const QJsonValue &params, int &extraLatency, bool &deferred)
+{
+    QJsonObject paramsObject = params.toObject();
+
+    if (method == "getinfo") {
+        return getInfoJson();
+    }
+    else if (method == "listinvoices") {
+        QString label = paramsObject.value("label").toString();
+        if (params.isArray()) {
+            label = params.toArray().at(0).toString();
+        }
+        if (!label.isEmpty()) {
+            MockInvoice invoice = findInvoice(label);
+            if (invoice.m_label.isEmpty() || invoice.m_deleted) {
+                return "{\"invoices\":[]}";
+            }
+            return "{\"invoices\":[" + invoiceJson(invoice) + "]}";
+        }
+        return listInvoicesJson();
+    }
+    else if (method == "listpayments") {
+        return listPaymentsJson();
+    }
+    else if (method == "listpeers") {
+        return listPeersJson();
+    }
+    else if (method == "listfunds") {
+        return listFundsJson();
+    }
+    else if (method == "listnodes") {
+        return listNodesJson();
+    }
+    else if (method == "invoice") {
+        QString error;
+        QByteArray result = createInvoice(params, error);
+        if (!error.isEmpty()) {
+            return "!" + error.toUtf8();
+        }
+        return result;
+    }
+    else if (method == "delinvoice") {
+        MockInvoice invoice = findInvoice(paramsObject.value("label").toString());
+        if (invoice.m_label.isEmpty() || invoice.m_deleted) {
+            return "!Unknown invoice";
+        }
+        invoice.m_deleted = true;
+        storeInvoice(invoice);
+        return invoiceJson(invoice);
+    }
+    else if (method == "delexpiredinvoice") {
+        qint64 maxExpiryTime = paramsObject.contains("maxexpirytime")
+                ? paramsObject.value("maxexpirytime").toVariant().toLongLong()
+                : (qint64)QDateTime::currentDateTimeUtc().toTime_t();
+        QStringList labels = m_createdInvoices;
+        for (int i = 0; i < m_invoiceCount; i++) {
+            labels.append("mock-" + QString::number(i));
+        }
+        foreach (const QString &label, labels) {
+            MockInvoice invoice = findInvoice(label);
+            if (!invoice.m_deleted && invoice.m_status == MockInvoice::Expired && invoice.m_expiresAt <= maxExpiryTime) {
+                invoice.m_deleted = true;
+                storeInvoice(invoice);
+            }
+        }
+        return "{}";
+    }
+    else if (method == "waitinvoice" || method == "waitanyinvoice") {
+        InvoiceWaiter waiter;
+        waiter.socket = socket;
+        waiter.id = id;
+        if (method == "waitinvoice") {
+            waiter.label = paramsObject.value("label").toString();
+            waiter.lastPayIndex = -1;
+            MockInvoice invoice = findInvoice(waiter.label);
+            if (invoice.m_label.isEmpty() || invoice.m_deleted) {
+                return "!Unknown invoice";
+            }
+        }
+        else {
+            waiter.lastPayIndex = params.isArray() ? params.toArray().at(0).toInt()
+                                                   : paramsObject.value("lastpay_index").toInt();
+        }
+        m_invoiceWaiters.append(waiter);
+        deferred = true;
+        answerInvoiceWaiters();
+        return QByteArray();
+    }
+    else if (method == "decodepay") {
+        QString bolt11 = params.isString() ? params.toString()
+                                           : params.isArray() ? params.toArray().at(0).toString()
+                                                              : paramsObject.value("bolt11").toString();
+        return decodePayJson(bolt11);
+    }
+    else if (method == "pay") {
+        extraLatency = m_payLatency;
+        return payJson(params);
+    }
+    else if (method == "connect") {
+        return "{\"id\":" + jsonString(paramsObject.value("id").toString()) + "}";
+    }
+    else if (method == "fundchannel") {
+        return "{\"tx\":\"" + randomHex(OutputKind, m_requestCount, 200).toLatin1()
+                + "\",\"txid\":\"" + randomHex(OutputKind, m_requestCount + 1, 64).toLatin1()
+                + "\",\"id\":" + jsonString(paramsObject.value("id").toString()) + "}";
+    }
+    else if (method == "close") {
+        return "{\"tx\":\"" + randomHex(OutputKind, m_requestCount, 200).toLatin1()
+                + "\",\"txid\":\"" + randomHex(OutputKind, m_requestCount + 1, 64).toLatin1()
+                + "\",\"type\":\"mutual\"}";
+    }
+    else if (method == "disconnect") {
+        return "{}";
+    }
+    else if (method == "newaddr") {
+        return "{\"address\":\"2N" + randomHex(OutputKind, m_requestCount, 32).toLatin1() + "\"}";
+    }
+    else if (method == "withdraw") {
+        return "{\"tx\":\"" + randomHex(OutputKind, m_requestCount, 200).toLatin1()
+                + "\",\"txid\":\"" + randomHex(OutputKind, m_requestCount + 1, 64).toLatin1() + "\"}";
+    }
+
+    return QByteArray();
+}
+
+void MockLightningDaemon::respond(QLocalSocket *socket, const QJsonValue &id, const QByteArray &result, int extraLatency)
+{
+    QByteArray data;
+    data.reserve(result.size() + 64);
+    data += "{\"jsonrpc\":\"2.0\",\"id\":";
+    data += jsonValue(id);
+    data += ",\"result\":";
+    data += result;
+    data += "}\n\n";
+
+    queueResponse(socket, data, extraLatency);
+}
+
+void MockLightningDaemon::respondError(QLocalSocket *socket, const QJsonValue &id, int code, const QString &message)
+{
+    QByteArray data;
+    data += "{\"jsonrpc\":\"2.0\",\"id\":";
+    data += id.isUndefined() ? QByteArray("null") : jsonValue(id);
+    data += ",\"error\":{\"code\":" + QByteArray::number(code);
+    data += ",\"message\":" + jsonString(message) + "}}\n\n";
+
+    queueResponse(socket, data, 0);
+}
+
+void MockLightningDaemon::queueResponse(QLocalSocket *socket, const QByteArray &data, int extraLatency)
+{
+    int delay = m_latency + extraLatency;
+    if (m_latencyJitter > 0) {
+        delay += randomValue(LatencyKind, m_requestCount) % (m_latencyJitter + 1);
+    }
+
+    if (delay <= 0 && m_pendingResponses.isEmpty()) {
+        socket->write(data);
+        return;
+    }
+
+    // lightningd answers a connection in order, keep it that way
+    PendingResponse response;
+    response.socket = socket;
+    response.data = data;
+    response.dueAt = qMax(m_clock.elapsed() + delay, m_lastDueAt.value(socket));
+    m_lastDueAt.insert(socket, response.dueAt);
+
+    int position = m_pendingResponses.size();
+    while (position > 0 && m_pendingResponses.at(position - 1).dueAt > response.dueAt) {
+        position--;
+    }
+    m_pendingResponses.insert(position, response);
+
+    m_responseTimer->start(qMax(Q_INT64_C(0), m_pendingResponses.first().dueAt - m_clock.elapsed()));
+}
+
+void MockLightningDaemon::sendDueResponses()
+{
+    qint64 now = m_clock.elapsed();
+    while (!m_pendingResponses.isEmpty() && m_pendingResponses.first().dueAt <= now) {
+        PendingResponse response = m_pendingResponses.takeFirst();
+        if (response.socket) {
+            response.socket->write(response.data);
+        }
+    }
+
+    if (!m_pendingResponses.isEmpty()) {
+        m_responseTimer->start(qMax(Q_INT64_C(0), m_pendingResponses.first().dueAt - now));
+    }
+}
+
+QByteArray MockLightningDaemon::getInfoJson() const
+{
+    QByteArray info;
+    info += "{\"id\":\"" + randomHex(NodeIdKind, 0, 66).toLatin1() + "\",";
+    info += "\"port\":9735,";
+    info += "\"address\":[{\"type\":\"ipv4\",\"address\":\"127.0.0.1\",\"port\":9735}],";
+    info += "\"version\":\"v0.6-mock\",";
+    info += "\"blockheight\":" + QByteArray::number(1300000 + m_requestCount / 100) + ",";
+    info += "\"network\":\"testnet\"}";
+    return info;
+}
+
+MockInvoice MockLightningDaemon::invoiceAt(int index) const
+{
+    quint64 random = randomValue(InvoiceKind, index);
+
+    MockInvoice invoice;
+    invoice.m_label = "mock-" + QString::number(index);
+    invoice.m_description = "Mock invoice " + QString::number(index);
+    invoice.m_hash = randomHex(InvoiceKind, index, 64);
+    invoice.m_msatoshi = 1000 * (1 + random % 100000);
+    invoice.m_createdAt = m_baseTimestamp + index * 60;
+    invoice.m_expiresAt = invoice.m_createdAt + 3600;
+
+    // 70% paid, 20% expired, 10% still open
+    int bucket = (random >> 32) % 10;
+    if (bucket < 7) {
+        invoice.m_status = MockInvoice::Paid;
+        invoice.m_payIndex = index + 1;
+        invoice.m_paidAt = invoice.m_createdAt + (random >> 40) % 600;
+    }
+    else if (bucket < 9) {
+        invoice.m_status = MockInvoice::Expired;
+    }
+
+    return invoice;
+}
+
+MockInvoice MockLightningDaemon::findInvoice(const QString &label) const
+{
+    if (m_invoiceOverrides.contains(label)) {
+        return m_invoiceOverrides.value(label);
+    }
+
+    if (label.startsWith("mock-")) {
+        bool ok;
+        int index = label.mid(5).toInt(&ok);
+        if (ok && index >= 0 && index < m_invoiceCount) {
+            return invoiceAt(index);
+        }
+    }
+
+    return MockInvoice();
+}
+
+void MockLightningDaemon::storeInvoice(const MockInvoice &invoice)
+{
+    m_invoiceOverrides.insert(invoice.m_label, invoice);
+}
+
+QByteArray MockLightningDaemon::invoiceJson(const MockInvoice &invoice) const
+{
+    static const char *statusNames[] = { "unpaid", "paid", "expired" };
+
+    QByteArray json;
+    json.reserve(400);
+    json += "{\"label\":" + jsonString(invoice.m_label);
+    json += ",\"bolt11\":\"lntb" + QByteArray::number(invoice.m_msatoshi / 1000) + "n1mock" + invoice.m_hash.left(48).toLatin1() + "\"";
+    json += ",\"payment_hash\":\"" + invoice.m_hash.toLatin1() + "\"";
+    json += ",\"msatoshi\":" + QByteArray::number(invoice.m_msatoshi);
+    json += ",\"status\":\"";
+    json += statusNames[invoice.m_status];
+    json += "\",\"description\":" + jsonString(invoice.m_description);
+    json += ",\"expiry_time\":" + QByteArray::number(invoice.m_expiresAt);
+    json += ",\"expires_at\":" + QByteArray::number(invoice.m_expiresAt);
+    if (invoice.m_status == MockInvoice::Paid) {
+        json += ",\"pay_index\":" + QByteArray::number(invoice.m_payIndex);
+        json += ",\"msatoshi_received\":" + QByteArray::number(invoice.m_msatoshi);
+        json += ",\"paid_timestamp\":" + QByteArray::number(invoice.m_paidAt);
+        json += ",\"paid_at\":" + QByteArray::number(invoice.m_paidAt);
+    }
+    json += "}";
+    return json;
+}
+
+QByteArray MockLightningDaemon::listInvoicesJson() const
+{
+    QByteArray json;
+    json.reserve(m_invoiceCount * 400 + 32);
+    json += "{\"invoices\":[";
+
+    bool first = true;
+    for (int i = 0; i < m_invoiceCount; i++) {
+        MockInvoice invoice = invoiceAt(i);
+        if (m_invoiceOverrides.contains(invoice.m_label)) {
+            invoice = m_invoiceOverrides.value(invoice.m_label);
+        }
+        if (invoice.m_deleted) {
+            continue;
+        }
+        if (!first) {
+            json += ',';
+        }
+        json += invoiceJson(invoice);
+        first = false;
+    }
+
+    foreach (QString label, m_createdInvoices) {
+        MockInvoice invoice = m_invoiceOverrides.value(label);
+        if (invoice.m_deleted) {
+            continue;
+        }
+        if (!first) {
+            json += ',';
+        }
+        json += invoiceJson(invoice);
+        first = false;
+    }
+
+    json += "]}";
+    return json;
+}
+
+QByteArray MockLightningDaemon::listPaymentsJson() const
+{
+    QByteArray json;
+    json.reserve((m_paymentCount + m_paymentsMade) * 300 + 32);
+    json += "{\"payments\":[";
+
+    for (int i = 0; i < m_paymentCount + m_paymentsMade; i++) {
+        quint64 random = randomValue(PaymentKind, i);
+        int bucket = (random >> 32) % 20;
+        const char *status = bucket == 0 ? "failed" : bucket == 1 ? "pending" : "complete";
+
+        if (i > 0) {
+            json += ',';
+        }
+        json += "{\"id\":" + QByteArray::number(i + 1);
+        json += ",\"payment_hash\":\"" + randomHex(PaymentKind, i, 64).toLatin1() + "\"";
+        json += ",\"destination\":\"" + randomHex(NodeKind, random % qMax(1, m_nodeCount), 66).toLatin1() + "\"";
+        json += ",\"msatoshi\":" + QByteArray::number(1000 * (1 + random % 50000));
+        json += ",\"timestamp\":" + QByteArray::number(m_baseTimestamp + i * 90);
+        json += ",\"created_at\":" + QByteArray::number(m_baseTimestamp + i * 90);
+        json += ",\"incoming\":false";
+        json += ",\"status\":\"";
+        json += status;
+        json += "\"}";
+    }
+
+    json += "]}";
+    return json;
+}
+
+QByteArray MockLightningDaemon::listPeersJson() const
+{
+    QByteArray json;
+    json.reserve(m_peerCount * 400 + 32);
+    json += "{\"peers\":[";
+
+    for (int i = 0; i < m_peerCount; i++) {
+        quint64 random = randomValue(PeerKind, i);
+        qint64 total = 1000 * (100000 + random % 16000000);
+        qint64 toUs = total * ((random >> 32) % 101) / 100;
+
+        if (i > 0) {
+            json += ',';
+        }
+        json += "{\"id\":\"" + randomHex(NodeKind, i % qMax(1, m_nodeCount), 66).toLatin1() + "\"";
+        json += ",\"connected\":";
+        json += ((random >> 40) % 10) ? "true" : "false";
+        json += ",\"netaddr\":[\"10." + QByteArray::number((i >> 16) & 255) + "." + QByteArray::number((i >> 8) & 255)
+                + "." + QByteArray::number(i & 255) + ":9735\"]";
+        json += ",\"msatoshi_total\":" + QByteArray::number(total);
+        json += ",\"channels\":[{\"state\":\"CHANNELD_NORMAL\"";
+        json += ",\"channel_id\":\"" + randomHex(PeerKind, i, 64).toLatin1() + "\"";
+        json += ",\"msatoshi_to_us\":" + QByteArray::number(toUs);
+        json += ",\"msatoshi_total\":" + QByteArray::number(total);
+        json += "}]}";
+    }
+
+    json += "]}";
+    return json;
+}
+
+QByteArray MockLightningDaemon::listFundsJson() const
+{
+    QByteArray json;
+    json.reserve(m_outputCount * 160 + 32);
+    json += "{\"outputs\":[";
+
+    for (int i = 0; i < m_outputCount; i++) {
+        quint64 random = randomValue(OutputKind, i);
+
+        if (i > 0) {
+            json += ',';
+        }
+        json += "{\"txid\":\"" + randomHex(OutputKind, i, 64).toLatin1() + "\"";
+        json += ",\"output\":" + QByteArray::number((random >> 32) % 4);
+        json += ",\"value\":" + QByteArray::number(1000 + random % 10000000);
+        json += ",\"status\":\"";
+        json += ((random >> 40) % 10) ? "confirmed" : "unconfirmed";
+        json += "\"}";
+    }
+
+    json += "]}";
+    return json;
+}
+
+QByteArray MockLightningDaemon::listNodesJson() const
+{
+    QByteArray json;
+    json.reserve(m_nodeCount * 220 + 32);
+    json += "{\"nodes\":[";
+
+    for (int i = 0; i < m_nodeCount; i++) {
+        quint64 random = randomValue(NodeKind, i);
+
+        if (i > 0) {
+            json += ',';
+        }
+        json += "{\"nodeid\":\"" + randomHex(NodeKind, i, 66).toLatin1() + "\"";
+        json += ",\"alias\":\"MOCKNODE" + QByteArray::number(i) + "\"";
+        json += ",\"color\":\"" + QByteArray::number(random & 0xffffff, 16).rightJustified(6, '0') + "\"";
+        json += ",\"last_timestamp\":" + QByteArray::number(m_baseTimestamp + (random >> 32) % 86400);
+        // Most nodes announce one address, some none
+        if ((random >> 48) % 4) {
+            json += ",\"addresses\":[{\"type\":\"ipv4\",\"address\":\"10." + QByteArray::number((i >> 16) & 255)
+                    + "." + QByteArray::number((i >> 8) & 255) + "." + QByteArray::number(i & 255)
+                    + "\",\"port\":9735}]";
+        }
+        else {
+            json += ",\"addresses\":[]";
+        }
+        json += "}";
+    }
+
+    json += "]}";
+    return json;
+}
+
+QByteArray MockLightningDaemon::createInvoice(const QJsonValue &params, QString &error)
+{
+    QJsonObject paramsObject = params.toObject();
+
+    MockInvoice invoice;
+    invoice.m_label = paramsObject.value("label").toString();
+    invoice.m_description = paramsObject.value("description").toString();
+    invoice.m_msatoshi = paramsObject.value("msatoshi").toVariant().toLongLong();
+
+    if (invoice.m_label.isEmpty()) {
+        error = "Invoice needs a label";
+        return QByteArray();
+    }
+    MockInvoice existing = findInvoice(invoice.m_label);
+    if (!existing.m_label.isEmpty() && !existing.m_deleted) {
+        error = "Duplicate label '" + invoice.m_label + "'";
+        return QByteArray();
+    }
+
+    int expiry = paramsObject.value("expiry").toVariant().toInt();
+    invoice.m_hash = randomHex(InvoiceKind, m_invoiceCount + m_createdInvoices.size() + 1000000000ULL, 64);
+    invoice.m_createdAt = QDateTime::currentDateTimeUtc().toTime_t();
+    invoice.m_expiresAt = invoice.m_createdAt + (expiry > 0 ? expiry : 3600);
+
+    storeInvoice(invoice);
+    m_createdInvoices.append(invoice.m_label);
+
+    QByteArray bolt11 = "lntb" + QByteArray::number(invoice.m_msatoshi / 1000) + "n1mock" + invoice.m_hash.left(48).toLatin1();
+    emit invoiceCreated(invoice.m_label, QString::fromLatin1(bolt11));
+
+    if (m_autoPayDelay >= 0) {
+        m_autoPayQueue.append(invoice.m_label);
+        QTimer::singleShot(m_autoPayDelay, this, SLOT(autoPayTimeout()));
+    }
+
+    return "{\"payment_hash\":\"" + invoice.m_hash.toLatin1() + "\",\"expiry_time\":"
+            + QByteArray::number(invoice.m_expiresAt) + ",\"expires_at\":"
+            + QByteArray::number(invoice.m_expiresAt) + ",\"bolt11\":\"" + bolt11 + "\"}";
+}
+
+void MockLightningDaemon::autoPayTimeout()
+{
+    if (!m_autoPayQueue.isEmpty()) {
+        payInvoice(m_autoPayQueue.takeFirst());
+    }
+}
+
+void MockLightningDaemon::payInvoice(const QString &label)
+{
+    MockInvoice invoice = findInvoice(label);
+    if (invoice.m_label.isEmpty() || invoice.m_deleted || invoice.m_status != MockInvoice::Unpaid) {
+        return;
+    }
+
+    invoice.m_status = MockInvoice::Paid;
+    invoice.m_payIndex = ++m_lastPayIndex;
+    invoice.m_paidAt = QDateTime::currentDateTimeUtc().toTime_t();
+    storeInvoice(invoice);
+
+    answerInvoiceWaiters();
+}
+
+void MockLightningDaemon::answerInvoiceWaiters()
+{
+    for (int i = 0; i < m_invoiceWaiters.size(); ) {
+        InvoiceWaiter waiter = m_invoiceWaiters.at(i);
+        if (!waiter.socket) {
+            m_invoiceWaiters.removeAt(i);
+            continue;
+        }
+
+        MockInvoice answer;
+        if (waiter.lastPayIndex == -1) {
+            MockInvoice invoice = findInvoice(waiter.label);
+            if (invoice.m_status != MockInvoice::Unpaid) {
+                answer = invoice;
+            }
+        }
+        else {
+            // Lowest pay index above what the caller has seen, only runtime payments
+            // qualify since synthetic ones are all in the past
+            foreach (MockInvoice invoice, m_invoiceOverrides) {
+                if (invoice.m_status == MockInvoice::Paid && invoice.m_payIndex > waiter.lastPayIndex
+                        && (answer.m_label.isEmpty() || invoice.m_payIndex < answer.m_payIndex)) {
+                    answer = invoice;
+                }
+            }
+        }
+
+        if (answer.m_label.isEmpty()) {
+            i++;
+            continue;
+        }
+
+        m_invoiceWaiters.removeAt(i);
+        respond(waiter.socket, waiter.id, invoiceJson(answer));
+    }
+}
+
+QByteArray MockLightningDaemon::decodePayJson(const QString &bolt11) const
+{
+    // Amount is whatever follows the lntb prefix, in satoshi
+    qint64 msatoshi = 0;
+    int amountEnd = bolt11.indexOf('n', 4);
+    if (bolt11.startsWith("lntb") && amountEnd > 4) {
+        msatoshi = bolt11.mid(4, amountEnd - 4).toLongLong() * 1000;
+    }
+
+    uint hash = qHash(bolt11);
+
+    QByteArray json;
+    json += "{\"currency\":\"tb\"";
+    json += ",\"created_at\":" + QByteArray::number(QDateTime::currentDateTimeUtc().toTime_t());
+    json += ",\"expiry\":3600";
+    json += ",\"payee\":\"" + randomHex(NodeKind, hash % qMax(1, m_nodeCount), 66).toLatin1() + "\"";
+    if (msatoshi > 0) {
+        json += ",\"msatoshi\":" + QByteArray::number(msatoshi);
+    }
+    json += ",\"description\":\"Mock payment\"";
+    json += ",\"min_final_cltv_expiry\":10";
+    json += ",\"payment_hash\":\"" + randomHex(PaymentKind, hash, 64).toLatin1() + "\"";
+    json += ",\"signature\":\"" + randomHex(PaymentKind, hash + 1, 140).toLatin1() + "\"";
+    json += ",\"timestamp\":" + QByteArray::number(QDateTime::currentDateTimeUtc().toTime_t());
+    json += "}";
+    return json;
+}
+
+QByteArray MockLightningDaemon::payJson(const QJsonValue &params)
+{
+    Q_UNUSED(params)
+
+    m_paymentsMade++;
+    return "{\"preimage\":\"" + randomHex(PaymentKind, m_paymentCount + m_paymentsMade, 64).toLatin1()
+            + "\",\"tries\":1}";
+}
@@ -0,0 +1,190 @@
+#ifndef MOCKLIGHTNINGDAEMON_H
+#define MOCKLIGHTNINGDAEMON_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+#include <QElapsedTimer>
+
+class MockInvoice
+{
+public:
+    enum Status {
+        Unpaid,
+        Paid,
+        Expired
+    };
+
+    MockInvoice()
+    {
+        m_msatoshi = 0;
+        m_status = Unpaid;
+        m_payIndex = 0;
+        m_createdAt = 0;
+        m_paidAt = 0;
+        m_expiresAt = 0;
+        m_deleted = false;
+    }
+
+    QString m_label;
+    QString m_description;
+    QString m_hash;
+    qint64 m_msatoshi;
+    Status m_status;
+    int m_payIndex;
+    qint64 m_createdAt;
+    qint64 m_paidAt;
+    qint64 m_expiresAt;
+    bool m_deleted;
+};
+
+// Stand-in for lightningd on a local socket. Answers the JSON-RPC calls
+// the models make from deterministic synthetic data of any size, with
+// configurable latency, so the models can be benchmarked without a node.
+// Rows are generated from their index when listed, nothing is held per row
+// except invoices that were created or changed at runtime.
+class MockLightningDaemon : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int requestCount READ requestCount NOTIFY requestReceived)
+
+public:
+    MockLightningDaemon(QObject *parent = 0);
+
+    bool listen(const QString &serverName);
+    QString serverName() const;
+
+    // e.g. "invoices=1000000,nodes=50000,latency=20"
+    void setScale(const QString &scale);
+
+    int invoiceCount() const;
+    void setInvoiceCount(int invoiceCount);
+    int paymentCount() const;
+    void setPaymentCount(int paymentCount);
+    int peerCount() const;
+    void setPeerCount(int peerCount);
+    int outputCount() const;
+    void setOutputCount(int outputCount);
+    int nodeCount() const;
+    void setNodeCount(int nodeCount);
+
+    // Every reply is delayed by latency plus up to latencyJitter ms
+    int latency() const;
+    void setLatency(int latency);
+    int latencyJitter() const;
+    void setLatencyJitter(int latencyJitter);
+    // Extra time pay takes, on top of latency
+    int payLatency() const;
+    void setPayLatency(int payLatency);
+    // Invoices created through the mock get paid after this long, -1 never
+    int autoPayDelay() const;
+    void setAutoPayDelay(int autoPayDelay);
+
+    quint64 seed() const;
+    void setSeed(quint64 seed);
+
+    int requestCount() const;
+
+    // Whole datasets as the daemon would return them, for benchmarks
+    QByteArray listInvoicesJson() const;
+    QByteArray listPaymentsJson() const;
+    QByteArray listPeersJson() const;
+    QByteArray listFundsJson() const;
+    QByteArray listNodesJson() const;
+
+public slots:
+    // Marks an unpaid invoice paid and answers whoever waits on it
+    void payInvoice(const QString &label);
+
+signals:
+    void requestReceived(QString method);
+    void invoiceCreated(QString label, QString bolt11);
+
+protected:
+    // Returns the result, "!" and a message for an error or a null array for
+    // an unknown method. extraLatency delays this answer on top of latency,
+    // deferred means it gets answered later.
+    virtual QByteArray handleMethod(QLocalSocket *socket, const QString &method, const QJsonValue &id,
+                                    const QJsonValue &params, int &extraLatency, bool &deferred);
+
+private slots:
+    void newConnection();
+    void socketReadyRead();
+    void socketDisconnected();
+    void sendDueResponses();
+    void autoPayTimeout();
+
+private:
+    struct PendingResponse {
+        QPointer<QLocalSocket> socket;
+        QByteArray data;
+        qint64 dueAt;
+    };
+
+    struct InvoiceWaiter {
+        QPointer<QLocalSocket> socket;
+        QJsonValue id;
+        QString label;
+        // -1 for waitinvoice, otherwise waitanyinvoice's lastpay_index
+        int lastPayIndex;
+    };
+
+    void handleRequest(QLocalSocket *socket, const QJsonObject &request);
+
+    void respond(QLocalSocket *socket, const QJsonValue &id, const QByteArray &result, int extraLatency = 0);
+    void respondError(QLocalSocket *socket, const QJsonValue &id, int code, const QString &message);
+    void queueResponse(QLocalSocket *socket, const QByteArray &data, int extraLatency);
+
+    QByteArray getInfoJson() const;
+    QByteArray invoiceJson(const MockInvoice &invoice) const;
+    QByteArray createInvoice(const QJsonValue &params, QString &error);
+    QByteArray decodePayJson(const QString &bolt11) const;
+    QByteArray payJson(const QJsonValue &params);
+
+    MockInvoice invoiceAt(int index) const;
+    MockInvoice findInvoice(const QString &label) const;
+    void storeInvoice(const MockInvoice &invoice);
+    void answerInvoiceWaiters();
+
+    QString randomHex(quint64 kind, quint64 index, int length) const;
+    quint64 randomValue(quint64 kind, quint64 index) const;
+
+    QLocalServer* m_server;
+    QHash<QLocalSocket*, QByteArray> m_buffers;
+
+    QList<PendingResponse> m_pendingResponses;
+    QHash<QLocalSocket*, qint64> m_lastDueAt;
+    QTimer* m_responseTimer;
+    QElapsedTimer m_clock;
+
+    QList<InvoiceWaiter> m_invoiceWaiters;
+    QStringList m_autoPayQueue;
+
+    // Runtime created or changed invoices, by label
+    QHash<QString, MockInvoice> m_invoiceOverrides;
+    QStringList m_createdInvoices;
+    int m_lastPayIndex;
+    int m_paymentsMade;
+
+    int m_invoiceCount;
+    int m_paymentCount;
+    int m_peerCount;
+    int m_outputCount;
+    int m_nodeCount;
+    int m_latency;
+    int m_latencyJitter;
+    int m_payLatency;
+    int m_autoPayDelay;
+    quint64 m_seed;
+    qint64 m_baseTimestamp;
+
+    int m_requestCount;
+};
+
+#endif // MOCKLIGHTNINGDAEMON_H
@@ -0,0 +1,306 @@
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QTimer>
+
+#include "NfcBenchmark.h"
+#include "LoopbackNfcTransceiver.h"
+#include "NfcHelper.h"
+
+// Latency in ms and packet loss in percent of each case
+static const int linkConditions[][2] = { { 0, 0 }, { 20, 0 }, { 20, 10 } };
+static const int deliveryTimeout = 5000;
+static const int tunnelTimeout = 60 * 1000;
+// Keeps a reply from the emulated phone within NfcHelper's response buffer
+static const int phoneChunkSize = 256;
+
+static QString syntheticBolt11()
+{
+    // About the size of a mainnet invoice with a short description and a route hint
+    static const char bech32Chars[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+    QString bolt11 = "lnbc100u1";
+    for (int i = 0; i < 350; i++) {
+        bolt11.append(QChar(bech32Chars[(i * 7 + 3) % 32]));
+    }
+    return bolt11;
+}
+
+NfcBenchmark::NfcBenchmark(QObject *parent) : QObject(parent)
+{
+    m_iterations = 10;
+    m_tunnelBytes = 4096;
+
+    m_nfcHelper = nullptr;
+    m_transceiver = nullptr;
+    m_lightningServer = nullptr;
+    m_lightningSocket = nullptr;
+
+    m_delivered = false;
+    m_deliveryTime = 0;
+}
+
+int NfcBenchmark::iterations() const
+{
+    return m_iterations;
+}
+
+void NfcBenchmark::setIterations(int iterations)
+{
+    m_iterations = qMax(1, iterations);
+}
+
+int NfcBenchmark::tunnelBytes() const
+{
+    return m_tunnelBytes;
+}
+
+void NfcBenchmark::setTunnelBytes(int tunnelBytes)
+{
+    m_tunnelBytes = qMax(1, tunnelBytes);
+}
+
+QJsonObject NfcBenchmark::run()
+{
+    m_results = QJsonArray();
+
+    // Stands in for lightningd's listener on the other end of the tunnel
+    m_lightningServer = new QLocalServer(this);
+    QString serverName = "presto-nfc-benchmark-" + QString::number(QCoreApplication::applicationPid());
+    QLocalServer::removeServer(serverName);
+    bool listening = m_lightningServer->listen(serverName);
+    if (listening) {
+        connect(m_lightningServer, &QLocalServer::newConnection, this, &NfcBenchmark::newConnection);
+    }
+    else {
+        qDebug() << "Couldn't listen on" << serverName << m_lightningServer->errorString() << "skipping the tunnel";
+    }
+
+    for (unsigned int i = 0; i < sizeof(linkConditions) / sizeof(linkConditions[0]); i++) {
+        int latency = linkConditions[i][0];
+        int packetLossPercent = linkConditions[i][1];
+        qDebug() << "Benchmarking NFC at" << latency << "ms latency," << packetLossPercent << "% packet loss";
+
+        benchmarkDelivery(latency, packetLossPercent);
+        if (listening) {
+            benchmarkTunnel(latency, packetLossPercent);
+        }
+    }
+
+    delete m_lightningServer;
+    m_lightningServer = nullptr;
+
+    QJsonObject resultsObject;
+    resultsObject.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    resultsObject.insert("qtVersion", QString(qVersion()));
+    resultsObject.insert("cpuArchitecture", QSysInfo::currentCpuArchitecture());
+    resultsObject.insert("productType", QSysInfo::prettyProductName());
+    resultsObject.insert("results", m_results);
+    return resultsObject;
+}
+
+bool NfcBenchmark::writeResults(const QJsonObject &results, const QString &filePath) const
+{
+    QSaveFile resultsFile(filePath);
+    if (!resultsFile.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write benchmark results to" << filePath;
+        return false;
+    }
+
+    resultsFile.write(QJsonDocument(results).toJson());
+    return resultsFile.commit();
+}
+
+void NfcBenchmark::setUp(int latency, int packetLossPercent)
+{
+    m_transceiver = new LoopbackNfcTransceiver;
+    m_transceiver->setLatency(latency);
+    m_transceiver->setPacketLossPercent(packetLossPercent);
+
+    // Takes ownership of the transceiver
+    m_nfcHelper = new NfcHelper(m_transceiver);
+    m_nfcHelper->setBolt11(syntheticBolt11());
+    if (m_lightningServer) {
+        m_nfcHelper->setLightningSocket(m_lightningServer->fullServerName());
+    }
+    connect(m_nfcHelper, &NfcHelper::bolt11Delivered, this, &NfcBenchmark::bolt11Delivered);
+}
+
+void NfcBenchmark::tearDown()
+{
+    delete m_nfcHelper;
+    m_nfcHelper = nullptr;
+    m_transceiver = nullptr;
+
+    delete m_lightningSocket;
+    m_lightningSocket = nullptr;
+}
+
+void NfcBenchmark::processEvents(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, SLOT(quit()));
+    loop.exec();
+}
+
+void NfcBenchmark::bolt11Delivered(qint64 elapsedMs)
+{
+    m_delivered = true;
+    m_deliveryTime = elapsedMs;
+}
+
+void NfcBenchmark::newConnection()
+{
+    QLocalSocket* socket = m_lightningServer->nextPendingConnection();
+    if (m_lightningSocket) {
+        // A tap while the tunnel is up reconnects, keep the newest
+        delete m_lightningSocket;
+    }
+    m_lightningSocket = socket;
+}
+
+void NfcBenchmark::benchmarkDelivery(int latency, int packetLossPercent)
+{
+    setUp(latency, packetLossPercent);
+
+    QList<qint64> samples;
+    int failures = 0;
+    for (int i = 0; i < m_iterations; i++) {
+        // Long enough for NfcHelper's polling to see the phone go away
+        m_transceiver->setTagPresent(false);
+        processEvents(250);
+
+        m_delivered = false;
+        m_transceiver->setTagPresent(true);
+
+        QElapsedTimer timer;
+        timer.start();
+        while (!m_delivered && timer.elapsed() < deliveryTimeout) {
+            processEvents(10);
+        }
+
+        if (m_delivered) {
+            samples << m_deliveryTime;
+        }
+        else {
+            // A lost packet fails the whole tap, the customer has to tap again
+            failures++;
+        }
+    }
+
+    tearDown();
+    addResult("nfc.bolt11Delivery", latency, packetLossPercent, samples, failures);
+}
+
+void NfcBenchmark::benchmarkTunnel(int latency, int packetLossPercent)
+{
+    setUp(latency, packetLossPercent);
+
+    // An offline phone asks for a socket when it gets the bolt11. Taps
+    // again until that gets through the packet loss.
+    m_transceiver->setOnline(false);
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_lightningSocket && timer.elapsed() < deliveryTimeout * 4) {
+        m_transceiver->setTagPresent(true);
+        processEvents(deliveryTimeout / 10);
+        if (!m_lightningSocket) {
+            m_transceiver->setTagPresent(false);
+            processEvents(250);
+        }
+    }
+
+    if (!m_lightningSocket) {
+        qDebug() << "NFC tunnel never came up at" << latency << "ms latency," << packetLossPercent << "% packet loss";
+        tearDown();
+        addThroughput("nfc.tunnel.toPhone", latency, packetLossPercent, 0, 0);
+        addThroughput("nfc.tunnel.fromPhone", latency, packetLossPercent, 0, 0);
+        return;
+    }
+
+    // Node to phone
+    m_transceiver->takeReceivedSocketData();
+    m_lightningSocket->write(QByteArray(m_tunnelBytes, 'n'));
+    qint64 received = 0;
+    timer.start();
+    while (received < m_tunnelBytes && timer.elapsed() < tunnelTimeout) {
+        processEvents(10);
+        received += m_transceiver->takeReceivedSocketData().size();
+    }
+    addThroughput("nfc.tunnel.toPhone", latency, packetLossPercent, received, timer.elapsed());
+
+    // Phone to node
+    m_lightningSocket->readAll();
+    qint64 sent = 0;
+    received = 0;
+    timer.start();
+    while (received < m_tunnelBytes && timer.elapsed() < tunnelTimeout) {
+        if (sent < m_tunnelBytes && m_transceiver->queuedSocketDataSize() == 0) {
+            int chunkSize = (int)qMin<qint64>(phoneChunkSize, m_tunnelBytes - sent);
+            m_transceiver->queueSocketData(QByteArray(chunkSize, 'p'));
+            sent += chunkSize;
+        }
+        processEvents(10);
+        if (m_lightningSocket) {
+            received += m_lightningSocket->readAll().size();
+        }
+    }
+    addThroughput("nfc.tunnel.fromPhone", latency, packetLossPercent, received, timer.elapsed());
+
+    tearDown();
+}
+
+void NfcBenchmark::addResult(const QString &name, int latency, int packetLossPercent,
+                             QList<qint64> samples, int failures)
+{
+    QJsonObject result;
+    result.insert("case", name);
+    result.insert("latencyMs", latency);
+    result.insert("packetLossPercent", packetLossPercent);
+    result.insert("iterations", samples.size() + failures);
+    result.insert("failures", failures);
+
+    if (!samples.isEmpty()) {
+        std::sort(samples.begin(), samples.end());
+
+        qint64 total = 0;
+        foreach (qint64 sample, samples) {
+            total += sample;
+        }
+
+        result.insert("minMs", samples.first());
+        result.insert("medianMs", samples.at(samples.size() / 2));
+        result.insert("meanMs", (double)total / samples.size());
+
+        qDebug().nospace() << name << " latency: " << latency << "ms loss: " << packetLossPercent
+                           << "% min: " << samples.first() << "ms median: " << samples.at(samples.size() / 2)
+                           << "ms failures: " << failures;
+    }
+
+    m_results.append(result);
+}
+
+void NfcBenchmark::addThroughput(const QString &name, int latency, int packetLossPercent,
+                                 qint64 bytes, qint64 elapsedMs)
+{
+    double bytesPerSecond = elapsedMs > 0 ? bytes * 1000.0 / elapsedMs : 0;
+
+    QJsonObject result;
+    result.insert("case", name);
+    result.insert("latencyMs", latency);
+    result.insert("packetLossPercent", packetLossPercent);
+    result.insert("bytes", bytes);
+    result.insert("complete", bytes >= m_tunnelBytes);
+    result.insert("elapsedMs", elapsedMs);
+    result.insert("bytesPerSecond", bytesPerSecond);
+    m_results.append(result);
+
+    qDebug().nospace() << name << " latency: " << latency << "ms loss: " << packetLossPercent
+                       << "% " << bytes << " bytes in " << elapsedMs << "ms, " << bytesPerSecond << " bytes/s";
+}
@@ -0,0 +1,68 @@
+#ifndef NFCBENCHMARK_H
+#define NFCBENCHMARK_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+
+class LoopbackNfcTransceiver;
+class NfcHelper;
+
+// Runs NfcHelper against the loopback transceiver: how long a bolt11 takes
+// from tap to delivered, and how fast the socket tunnel moves data each
+// way, at a few link latencies and packet loss rates. No reader or phone
+// needed, so it runs on any Linux box. Results are written as JSON like
+// ModelBenchmark's.
+class NfcBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    NfcBenchmark(QObject *parent = 0);
+
+    // Taps per delivery case
+    int iterations() const;
+    void setIterations(int iterations);
+
+    // Bytes sent through the tunnel each way
+    int tunnelBytes() const;
+    void setTunnelBytes(int tunnelBytes);
+
+    QJsonObject run();
+    bool writeResults(const QJsonObject &results, const QString &filePath) const;
+
+private slots:
+    void bolt11Delivered(qint64 elapsedMs);
+    void newConnection();
+
+private:
+    void benchmarkDelivery(int latency, int packetLossPercent);
+    void benchmarkTunnel(int latency, int packetLossPercent);
+
+    void setUp(int latency, int packetLossPercent);
+    void tearDown();
+    // Lets NfcHelper's tag polling run for ms
+    void processEvents(int ms);
+
+    void addResult(const QString &name, int latency, int packetLossPercent, QList<qint64> samples, int failures);
+    void addThroughput(const QString &name, int latency, int packetLossPercent, qint64 bytes, qint64 elapsedMs);
+
+    int m_iterations;
+    int m_tunnelBytes;
+
+    NfcHelper* m_nfcHelper;
+    LoopbackNfcTransceiver* m_transceiver;
+    QLocalServer* m_lightningServer;
+    QLocalSocket* m_lightningSocket;
+
+    bool m_delivered;
+    qint64 m_deliveryTime;
+
+    QJsonArray m_results;
+};
+
+#endif // NFCBENCHMARK_H
@@ -1,38 +1,36 @@
 ﻿#include "NfcHelper.h"
-#include "NfcController.h"
+#include "LoopbackNfcTransceiver.h"
 #include "LightningModel.h"
+#include "Tracer.h"
 #include <QDir>
+#include <QElapsedTimer>
 
-unsigned char SELECT_LIGHTNING[] = {0x00,0xA4,0x04,0x00,0x0A,0xF0, // Select custom AID
-                                    0x4C, // L
-                                    0x49, // I
-                                    0x47, // G
-                                    0x48, // H
-                                    0x54, // T
-                                    0x4E, // N
-                                    0x49, // I
-                                    0x4E, // N
-                                    0x47};// G
-
-unsigned char SELECT_OK[] = {0x90, 0x00};
-unsigned char BOLT11_COMMAND = 0x01; // Followed by BOLT11 string
-unsigned char NFC_SOCKET_COMMAND = 0x02; // Followed by peer ID
-unsigned char BOLT11_RECEIVED_NO_SOCKET = 0x03;
-unsigned char NFC_SOCKET_STREAM = 0x04;
-unsigned char NFC_SOCKET_STREAM_NO_DATA = 0x05;
+#ifdef PRESTO_NXP_NFC
+#include "NxpNfcTransceiver.h"
+#endif
 
 static const int packetSize = 128; // Need to keep this below 189 for some reason
 
 
-NfcHelper::NfcHelper(QObject *parent) : QObject(parent)
+NfcHelper::NfcHelper(NfcTransceiver *transceiver, QObject *parent) : QObject(parent)
 {
+    m_transceiver = transceiver;
+    if (!m_transceiver) {
+#ifdef PRESTO_NXP_NFC
+        m_transceiver = new NxpNfcTransceiver;
+#else
+        qDebug() << "Built without the NXP reader library";
+        m_transceiver = new LoopbackNfcTransceiver;
+#endif
+    }
+
     m_askForSocketData = false;
     m_nfcTagPresentLastState = false;
 
     m_bolt11 = "BROKEN";
     m_lightningLocalSocket = QDir::homePath() + "/.lightning/lightning-listener";
 
-    m_unixSocket = new QLocalSocket();
+    m_unixSocket = new QLocalSocket(this);
 
     QObject::connect(m_unixSocket, SIGNAL(error(QLocalSocket::LocalSocketError)),
                      this, SLOT(unixSocketError(QLocalSocket::LocalSocketError)));
@@ -44,16 +42,19 @@ NfcHelper::NfcHelper(QObject *parent) : QObject(parent)
                      this, &NfcHelper::readyRead);
 
 
-    initializeNfc();
+    m_transceiver->initialize();
 
-    m_tagStatusCheckTimer = new QTimer();
+    m_tagStatusCheckTimer = new QTimer(this);
     m_tagStatusCheckTimer->setSingleShot(false);
     m_tagStatusCheckTimer->setInterval(100);
     connect(m_tagStatusCheckTimer, &QTimer::timeout, this, &NfcHelper::nfcTagStatusCheck);
     m_tagStatusCheckTimer->start();
 
-    connect(LightningModel::instance()->peersModel(), &PeersModel::connectedToPeer,
-            this, &NfcHelper::connectedToPeer);
+    // Not there when benchmarking
+    if (LightningModel::instance()) {
+        connect(LightningModel::instance()->peersModel(), &PeersModel::connectedToPeer,
+                this, &NfcHelper::connectedToPeer);
+    }
 
     m_socketServer = new QLocalServer(this);
     m_socketServer->setSocketOptions(QLocalServer::WorldAccessOption);
@@ -68,6 +69,21 @@ NfcHelper::NfcHelper(QObject *parent) : QObject(parent)
 //    }
 }
 
+NfcHelper::~NfcHelper()
+{
+    delete m_transceiver;
+}
+
+NfcTransceiver *NfcHelper::transceiver() const
+{
+    return m_transceiver;
+}
+
+void NfcHelper::setLightningSocket(const QString &serverName)
+{
+    m_lightningLocalSocket = serverName;
+}
+
 void NfcHelper::setBolt11(const QString &bolt11)
 {
     m_bolt11 = bolt11;
@@ -92,16 +108,24 @@ void NfcHelper::unixSocketDisconnected()
 
 void NfcHelper::onNfcTagArrival()
 {
+    TRACE_SCOPE("nfc", "deliverBolt11");
+
+    QElapsedTimer deliveryTimer;
+    deliveryTimer.start();
+
     unsigned char response[2];
-    int res = nfcTag_transceive(currentTagInfo.handle, SELECT_LIGHTNING, sizeof(SELECT_LIGHTNING), response, sizeof(response), 2000);
+    int res = m_transceiver->transceive(SELECT_LIGHTNING, sizeof(SELECT_LIGHTNING), response, sizeof(response), 2000);
     if (res == 0) {
         qDebug() << "NFC transcieve failure!";
     }
     else {
         qDebug() << "NFC received: " << response[0] << response[1];
-        if (memcmp(response, SELECT_OK, sizeof(res))){
+        if (res >= (int)sizeof(SELECT_OK) && memcmp(response, SELECT_OK, sizeof(SELECT_OK)) == 0) {
             qDebug() << "NFC device has lightning support, sending BOLT11";
-            sendBolt11ToHceDevice();
+            if (sendBolt11ToHceDevice()) {
+                qDebug() << "BOLT11 delivered in" << deliveryTimer.elapsed() << "ms";
+                emit bolt11Delivered(deliveryTimer.elapsed());
+            }
         }
     }
 }
@@ -112,7 +136,7 @@ void NfcHelper::onNfcTagDeparture()
     resetSocketConnection();
 }
 
-void NfcHelper::sendBolt11ToHceDevice()
+bool NfcHelper::sendBolt11ToHceDevice()
 {
     QByteArray bolt11Bytes = m_bolt11.toUtf8();
 
@@ -131,10 +155,11 @@ void NfcHelper::sendBolt11ToHceDevice()
         memcpy(&command[3], (unsigned char*)bolt11Chunk.data(), bolt11Chunk.length());
 
         unsigned char response[34];
-        int res = nfcTag_transceive(currentTagInfo.handle, command, sizeof(command), response, sizeof(response), 2000);
+        int res = m_transceiver->transceive(command, sizeof(command), response, sizeof(response), 2000);
 
         if (res == 0) {
             qDebug() << "NFC transcieve failure!";
+            return false;
         }
         else {
             qDebug() << "NFC received: " << response[0];
@@ -151,6 +176,8 @@ void NfcHelper::sendBolt11ToHceDevice()
             }
         }
     }
+
+    return true;
 }
 
 void NfcHelper::connectToLocalSocket()
@@ -205,7 +232,7 @@ void NfcHelper::readyRead()
     memcpy(&command[1], (unsigned char*)buffer.data(), buffer.length());
 
     unsigned char response[512];
-    int res = nfcTag_transceive(currentTagInfo.handle, command, sizeof(command), response, sizeof(response), 2000);
+    int res = m_transceiver->transceive(command, sizeof(command), response, sizeof(response), 2000);
 
     if (res == 0) {
         qDebug() << "NFC socket transcieve failure!";
@@ -215,23 +242,7 @@ void NfcHelper::readyRead()
         if (response[0] == NFC_SOCKET_STREAM) {
             qDebug() << "Socket data received, forwarding";
             //qDebug() << response;
-            QByteArray dataToWrite;
-
-            int i = 1;
-            int size = res;
-
-            while (size >= 0) {
-                dataToWrite.append((char*)&response[i], 55);
-                size -= 55;
-                i += 60; // skip those 5 bytes
-            }
-
-            // Best to fix this on the sender's side
-            // These NFC libs are a real piece of work
-            // TODO: Get libnfc compatible hw
-
-            dataToWrite.resize(res - 1);
-
+            QByteArray dataToWrite((char*)&response[1], res - 1);
             forwardDataToSocket(dataToWrite);
         }
         else if (response[0] == NFC_SOCKET_STREAM_NO_DATA) {
@@ -243,6 +254,7 @@ void NfcHelper::readyRead()
 
 void NfcHelper::nfcTagStatusCheck()
 {
+    bool tagPresent = m_transceiver->tagPresent();
     if(tagPresent != m_nfcTagPresentLastState) {
         m_nfcTagPresentLastState = tagPresent;
         if (m_nfcTagPresentLastState == true) {
@@ -6,15 +6,23 @@
 #include <QLocalSocket>
 #include <QTimer>
 
+#include "NfcTransceiver.h"
+
 class NfcHelper : public QObject
 {
     Q_OBJECT
 public:
-    explicit NfcHelper(QObject *parent = nullptr);
+    explicit NfcHelper(NfcTransceiver *transceiver = nullptr, QObject *parent = nullptr);
+    ~NfcHelper();
 
+    NfcTransceiver *transceiver() const;
 
+    // Where tunneled socket data goes, ~/.lightning/lightning-listener by default
+    void setLightningSocket(const QString &serverName);
 
 private:
+    NfcTransceiver* m_transceiver;
+
     QLocalServer* m_socketServer;
     QLocalSocket* m_socket;
 
@@ -35,7 +43,7 @@ private:
 private:
     void onNfcTagArrival();
     void onNfcTagDeparture();
-    void sendBolt11ToHceDevice();
+    bool sendBolt11ToHceDevice();
     void forwardDataToSocket(QByteArray socketData);
     void resetSocketConnection();
     void connectToLocalSocket();
@@ -53,6 +61,7 @@ private slots:
     void socketDisconnected();
 
 signals:
+    void bolt11Delivered(qint64 elapsedMs);
 
 public slots:
 };
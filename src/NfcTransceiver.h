@@ -0,0 +1,41 @@
+#ifndef NFCTRANSCEIVER_H
+#define NFCTRANSCEIVER_H
+
+// Lightning over NFC protocol, shared by the reader and the HCE emulation
+// See LightningApduService.java for the phone side
+static const unsigned char SELECT_LIGHTNING[] = {0x00,0xA4,0x04,0x00,0x0A,0xF0, // Select custom AID
+                                                 0x4C, // L
+                                                 0x49, // I
+                                                 0x47, // G
+                                                 0x48, // H
+                                                 0x54, // T
+                                                 0x4E, // N
+                                                 0x49, // I
+                                                 0x4E, // N
+                                                 0x47};// G
+
+static const unsigned char SELECT_OK[] = {0x90, 0x00};
+static const unsigned char BOLT11_COMMAND = 0x01; // Followed by BOLT11 string
+static const unsigned char NFC_SOCKET_COMMAND = 0x02; // Followed by peer ID
+static const unsigned char BOLT11_RECEIVED_NO_SOCKET = 0x03;
+static const unsigned char NFC_SOCKET_STREAM = 0x04;
+static const unsigned char NFC_SOCKET_STREAM_NO_DATA = 0x05;
+static const unsigned char DATA_RESPONSE_OK = 0x00;
+static const unsigned char UNKNOWN_COMMAND_RESPONSE = 0xFF;
+
+// Talks APDUs to whatever is on the other side of the NFC link
+class NfcTransceiver
+{
+public:
+    virtual ~NfcTransceiver() {}
+
+    virtual bool initialize() = 0;
+    virtual bool tagPresent() const = 0;
+
+    // Returns the number of bytes written to response, 0 on failure
+    virtual int transceive(const unsigned char *command, int commandLength,
+                           unsigned char *response, int responseLength,
+                           int timeout) = 0;
+};
+
+#endif // NFCTRANSCEIVER_H
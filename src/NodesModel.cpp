@@ -1,8 +1,10 @@
 #include "NodesModel.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
 #include "macros.h"
+#include "RpcDiagnostics.h"
+#include "Tracer.h"
 
-NodesModel::NodesModel(QJsonRpcSocket *rpcSocket)
+NodesModel::NodesModel(RpcConnectionPool *rpcSocket)
 {
     m_rpcSocket = rpcSocket;
     m_nodes = QList<Node>();
@@ -17,6 +19,7 @@ void NodesModel::updateNodes()
 void NodesModel::updateNodesRequestFinished()
 {
     GET_MESSAGE_DISCONNECT_SLOT(message, &NodesModel::updateNodesRequestFinished)
+    RpcApplyTimer applyTimer("listnodes");
     if (message.type() == QJsonRpcMessage::Response)
     {
         QJsonObject jsonObject = message.toObject();
@@ -31,6 +34,8 @@ void NodesModel::updateNodesRequestFinished()
 
 void NodesModel::populateNodesFromJson(QJsonArray jsonArray)
 {
+    TRACE_SCOPE("model", "populateNodesFromJson");
+
     m_nodes.clear();
 
     foreach (const QJsonValue &v, jsonArray)
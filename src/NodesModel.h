@@ -3,7 +3,7 @@
 
 #include <QObject>
 
-#include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
+#include "RpcConnectionPool.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
 
 class NodeAddress
@@ -64,7 +64,7 @@ class NodesModel : public QObject
 {
     Q_OBJECT
 public:
-    NodesModel(QJsonRpcSocket *rpcSocket);
+    NodesModel(RpcConnectionPool *rpcSocket);
     void updateNodes();
 
     QList<Node> getNodes() const;
@@ -72,12 +72,12 @@ public:
 private slots:
     void updateNodesRequestFinished();
 
-private:
+public:
     void populateNodesFromJson(QJsonArray jsonArray);
 
 private:
     QList<Node> m_nodes;
-    QJsonRpcSocket* m_rpcSocket;
+    RpcConnectionPool* m_rpcSocket;
 };
 
 #endif // NODESMODEL_H
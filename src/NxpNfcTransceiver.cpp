@@ -0,0 +1,56 @@
+#include <QDebug>
+#include <QByteArray>
+
+#include "NxpNfcTransceiver.h"
+#include "NfcController.h"
+#include "Tracer.h"
+
+NxpNfcTransceiver::NxpNfcTransceiver()
+{
+
+}
+
+bool NxpNfcTransceiver::initialize()
+{
+    initializeNfc();
+    return nfcManager_isNfcActive();
+}
+
+bool NxpNfcTransceiver::tagPresent() const
+{
+    return ::tagPresent;
+}
+
+int NxpNfcTransceiver::transceive(const unsigned char *command, int commandLength,
+                                  unsigned char *response, int responseLength,
+                                  int timeout)
+{
+    TRACE_SCOPE("nfc", "transceive");
+
+    int res = nfcTag_transceive(currentTagInfo.handle,
+                                const_cast<unsigned char*>(command), commandLength,
+                                response, responseLength, timeout);
+
+    if (res > 1 && response[0] == NFC_SOCKET_STREAM) {
+        // The NXP stack hands socket data over in 60 byte strides
+        // with 5 bytes of junk at the end of each one
+        // Best to fix this on the sender's side
+        // These NFC libs are a real piece of work
+        // TODO: Get libnfc compatible hw
+        QByteArray payload;
+
+        int i = 1;
+        int size = res;
+
+        while (size >= 0 && i < responseLength) {
+            payload.append((char*)&response[i], qMin(55, responseLength - i));
+            size -= 55;
+            i += 60; // skip those 5 bytes
+        }
+
+        payload.resize(res - 1);
+        memcpy(&response[1], payload.constData(), res - 1);
+    }
+
+    return res;
+}
@@ -0,0 +1,19 @@
+#ifndef NXPNFCTRANSCEIVER_H
+#define NXPNFCTRANSCEIVER_H
+
+#include "NfcTransceiver.h"
+
+// Real reader hardware through linux_libnfc-nci
+class NxpNfcTransceiver : public NfcTransceiver
+{
+public:
+    NxpNfcTransceiver();
+
+    bool initialize();
+    bool tagPresent() const;
+    int transceive(const unsigned char *command, int commandLength,
+                   unsigned char *response, int responseLength,
+                   int timeout);
+};
+
+#endif // NXPNFCTRANSCEIVER_H
@@ -1,59 +1,34 @@
 #include "PaymentsModel.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
 #include "macros.h"
-
-QHash<int, QByteArray> PaymentsModel::roleNames() const {
-    QHash<int, QByteArray> roles;
-    roles[HashRole] = "hash";
-    roles[IncomingRole] = "incoming";
-    roles[MSatoshiRole] = "msatoshi";
-    roles[TimestampRole] = "timestamp";
-    roles[DestinationRole] = "destination";
-    roles[PaymentIdRole] = "paymentid";
-    roles[PaymentStatusRole] = "paymentstatus";
-    roles[PaymentStatusStringRole] = "paymentstatusstring";
-    return roles;
-}
-
-PaymentsModel::PaymentsModel(QJsonRpcSocket *rpcSocket)
+#include "RpcDiagnostics.h"
+#include "Tracer.h"
+
+static constexpr KeyedListModelField<Payment> paymentFields[] = {
+    KEYED_FIELD(Payment, PaymentsModel::HashRole, "hash", hash),
+    KEYED_FIELD(Payment, PaymentsModel::IncomingRole, "incoming", incoming),
+    KEYED_FIELD(Payment, PaymentsModel::MSatoshiRole, "msatoshi", msatoshi),
+    KEYED_FIELD(Payment, PaymentsModel::TimestampRole, "timestamp", timestamp),
+    KEYED_FIELD(Payment, PaymentsModel::DestinationRole, "destination", destination),
+    KEYED_FIELD(Payment, PaymentsModel::PaymentIdRole, "paymentid", id),
+    KEYED_FIELD(Payment, PaymentsModel::PaymentStatusRole, "paymentstatus", status),
+    KEYED_FIELD(Payment, PaymentsModel::PaymentStatusStringRole, "paymentstatusstring", statusString)
+};
+
+PaymentsModel::PaymentsModel(RpcConnectionPool *rpcSocket)
+    : KeyedListModel<Payment, QString>(paymentFields, &PaymentsModel::paymentKey)
 {
     m_rpcSocket = rpcSocket;
-    m_payments = QList<Payment>();
 
     setMaxFeePercent(100);
 }
 
-
-
-int PaymentsModel::rowCount(const QModelIndex & parent) const
+QString PaymentsModel::paymentKey(const Payment &payment)
 {
-    Q_UNUSED(parent);
-    return m_payments.count();
-}
-
-QVariant PaymentsModel::data(const QModelIndex &index, int role) const
-{
-    if (index.row() < 0 || index.row() >= m_payments.count())
-        return QVariant();
-
-    const Payment &payment = m_payments[index.row()];
-    if (role == HashRole)
+    // Only older daemons leave out the id
+    if (payment.id().isEmpty())
         return payment.hash();
-    else if (role == IncomingRole)
-        return payment.incoming();
-    else if (role == MSatoshiRole)
-        return payment.msatoshi();
-    else if (role == TimestampRole)
-        return payment.timestamp();
-    else if (role == DestinationRole)
-        return payment.destination();
-    else if (role == PaymentIdRole)
-        return payment.id();
-    else if (role == PaymentStatusRole)
-        return payment.status();
-    else if (role == PaymentStatusStringRole)
-        return payment.statusString();
-    return QVariant();
+    return payment.id();
 }
 
 void PaymentsModel::updatePayments()
@@ -65,6 +40,7 @@ void PaymentsModel::updatePayments()
 void PaymentsModel::listPaymentsRequestFinished()
 {
     GET_MESSAGE_DISCONNECT_SLOT(message, &PaymentsModel::listPaymentsRequestFinished)
+    RpcApplyTimer applyTimer("listpayments");
     if (message.type() == QJsonRpcMessage::Response)
     {
         QJsonObject jsonObject = message.toObject();
@@ -164,27 +140,35 @@ void PaymentsModel::payRequestFinished()
 
 void PaymentsModel::populatePaymentsFromJson(QJsonArray jsonArray)
 {
-    m_payments.clear();
-    endResetModel();
+    TRACE_SCOPE("model", "populatePaymentsFromJson");
 
+    QVector<Payment> payments;
+    payments.reserve(jsonArray.size());
     foreach (const QJsonValue &v, jsonArray)
     {
-        beginInsertRows(QModelIndex(), rowCount(), rowCount());
-
         QJsonObject PaymentJsonObject = v.toObject();
         Payment payment;
-        payment.setId(PaymentJsonObject.value("id").toString());
+        // The id is a number, toString() would give an empty string
+        payment.setId(PaymentJsonObject.value("id").toVariant().toString());
         payment.setIncoming(PaymentJsonObject.value("incoming").toBool());
-        payment.setMsatoshi(PaymentJsonObject.value("msatoshi").toInt());
+        // Doubles are exact up to 2^53 msat, toInt() gives 0 above 21 mBTC
+        payment.setMsatoshi((qint64)PaymentJsonObject.value("msatoshi").toDouble());
         payment.setTimestamp(PaymentJsonObject.value("timestamp").toInt());
         payment.setDestination(PaymentJsonObject.value("destination").toString()); // TODO: Figure out why addresses are in an array
         payment.setHash(PaymentJsonObject.value("payment_hash").toString());
-        payment.setStatus((Payment::PaymentStatus)PaymentJsonObject.value("status").toInt()); // TODO: Fix this
-        payment.setStatusString(PaymentJsonObject.value("status").toString());
-        m_payments.append(payment);
 
-        endInsertRows();
+        QString status = PaymentJsonObject.value("status").toString();
+        if (status == "complete")
+            payment.setStatus(Payment::PAYMENT_COMPLETE);
+        else if (status == "failed")
+            payment.setStatus(Payment::PAYMENT_FAILED);
+        else
+            payment.setStatus(Payment::PAYMENT_PENDING);
+        payment.setStatusString(status);
+        payments.append(payment);
     }
+
+    setRecords(payments);
 }
 
 int PaymentsModel::maxFeePercent() const
@@ -217,12 +201,12 @@ void Payment::setIncoming(bool incoming)
     m_incoming = incoming;
 }
 
-int Payment::msatoshi() const
+qint64 Payment::msatoshi() const
 {
     return m_msatoshi;
 }
 
-void Payment::setMsatoshi(int msatoshi)
+void Payment::setMsatoshi(qint64 msatoshi)
 {
     m_msatoshi = msatoshi;
 }
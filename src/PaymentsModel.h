@@ -4,14 +4,20 @@
 #include <QObject>
 #include <QAbstractItemModel>
 
-#include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
+#include "KeyedListModel.h"
+#include "RpcConnectionPool.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
 
 class Payment
 {
 public:
     Payment()
-    {}
+    {
+        m_incoming = false;
+        m_msatoshi = 0;
+        m_timestamp = 0;
+        m_status = PAYMENT_PENDING;
+    }
 
     // Copied over from c-lightning
     enum PaymentStatus {
@@ -26,8 +32,8 @@ public:
     bool incoming() const;
     void setIncoming(bool incoming);
 
-    int msatoshi() const;
-    void setMsatoshi(int msatoshi);
+    qint64 msatoshi() const;
+    void setMsatoshi(qint64 msatoshi);
 
     int timestamp() const;
     void setTimestamp(int timestamp);
@@ -47,7 +53,7 @@ public:
 private:
     QString m_hash;
     bool m_incoming;
-    int m_msatoshi;
+    qint64 m_msatoshi;
     int m_timestamp;
     QString m_destination;
     QString m_id;
@@ -55,7 +61,7 @@ private:
     QString m_statusString;
 };
 
-class PaymentsModel : public QAbstractListModel
+class PaymentsModel : public KeyedListModel<Payment, QString>
 {
     Q_OBJECT
 public:
@@ -70,12 +76,7 @@ public:
         PaymentStatusStringRole
     };
 
-    PaymentsModel(QJsonRpcSocket* rpcSocket = 0);
-
-    QHash<int, QByteArray> roleNames() const;
-
-    int rowCount(const QModelIndex & parent = QModelIndex()) const;
-    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    PaymentsModel(RpcConnectionPool* rpcSocket = 0);
 
     void updatePayments();
 
@@ -100,12 +101,13 @@ signals:
     void paymentPreimageReceived(QString preimage);
     void errorString(QString error);
 
-private:
+public:
     void populatePaymentsFromJson(QJsonArray jsonObject);
 
 private:
-    QList<Payment> m_payments;
-    QJsonRpcSocket* m_rpcSocket;
+    static QString paymentKey(const Payment &payment);
+
+    RpcConnectionPool* m_rpcSocket;
 
     int m_maxFeePercent;
     QString m_lastBolt11DecodeAttempt;
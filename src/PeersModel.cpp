@@ -1,24 +1,31 @@
 #include "PeersModel.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
 #include "macros.h"
-
-QHash<int, QByteArray> PeersModel::roleNames() const {
-    QHash<int, QByteArray> roles;
-    roles[ChannelRole] = "channel";
-    roles[ConnectedRole] = "connected";
-    roles[MSatoshiToUsRole] = "msatoshitous";
-    roles[MSatoshiTotalRole] = "msatoshitotal";
-    roles[NetAddressRole] = "netaddress";
-    roles[PeerIdRole] = "peerid";
-    roles[PeerStateRole] = "peerstate";
-    roles[PeerStateStringRole] = "peerstatestring";
-    return roles;
+#include "RpcDiagnostics.h"
+#include "Tracer.h"
+
+static constexpr KeyedListModelField<Peer> peerFields[] = {
+    KEYED_FIELD(Peer, PeersModel::ChannelRole, "channel", channel),
+    KEYED_FIELD(Peer, PeersModel::ConnectedRole, "connected", connected),
+    KEYED_FIELD(Peer, PeersModel::MSatoshiToUsRole, "msatoshitous", msatoshiToUs),
+    KEYED_FIELD(Peer, PeersModel::MSatoshiTotalRole, "msatoshitotal", msatoshiTotal),
+    KEYED_FIELD(Peer, PeersModel::NetAddressRole, "netaddress", netAddress),
+    KEYED_FIELD(Peer, PeersModel::PeerIdRole, "peerid", id),
+    KEYED_FIELD(Peer, PeersModel::PeerStateRole, "peerstate", state),
+    KEYED_FIELD(Peer, PeersModel::PeerStateStringRole, "peerstatestring", stateString)
+};
+
+PeersModel::PeersModel(RpcConnectionPool *rpcSocket)
+    : KeyedListModel<Peer, QString>(peerFields, &PeersModel::peerKey)
+{
+    m_rpcSocket = rpcSocket;
+    m_spendableMsatoshi = 0;
+    m_receivableMsatoshi = 0;
 }
 
-PeersModel::PeersModel(QJsonRpcSocket *rpcSocket)
+QString PeersModel::peerKey(const Peer &peer)
 {
-    m_rpcSocket = rpcSocket;
-    m_peers = QMap<QString, Peer>();
+    return peer.id();
 }
 
 void PeersModel::updatePeers()
@@ -30,6 +37,7 @@ void PeersModel::updatePeers()
 void PeersModel::listPeersRequestFinished()
 {
     GET_MESSAGE_DISCONNECT_SLOT(message, &PeersModel::listPeersRequestFinished)
+    RpcApplyTimer applyTimer("listpeers");
     if (message.type() == QJsonRpcMessage::Response)
     {
         QJsonObject jsonObject = message.toObject();
@@ -117,14 +125,11 @@ void PeersModel::closeChannel(QString peerId)
     QJsonObject paramsObject;
     paramsObject.insert("id", peerId);
 
-    foreach (Peer peer, m_peers) {
-        if (peer.id() == peerId) {
-            if (peer.stateString().isEmpty()) {
-                QJsonRpcMessage message = QJsonRpcMessage::createRequest("disconnect", paramsObject);
-                SEND_MESSAGE_CONNECT_SLOT(message, &PeersModel::disconnectRequestFinished)
-                return;
-            }
-        }
+    int row = rowOfKey(peerId);
+    if (row >= 0 && records().at(row).stateString().isEmpty()) {
+        QJsonRpcMessage message = QJsonRpcMessage::createRequest("disconnect", paramsObject);
+        SEND_MESSAGE_CONNECT_SLOT(message, &PeersModel::disconnectRequestFinished)
+        return;
     }
 
     QJsonRpcMessage message = QJsonRpcMessage::createRequest("close", paramsObject);
@@ -169,59 +174,15 @@ void PeersModel::disconnectRequestFinished()
     }
 }
 
-int PeersModel::rowCount(const QModelIndex & parent) const
-{
-    Q_UNUSED(parent);
-    return m_peers.count();
-}
-
-QVariant PeersModel::data(const QModelIndex &index, int role) const
-{
-    if (index.row() < 0 || index.row() >= m_peers.count())
-        return QVariant();
-
-    const Peer &peer = m_peers[m_peers.keys()[index.row()]];
-    if (role == ChannelRole)
-        return peer.channel();
-    else if (role == ConnectedRole)
-        return peer.connected();
-    else if (role == MSatoshiToUsRole)
-        return peer.msatoshiToUs();
-    else if (role == MSatoshiTotalRole)
-        return peer.msatoshiTotal();
-    else if (role == NetAddressRole)
-        return peer.netAddress();
-    else if (role == PeerIdRole)
-        return peer.id();
-    else if (role == PeerStateRole)
-        return peer.state();
-    else if (role == PeerStateStringRole)
-        return peer.stateString();
-    return QVariant();
-}
-
 void PeersModel::populatePeersFromJson(QJsonArray jsonArray)
 {
-    // Let's make a list of ids from JSON
-    QStringList jsonIds;
-    foreach (const QJsonValue &v, jsonArray) {
-        QJsonObject peerJsonObject = v.toObject();
-        jsonIds.append(peerJsonObject.value("id").toString());
-    }
-
-    // Remove the ones not in JSON
-    foreach (QString id, m_peers.keys()) {
-            if (!jsonIds.contains(id)) {
-            // not there remove his
-            beginRemoveRows(QModelIndex(),
-                            m_peers.keys().indexOf(id),
-                            m_peers.keys().indexOf(id));
-            m_peers.remove(id);
-            endRemoveRows();
-        }
-    }
+    TRACE_SCOPE("model", "populatePeersFromJson");
 
+    qint64 previousSpendable = m_spendableMsatoshi;
+    qint64 previousReceivable = m_receivableMsatoshi;
 
+    QVector<Peer> peers;
+    peers.reserve(jsonArray.size());
     foreach (const QJsonValue &v, jsonArray)
     {
         QJsonObject peerJsonObject = v.toObject();
@@ -235,9 +196,11 @@ void PeersModel::populatePeersFromJson(QJsonArray jsonArray)
         QJsonArray channelsJsonArray = peerJsonObject.value("channels").toArray();
         // FIX: Store the whole array somehow
 
-        // FIX: msatoshi stuff probably needs to be a long rather than an int
-        peer.setMsatoshiToUs(channelsJsonArray[0].toObject().value("msatoshi_to_us").toInt());
-        peer.setMsatoshiTotal(peerJsonObject.value("msatoshi_total").toInt());
+        QJsonObject channelJsonObject = channelsJsonArray[0].toObject();
+        // Doubles are exact up to 2^53 msat, far beyond any channel
+        peer.setMsatoshiToUs((qint64)channelJsonObject.value("msatoshi_to_us").toDouble());
+        peer.setMsatoshiTotal((qint64)channelJsonObject.value("msatoshi_total")
+                              .toDouble(peerJsonObject.value("msatoshi_total").toDouble()));
 
         QString state = channelsJsonArray[0].toObject().value("state").toString();
         peer.setStateString(state);
@@ -247,34 +210,55 @@ void PeersModel::populatePeersFromJson(QJsonArray jsonArray)
 
         peer.setState((Peer::PeerState)peerJsonObject.value("state").toInt());
 
-        if (m_peers.contains(peer.id())) {
-            m_peers.insert(peer.id(), peer);
-            // TODO: how to call this bastard
-            dataChanged(index(0, 0), index(rowCount() - 1, 0));
-        }
-        else {
-            beginInsertRows(QModelIndex(), rowCount(), rowCount());
-            m_peers.insert(peer.id(), peer);
-            endInsertRows();
-        }
+        peers.append(peer);
     }
 
-    emit totalAvailableFundsChanged();
+    // In the daemon's order, the totals follow through recordAdded() and
+    // recordRemoved()
+    setRecords(peers);
+    emitTotalChanges(previousSpendable, previousReceivable);
+}
+
+void PeersModel::recordAdded(const Peer &peer)
+{
+    addToTotals(peer, 1);
+}
+
+void PeersModel::recordRemoved(const Peer &peer)
+{
+    addToTotals(peer, -1);
+}
 
-    //    else if (m_peers.count() < previousPeerCount) {
-    //        // FIXXX
-    //        //beginRemoveRows(index, 0, previousPeerCount);
-    //        endRemoveRows();
-    //    }
+void PeersModel::addToTotals(const Peer &peer, int sign)
+{
+    m_spendableMsatoshi += sign * peer.msatoshiToUs();
+    m_receivableMsatoshi += sign * qMax(Q_INT64_C(0), peer.msatoshiTotal() - peer.msatoshiToUs());
 }
 
-int PeersModel::totalAvailableFunds()
+void PeersModel::emitTotalChanges(qint64 previousSpendable, qint64 previousReceivable)
 {
-    int sumOfAvailableFunds = 0;
-    foreach (Peer peer, m_peers) {
-        sumOfAvailableFunds += peer.msatoshiToUs();
+    if (m_spendableMsatoshi != previousSpendable) {
+        emit spendableMsatoshiChanged();
+        emit totalAvailableFundsChanged();
+    }
+    if (m_receivableMsatoshi != previousReceivable) {
+        emit receivableMsatoshiChanged();
     }
-    return sumOfAvailableFunds;
+}
+
+qint64 PeersModel::totalAvailableFunds() const
+{
+    return m_spendableMsatoshi;
+}
+
+qint64 PeersModel::spendableMsatoshi() const
+{
+    return m_spendableMsatoshi;
+}
+
+qint64 PeersModel::receivableMsatoshi() const
+{
+    return m_receivableMsatoshi;
 }
 
 QString Peer::channel() const
@@ -297,22 +281,22 @@ void Peer::setConnected(bool connected)
     m_connected = connected;
 }
 
-int Peer::msatoshiToUs() const
+qint64 Peer::msatoshiToUs() const
 {
     return m_msatoshiToUs;
 }
 
-void Peer::setMsatoshiToUs(int msatoshiToUs)
+void Peer::setMsatoshiToUs(qint64 msatoshiToUs)
 {
     m_msatoshiToUs = msatoshiToUs;
 }
 
-int Peer::msatoshiTotal() const
+qint64 Peer::msatoshiTotal() const
 {
     return m_msatoshiTotal;
 }
 
-void Peer::setMsatoshiTotal(int msatoshiTotal)
+void Peer::setMsatoshiTotal(qint64 msatoshiTotal)
 {
     m_msatoshiTotal = msatoshiTotal;
 }
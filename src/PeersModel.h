@@ -4,7 +4,8 @@
 #include <QObject>
 #include <QAbstractItemModel>
 
-#include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
+#include "KeyedListModel.h"
+#include "RpcConnectionPool.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
 
 class Peer
@@ -12,7 +13,10 @@ class Peer
 public:
     Peer()
     {
-
+        m_connected = false;
+        m_msatoshiToUs = 0;
+        m_msatoshiTotal = 0;
+        m_state = UNINITIALIZED;
     }
 
     // Copied over from c-lightning
@@ -45,11 +49,11 @@ public:
     bool connected() const;
     void setConnected(bool connected);
 
-    int msatoshiToUs() const;
-    void setMsatoshiToUs(int msatoshiToUs);
+    qint64 msatoshiToUs() const;
+    void setMsatoshiToUs(qint64 msatoshiToUs);
 
-    int msatoshiTotal() const;
-    void setMsatoshiTotal(int msatoshiTotal);
+    qint64 msatoshiTotal() const;
+    void setMsatoshiTotal(qint64 msatoshiTotal);
 
     QString netAddress() const;
     void setNetAddress(const QString &netAddress);
@@ -66,18 +70,20 @@ public:
 private:
     QString m_channel;
     bool m_connected;
-    int m_msatoshiToUs;
-    int m_msatoshiTotal;
+    qint64 m_msatoshiToUs;
+    qint64 m_msatoshiTotal;
     QString m_netAddress;
     QString m_id;
     PeerState m_state;
     QString m_stateString;
 };
 
-class PeersModel : public QAbstractListModel
+class PeersModel : public KeyedListModel<Peer, QString>
 {
     Q_OBJECT
-    Q_PROPERTY(int totalAvailableFunds READ totalAvailableFunds NOTIFY totalAvailableFundsChanged)
+    Q_PROPERTY(qint64 totalAvailableFunds READ totalAvailableFunds NOTIFY totalAvailableFundsChanged)
+    Q_PROPERTY(qint64 spendableMsatoshi READ spendableMsatoshi NOTIFY spendableMsatoshiChanged)
+    Q_PROPERTY(qint64 receivableMsatoshi READ receivableMsatoshi NOTIFY receivableMsatoshiChanged)
 
 public:
     enum PeerRoles {
@@ -91,21 +97,19 @@ public:
         PeerStateStringRole
     };
 
-    QHash<int, QByteArray> roleNames() const;
-
-
-    PeersModel(QJsonRpcSocket* rpcSocket = 0);
+    PeersModel(RpcConnectionPool* rpcSocket = 0);
     void populatePeersFromJson(QJsonArray jsonArray);
 
-    int rowCount(const QModelIndex & parent = QModelIndex()) const;
-
-    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
-
     void updatePeers();
-    int totalAvailableFunds();
+    // Kept up to date as peers are added, changed and removed (msat)
+    qint64 totalAvailableFunds() const;
+    qint64 spendableMsatoshi() const;
+    qint64 receivableMsatoshi() const;
 
 signals:
     void totalAvailableFundsChanged();
+    void spendableMsatoshiChanged();
+    void receivableMsatoshiChanged();
     void errorString(QString error);
     void connectedToPeer(QString peerId);
     void channelFunded(QString peerId);
@@ -125,8 +129,17 @@ private slots:
     void disconnectRequestFinished();
 
 private:
-    QMap<QString, Peer> m_peers;
-    QJsonRpcSocket* m_rpcSocket;
+    static QString peerKey(const Peer &peer);
+
+    void recordAdded(const Peer &peer);
+    void recordRemoved(const Peer &peer);
+    void addToTotals(const Peer &peer, int sign);
+    void emitTotalChanges(qint64 previousSpendable, qint64 previousReceivable);
+
+    RpcConnectionPool* m_rpcSocket;
+
+    qint64 m_spendableMsatoshi;
+    qint64 m_receivableMsatoshi;
 };
 
 
@@ -0,0 +1,406 @@
+#include <QDateTime>
+#include <QDebug>
+
+#include "PointOfSaleSession.h"
+#include "InvoicesModel.h"
+
+// Typing an amount shouldn't create an invoice per key press
+static const int cartSettleTime = 300;
+static const int speculativeExpiry = 15 * 60;
+static const int pooledExpiry = 60 * 60;
+// Leave the customer this long to pay a prepared invoice (ms)
+static const qint64 expiryMargin = 5 * 60 * 1000;
+static const int poolRefillInterval = 60 * 1000;
+// A customer won't wait longer than this for the invoice (ms)
+static const int checkoutTimeout = 30 * 1000;
+
+PointOfSaleSession::PointOfSaleSession(InvoicesModel *invoicesModel, QObject *parent) : QObject(parent)
+{
+    m_invoicesModel = invoicesModel;
+
+    m_state = Idle;
+    m_checkoutPending = false;
+    m_speculative.expiresAt = 0;
+    m_current.expiresAt = 0;
+    m_invoiceCount = 0;
+
+    m_clock.start();
+    m_checkoutStartedAt = 0;
+    m_lastCheckoutLatency = 0;
+    m_totalCheckoutLatency = 0;
+    m_checkouts = 0;
+    m_speculativeHits = 0;
+    m_speculativeMisses = 0;
+
+    QObject::connect(m_invoicesModel, &InvoicesModel::invoiceCreated, this, &PointOfSaleSession::invoiceCreated);
+    QObject::connect(m_invoicesModel, &InvoicesModel::invoiceCreationFailed,
+                     this, &PointOfSaleSession::invoiceCreationFailed);
+    QObject::connect(m_invoicesModel, &InvoicesModel::invoiceStatusChanged,
+                     this, &PointOfSaleSession::invoiceStatusChanged);
+
+    m_cartTimer = new QTimer(this);
+    m_cartTimer->setInterval(cartSettleTime);
+    m_cartTimer->setSingleShot(true);
+    QObject::connect(m_cartTimer, &QTimer::timeout, this, &PointOfSaleSession::createSpeculativeInvoice);
+
+    m_poolTimer = new QTimer(this);
+    m_poolTimer->setInterval(poolRefillInterval);
+    QObject::connect(m_poolTimer, &QTimer::timeout, this, &PointOfSaleSession::refillPool);
+
+    m_checkoutTimer = new QTimer(this);
+    m_checkoutTimer->setInterval(checkoutTimeout);
+    m_checkoutTimer->setSingleShot(true);
+    QObject::connect(m_checkoutTimer, &QTimer::timeout, this, &PointOfSaleSession::checkoutTimedOut);
+}
+
+PointOfSaleSession::State PointOfSaleSession::state() const
+{
+    return m_state;
+}
+
+QString PointOfSaleSession::label() const
+{
+    return m_current.label;
+}
+
+QString PointOfSaleSession::bolt11() const
+{
+    return m_current.bolt11;
+}
+
+int PointOfSaleSession::lastCheckoutLatency() const
+{
+    return m_lastCheckoutLatency;
+}
+
+int PointOfSaleSession::averageCheckoutLatency() const
+{
+    if (m_checkouts == 0) {
+        return 0;
+    }
+    return (int)(m_totalCheckoutLatency / m_checkouts);
+}
+
+int PointOfSaleSession::speculativeHits() const
+{
+    return m_speculativeHits;
+}
+
+int PointOfSaleSession::speculativeMisses() const
+{
+    return m_speculativeMisses;
+}
+
+QString PointOfSaleSession::itemKey(const QString &amountInMsatoshi, const QString &description)
+{
+    return amountInMsatoshi + '\n' + description;
+}
+
+QString PointOfSaleSession::createInvoice(const QString &amountInMsatoshi, const QString &description,
+                                          int expiryInSeconds)
+{
+    QString label = QString("pos-%1-%2").arg(QDateTime::currentMSecsSinceEpoch()).arg(++m_invoiceCount);
+    m_invoicesModel->addInvoice(label, description, amountInMsatoshi, expiryInSeconds);
+    return label;
+}
+
+void PointOfSaleSession::discard(const PreparedInvoice &invoice)
+{
+    if (invoice.label.isEmpty()) {
+        return;
+    }
+
+    if (invoice.bolt11.isEmpty()) {
+        m_staleLabels.insert(invoice.label);
+    }
+    else {
+        m_invoicesModel->deleteInvoice(invoice.label, "unpaid");
+    }
+}
+
+void PointOfSaleSession::setCart(QString amountInMsatoshi, QString description)
+{
+    if (amountInMsatoshi == m_cartAmount && description == m_cartDescription) {
+        return;
+    }
+    m_cartAmount = amountInMsatoshi;
+    m_cartDescription = description;
+
+    // Whatever we prepared is for a different cart now
+    discard(m_speculative);
+    m_speculative = PreparedInvoice();
+
+    if (m_cartAmount.toLongLong() > 0) {
+        m_cartTimer->start();
+    }
+    else {
+        m_cartTimer->stop();
+    }
+}
+
+void PointOfSaleSession::clearCart()
+{
+    setCart(QString(), QString());
+}
+
+void PointOfSaleSession::createSpeculativeInvoice()
+{
+    if (!m_speculative.label.isEmpty() || m_cartAmount.toLongLong() <= 0) {
+        return;
+    }
+
+    m_speculative.amountInMsatoshi = m_cartAmount;
+    m_speculative.description = m_cartDescription;
+    m_speculative.expiresAt = QDateTime::currentMSecsSinceEpoch() + speculativeExpiry * 1000;
+    m_speculative.label = createInvoice(m_cartAmount, m_cartDescription, speculativeExpiry);
+}
+
+void PointOfSaleSession::checkout()
+{
+    if (m_state == Preparing || m_state == Payable || m_cartAmount.toLongLong() <= 0) {
+        return;
+    }
+
+    m_checkoutStartedAt = m_clock.elapsed();
+    m_cartTimer->stop();
+
+    bool usable = !m_speculative.label.isEmpty()
+            && m_speculative.expiresAt - QDateTime::currentMSecsSinceEpoch() > expiryMargin;
+    if (!usable) {
+        discard(m_speculative);
+        m_speculative = PreparedInvoice();
+        createSpeculativeInvoice();
+    }
+
+    m_current = m_speculative;
+    m_speculative = PreparedInvoice();
+
+    if (usable && !m_current.bolt11.isEmpty()) {
+        m_speculativeHits++;
+        makePayable(m_current);
+    }
+    else {
+        // Still waiting for the daemon, invoiceCreated() takes it from here
+        m_speculativeMisses++;
+        waitForCheckoutInvoice();
+    }
+}
+
+void PointOfSaleSession::setFixedPriceItem(QString amountInMsatoshi, QString description, int count)
+{
+    QString key = itemKey(amountInMsatoshi, description);
+    if (count > 0) {
+        m_poolTargets.insert(key, count);
+        refillPool();
+        m_poolTimer->start();
+        return;
+    }
+
+    m_poolTargets.remove(key);
+    foreach (const PreparedInvoice &invoice, m_pool.take(key)) {
+        discard(invoice);
+    }
+    if (m_poolTargets.isEmpty()) {
+        m_poolTimer->stop();
+    }
+}
+
+void PointOfSaleSession::checkoutFixedPriceItem(QString amountInMsatoshi, QString description)
+{
+    if (m_state == Preparing || m_state == Payable) {
+        return;
+    }
+    m_checkoutStartedAt = m_clock.elapsed();
+
+    QString key = itemKey(amountInMsatoshi, description);
+    QList<PreparedInvoice> &pool = m_pool[key];
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    for (int i = 0; i < pool.size(); i++) {
+        if (!pool.at(i).bolt11.isEmpty() && pool.at(i).expiresAt - now > expiryMargin) {
+            PreparedInvoice invoice = pool.takeAt(i);
+            m_speculativeHits++;
+            makePayable(invoice);
+            refillPool();
+            return;
+        }
+    }
+
+    m_speculativeMisses++;
+    m_current = PreparedInvoice();
+    m_current.amountInMsatoshi = amountInMsatoshi;
+    m_current.description = description;
+    m_current.expiresAt = now + speculativeExpiry * 1000;
+    m_current.label = createInvoice(amountInMsatoshi, description, speculativeExpiry);
+    waitForCheckoutInvoice();
+
+    refillPool();
+}
+
+void PointOfSaleSession::reset()
+{
+    // An unpaid invoice the customer walked away from
+    if (m_state == Preparing || m_state == Payable) {
+        discard(m_current);
+    }
+
+    m_current = PreparedInvoice();
+    m_checkoutPending = false;
+    m_checkoutTimer->stop();
+    setState(Idle);
+}
+
+void PointOfSaleSession::waitForCheckoutInvoice()
+{
+    m_checkoutPending = true;
+    m_checkoutTimer->start();
+    setState(Preparing);
+}
+
+void PointOfSaleSession::checkoutTimedOut()
+{
+    if (!m_checkoutPending) {
+        return;
+    }
+
+    qDebug() << "Checkout invoice took longer than" << checkoutTimeout << "ms";
+    // Deleted if it still turns up
+    discard(m_current);
+    failCheckout();
+}
+
+void PointOfSaleSession::failCheckout()
+{
+    m_checkoutPending = false;
+    m_checkoutTimer->stop();
+    setState(Failed);
+}
+
+void PointOfSaleSession::makePayable(const PreparedInvoice &invoice)
+{
+    m_current = invoice;
+    m_checkoutPending = false;
+    m_checkoutTimer->stop();
+
+    m_lastCheckoutLatency = (int)(m_clock.elapsed() - m_checkoutStartedAt);
+    m_totalCheckoutLatency += m_lastCheckoutLatency;
+    m_checkouts++;
+    emit statisticsChanged();
+
+    setState(Payable);
+    emit payable(m_current.bolt11);
+
+    m_invoicesModel->waitInvoice(m_current.label);
+}
+
+void PointOfSaleSession::setState(State state)
+{
+    if (m_state == state) {
+        return;
+    }
+    m_state = state;
+    emit stateChanged();
+}
+
+void PointOfSaleSession::invoiceCreated(QString label, QString bolt11)
+{
+    if (m_staleLabels.remove(label)) {
+        m_invoicesModel->deleteInvoice(label, "unpaid");
+        return;
+    }
+
+    if (label == m_current.label && m_checkoutPending) {
+        m_current.bolt11 = bolt11;
+        makePayable(m_current);
+        return;
+    }
+
+    if (label == m_speculative.label) {
+        m_speculative.bolt11 = bolt11;
+        return;
+    }
+
+    for (QHash<QString, QList<PreparedInvoice> >::iterator it = m_pool.begin(); it != m_pool.end(); ++it) {
+        for (int i = 0; i < it.value().size(); i++) {
+            if (it.value().at(i).label == label) {
+                it.value()[i].bolt11 = bolt11;
+                return;
+            }
+        }
+    }
+}
+
+void PointOfSaleSession::invoiceCreationFailed(QString label, QString error)
+{
+    if (m_staleLabels.remove(label)) {
+        return;
+    }
+
+    if (label == m_current.label && m_checkoutPending) {
+        qDebug() << "Checkout invoice failed:" << error;
+        failCheckout();
+        return;
+    }
+
+    if (label == m_speculative.label) {
+        // Checkout will try again
+        m_speculative = PreparedInvoice();
+        return;
+    }
+
+    for (QHash<QString, QList<PreparedInvoice> >::iterator it = m_pool.begin(); it != m_pool.end(); ++it) {
+        for (int i = 0; i < it.value().size(); i++) {
+            if (it.value().at(i).label == label) {
+                // Left for the next refill, not retried in a loop
+                it.value().removeAt(i);
+                return;
+            }
+        }
+    }
+}
+
+void PointOfSaleSession::invoiceStatusChanged(QString label, QString status)
+{
+    if (label != m_current.label) {
+        return;
+    }
+
+    if (status == "paid") {
+        setState(Paid);
+        emit paid(label);
+    }
+    else if (status == "expired") {
+        setState(Expired);
+    }
+}
+
+void PointOfSaleSession::refillPool()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    for (QHash<QString, int>::const_iterator it = m_poolTargets.constBegin(); it != m_poolTargets.constEnd(); ++it) {
+        QList<PreparedInvoice> &pool = m_pool[it.key()];
+
+        // Replace the ones about to expire before a customer gets them, and
+        // the ones the daemon never answered for
+        for (int i = pool.size() - 1; i >= 0; i--) {
+            bool expiring = !pool.at(i).bolt11.isEmpty() && pool.at(i).expiresAt - now <= expiryMargin;
+            bool unanswered = pool.at(i).bolt11.isEmpty()
+                    && now - (pool.at(i).expiresAt - pooledExpiry * 1000) > checkoutTimeout;
+            if (expiring || unanswered) {
+                discard(pool.takeAt(i));
+            }
+        }
+
+        QString amountInMsatoshi = it.key().section('\n', 0, 0);
+        QString description = it.key().section('\n', 1);
+        while (pool.size() < it.value()) {
+            PreparedInvoice invoice;
+            invoice.amountInMsatoshi = amountInMsatoshi;
+            invoice.description = description;
+            invoice.expiresAt = now + pooledExpiry * 1000;
+            invoice.label = createInvoice(amountInMsatoshi, description, pooledExpiry);
+            pool.append(invoice);
+        }
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef POINTOFSALESESSION_H
+#define POINTOFSALESESSION_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+class InvoicesModel;
+
+// Drives a checkout so the invoice is ready before the customer is. The
+// invoice for the cart is created while items are still being entered,
+// replaced when the cart changes, and fixed-price items are served from a
+// small pool of invoices created ahead of time.
+class PointOfSaleSession : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(State state READ state NOTIFY stateChanged)
+    Q_PROPERTY(QString label READ label NOTIFY stateChanged)
+    Q_PROPERTY(QString bolt11 READ bolt11 NOTIFY stateChanged)
+    Q_PROPERTY(int lastCheckoutLatency READ lastCheckoutLatency NOTIFY statisticsChanged)
+    Q_PROPERTY(int averageCheckoutLatency READ averageCheckoutLatency NOTIFY statisticsChanged)
+    Q_PROPERTY(int speculativeHits READ speculativeHits NOTIFY statisticsChanged)
+    Q_PROPERTY(int speculativeMisses READ speculativeMisses NOTIFY statisticsChanged)
+
+public:
+    enum State {
+        Idle,
+        // Checked out, waiting for the invoice
+        Preparing,
+        // Customer can pay
+        Payable,
+        Paid,
+        Expired,
+        Failed
+    };
+    Q_ENUM(State)
+
+    PointOfSaleSession(InvoicesModel *invoicesModel, QObject *parent = 0);
+
+    State state() const;
+    QString label() const;
+    QString bolt11() const;
+
+    // Checkout to payable (ms)
+    int lastCheckoutLatency() const;
+    int averageCheckoutLatency() const;
+    // Checkouts that found their invoice already created, or not
+    int speculativeHits() const;
+    int speculativeMisses() const;
+
+public slots:
+    // The cart changed, starts on its invoice once it settles for a moment
+    void setCart(QString amountInMsatoshi, QString description);
+    void clearCart();
+    void checkout();
+
+    // Keeps count invoices for this item ready, 0 stops
+    void setFixedPriceItem(QString amountInMsatoshi, QString description, int count);
+    void checkoutFixedPriceItem(QString amountInMsatoshi, QString description);
+
+    // Back to Idle for the next customer, also gives up on a checkout
+    // still Preparing
+    void reset();
+
+signals:
+    void payable(QString bolt11);
+    void paid(QString label);
+    void stateChanged();
+    void statisticsChanged();
+
+private slots:
+    void createSpeculativeInvoice();
+    void invoiceCreated(QString label, QString bolt11);
+    void invoiceCreationFailed(QString label, QString error);
+    void invoiceStatusChanged(QString label, QString status);
+    void refillPool();
+    void checkoutTimedOut();
+
+private:
+    struct PreparedInvoice {
+        QString label;
+        QString amountInMsatoshi;
+        QString description;
+        QString bolt11;
+        // ms since epoch
+        qint64 expiresAt;
+    };
+
+    static QString itemKey(const QString &amountInMsatoshi, const QString &description);
+
+    QString createInvoice(const QString &amountInMsatoshi, const QString &description, int expiryInSeconds);
+    void discard(const PreparedInvoice &invoice);
+    void makePayable(const PreparedInvoice &invoice);
+    void waitForCheckoutInvoice();
+    void failCheckout();
+    void setState(State state);
+
+    InvoicesModel* m_invoicesModel;
+
+    State m_state;
+    PreparedInvoice m_current;
+    bool m_checkoutPending;
+
+    QString m_cartAmount;
+    QString m_cartDescription;
+    PreparedInvoice m_speculative;
+
+    // Ready and pending invoices per fixed-price item
+    QHash<QString, QList<PreparedInvoice> > m_pool;
+    QHash<QString, int> m_poolTargets;
+    // Discarded while still being created, deleted once they are
+    QSet<QString> m_staleLabels;
+
+    int m_invoiceCount;
+
+    QElapsedTimer m_clock;
+    qint64 m_checkoutStartedAt;
+    int m_lastCheckoutLatency;
+    qint64 m_totalCheckoutLatency;
+    int m_checkouts;
+    int m_speculativeHits;
+    int m_speculativeMisses;
+
+    QTimer* m_cartTimer;
+    QTimer* m_poolTimer;
+    QTimer* m_checkoutTimer;
+};
+
+#endif // POINTOFSALESESSION_H
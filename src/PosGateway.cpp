@@ -0,0 +1,407 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QRegularExpression>
+
+#include "PosGateway.h"
+#include "InvoicesModel.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpclocalserver.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpctcpserver.h"
+
+static const int statisticsInterval = 60 * 1000;
+static const int maxDisconnectedTerminals = 100;
+
+PosGatewayService::PosGatewayService(PosGateway *gateway, QObject *parent) : QJsonRpcService(parent)
+{
+    m_gateway = gateway;
+}
+
+QVariantMap PosGatewayService::hello(QString terminalName, QString token)
+{
+    return m_gateway->hello(currentRequest().socket(), terminalName, token);
+}
+
+QVariantMap PosGatewayService::createInvoice(QString amountInMsatoshi, QString description, int expiryInSeconds)
+{
+    return m_gateway->createInvoice(currentRequest().socket(), amountInMsatoshi, description, expiryInSeconds);
+}
+
+QVariantMap PosGatewayService::invoiceStatus(QString label)
+{
+    return m_gateway->invoiceStatus(currentRequest().socket(), label);
+}
+
+bool PosGatewayService::subscribeAll(bool subscribe)
+{
+    return m_gateway->subscribeAll(currentRequest().socket(), subscribe);
+}
+
+QVariantList PosGatewayService::stats()
+{
+    if (!m_gateway->authorized(currentRequest().socket())) {
+        return QVariantList();
+    }
+    return m_gateway->terminals();
+}
+
+PosGateway::PosGateway(InvoicesModel *invoicesModel, QObject *parent) : QObject(parent)
+{
+    m_invoicesModel = invoicesModel;
+    m_localServer = nullptr;
+    m_tcpServer = nullptr;
+    m_terminalCount = 0;
+    m_invoiceCount = 0;
+    m_clock.start();
+
+    QObject::connect(m_invoicesModel, &InvoicesModel::invoiceCreated, this, &PosGateway::invoiceCreated);
+    QObject::connect(m_invoicesModel, &InvoicesModel::invoiceCreationFailed, this, &PosGateway::invoiceCreationFailed);
+    QObject::connect(m_invoicesModel, &InvoicesModel::invoiceStatusChanged, this, &PosGateway::invoiceStatusChanged);
+
+    m_statisticsTimer = new QTimer(this);
+    m_statisticsTimer->setInterval(statisticsInterval);
+    QObject::connect(m_statisticsTimer, &QTimer::timeout, this, &PosGateway::logStatistics);
+}
+
+void PosGateway::setToken(const QString &token)
+{
+    m_token = token;
+}
+
+bool PosGateway::listenLocal(const QString &serverName)
+{
+    if (!m_localServer) {
+        m_localServer = new QJsonRpcLocalServer(this);
+        m_localServer->addService(new PosGatewayService(this, m_localServer));
+    }
+
+    QLocalServer::removeServer(serverName);
+    if (!m_localServer->listen(serverName)) {
+        qDebug() << "POS gateway couldn't listen on" << serverName << m_localServer->errorString();
+        return false;
+    }
+
+    qDebug() << "POS gateway listening on" << serverName;
+    m_statisticsTimer->start();
+    return true;
+}
+
+bool PosGateway::listenTcp(quint16 port, const QHostAddress &address)
+{
+    // Anyone who can reach the port could fill the wallet with invoices
+    if (m_token.isEmpty()) {
+        qDebug() << "POS gateway needs a token to listen on TCP";
+        return false;
+    }
+
+    if (!m_tcpServer) {
+        m_tcpServer = new QJsonRpcTcpServer(this);
+        m_tcpServer->addService(new PosGatewayService(this, m_tcpServer));
+    }
+
+    if (!m_tcpServer->listen(address, port)) {
+        qDebug() << "POS gateway couldn't listen on" << address.toString() << "port" << port << m_tcpServer->errorString();
+        return false;
+    }
+
+    qDebug() << "POS gateway listening on" << address.toString() << "port" << port;
+    m_statisticsTimer->start();
+    return true;
+}
+
+PosGateway::Terminal &PosGateway::terminal(QJsonRpcAbstractSocket *socket)
+{
+    if (!m_terminals.contains(socket)) {
+        Terminal terminal;
+        terminal.name = QString("terminal-%1").arg(++m_terminalCount);
+        terminal.socket = socket;
+        terminal.authenticated = false;
+        terminal.subscribedToAll = false;
+        terminal.requests = 0;
+        terminal.invoicesCreated = 0;
+        terminal.invoicesFailed = 0;
+        terminal.invoicesPaid = 0;
+        terminal.notificationsSent = 0;
+        terminal.totalCreateLatency = 0;
+        terminal.maxCreateLatency = 0;
+        terminal.connectedAt = QDateTime::currentMSecsSinceEpoch();
+        m_terminals.insert(socket, terminal);
+
+        if (socket) {
+            QObject::connect(socket, &QObject::destroyed, this, &PosGateway::terminalDestroyed);
+        }
+    }
+
+    Terminal &terminal = m_terminals[socket];
+    terminal.requests++;
+    return terminal;
+}
+
+bool PosGateway::authorized(QJsonRpcAbstractSocket *socket) const
+{
+    return m_token.isEmpty() || (m_terminals.contains(socket) && m_terminals.value(socket).authenticated);
+}
+
+QVariantMap PosGateway::unauthorized()
+{
+    QVariantMap result;
+    result.insert("error", QString("unauthorized"));
+    return result;
+}
+
+QString PosGateway::labelPrefix(const QString &terminalName) const
+{
+    return "pos-" + terminalName + '-';
+}
+
+QVariantMap PosGateway::hello(QJsonRpcAbstractSocket *socket, const QString &terminalName, const QString &token)
+{
+    Terminal &helloTerminal = terminal(socket);
+
+    // Same time whatever the token, so it can't be guessed byte by byte
+    QByteArray expected = m_token.toUtf8();
+    QByteArray given = token.toUtf8();
+    int difference = expected.size() ^ given.size();
+    for (int i = 0; i < expected.size(); i++) {
+        difference |= expected.at(i) ^ (i < given.size() ? given.at(i) : 0);
+    }
+    if (difference != 0) {
+        qDebug() << "POS terminal" << terminalName << "gave the wrong token";
+        return unauthorized();
+    }
+    helloTerminal.authenticated = true;
+
+    if (!terminalName.isEmpty()) {
+        helloTerminal.name = terminalName;
+    }
+
+    QVariantMap result;
+    result.insert("terminal", helloTerminal.name);
+    return result;
+}
+
+QVariantMap PosGateway::createInvoice(QJsonRpcAbstractSocket *socket, const QString &amountInMsatoshi,
+                                      const QString &description, int expiryInSeconds)
+{
+    if (!authorized(socket)) {
+        return unauthorized();
+    }
+    Terminal &requestingTerminal = terminal(socket);
+
+    // Unique across terminals and restarts of the gateway, and tells which
+    // terminal it belongs to
+    QString label = labelPrefix(requestingTerminal.name)
+            + QString("%1-%2").arg(QDateTime::currentMSecsSinceEpoch()).arg(++m_invoiceCount);
+
+    TerminalInvoice invoice;
+    invoice.socket = socket;
+    invoice.status = "creating";
+    invoice.requestedAt = m_clock.elapsed();
+    m_invoices.insert(label, invoice);
+
+    m_invoicesModel->addInvoice(label, description, amountInMsatoshi, expiryInSeconds);
+
+    QVariantMap result;
+    result.insert("label", label);
+    return result;
+}
+
+QVariantMap PosGateway::invoiceStatus(QJsonRpcAbstractSocket *socket, const QString &label)
+{
+    if (!authorized(socket)) {
+        return unauthorized();
+    }
+
+    QVariantMap result;
+    result.insert("label", label);
+
+    // The terminal's own, also from before it reconnected under the same name
+    QRegularExpression ownLabel("^" + QRegularExpression::escape(labelPrefix(terminal(socket).name)) + "\\d+-\\d+$");
+    if (!ownLabel.match(label).hasMatch()) {
+        result.insert("status", QString("unknown"));
+        return result;
+    }
+
+    if (m_invoices.contains(label)) {
+        result.insert("status", m_invoices.value(label).status);
+        result.insert("bolt11", m_invoices.value(label).bolt11);
+        return result;
+    }
+
+    // Settled ones are only in the model
+    Invoice invoice = m_invoicesModel->findInvoice(label);
+    if (!invoice.label().isEmpty()) {
+        result.insert("status", invoice.statusString());
+        result.insert("bolt11", invoice.bolt11());
+        return result;
+    }
+
+    result.insert("status", QString("unknown"));
+    return result;
+}
+
+bool PosGateway::subscribeAll(QJsonRpcAbstractSocket *socket, bool subscribe)
+{
+    if (!authorized(socket)) {
+        return false;
+    }
+    terminal(socket).subscribedToAll = subscribe;
+    return subscribe;
+}
+
+QVariantList PosGateway::terminals() const
+{
+    QList<Terminal> allTerminals = m_disconnectedTerminals + m_terminals.values();
+
+    QVariantList terminalList;
+    foreach (const Terminal &terminal, allTerminals) {
+        QVariantMap terminalMap;
+        terminalMap.insert("name", terminal.name);
+        terminalMap.insert("connected", !terminal.socket.isNull());
+        terminalMap.insert("requests", terminal.requests);
+        terminalMap.insert("invoicesCreated", terminal.invoicesCreated);
+        terminalMap.insert("invoicesFailed", terminal.invoicesFailed);
+        terminalMap.insert("invoicesPaid", terminal.invoicesPaid);
+        terminalMap.insert("notificationsSent", terminal.notificationsSent);
+        terminalMap.insert("averageCreateLatency", terminal.invoicesCreated > 0
+                           ? terminal.totalCreateLatency / terminal.invoicesCreated : 0);
+        terminalMap.insert("maxCreateLatency", terminal.maxCreateLatency);
+
+        // Invoices per minute since the terminal first showed up
+        qint64 connectedFor = qMax(Q_INT64_C(1), QDateTime::currentMSecsSinceEpoch() - terminal.connectedAt);
+        terminalMap.insert("invoicesPerMinute", terminal.invoicesCreated * 60000.0 / connectedFor);
+        terminalList.append(terminalMap);
+    }
+    return terminalList;
+}
+
+void PosGateway::notify(const QString &method, const QString &label, const TerminalInvoice &invoice,
+                        const QString &error)
+{
+    QJsonObject params;
+    params.insert("label", label);
+    params.insert("status", invoice.status);
+    params.insert("bolt11", invoice.bolt11);
+    if (!error.isEmpty()) {
+        params.insert("error", error);
+    }
+    QJsonRpcMessage notification = QJsonRpcMessage::createNotification(method, params);
+
+    for (QHash<QJsonRpcAbstractSocket*, Terminal>::iterator it = m_terminals.begin(); it != m_terminals.end(); ++it) {
+        Terminal &terminal = it.value();
+        if (terminal.socket && (it.key() == invoice.socket || terminal.subscribedToAll)) {
+            terminal.socket->notify(notification);
+            terminal.notificationsSent++;
+        }
+    }
+}
+
+void PosGateway::invoiceCreated(QString label, QString bolt11)
+{
+    if (!m_invoices.contains(label)) {
+        return;
+    }
+
+    TerminalInvoice &invoice = m_invoices[label];
+    invoice.bolt11 = bolt11;
+    invoice.status = "unpaid";
+
+    if (m_terminals.contains(invoice.socket)) {
+        Terminal &terminal = m_terminals[invoice.socket];
+        qint64 latency = m_clock.elapsed() - invoice.requestedAt;
+        terminal.invoicesCreated++;
+        terminal.totalCreateLatency += latency;
+        terminal.maxCreateLatency = qMax(terminal.maxCreateLatency, latency);
+    }
+
+    notify("pos.invoiceCreated", label, invoice);
+    emit statisticsChanged();
+
+    // Paid or expired comes back as invoiceStatusChanged
+    m_invoicesModel->waitInvoice(label);
+}
+
+void PosGateway::invoiceCreationFailed(QString label, QString error)
+{
+    if (!m_invoices.contains(label)) {
+        return;
+    }
+    failInvoice(label, error);
+}
+
+void PosGateway::connectionLost()
+{
+    foreach (const QString &label, m_invoices.keys()) {
+        if (m_invoices.value(label).status == "creating") {
+            failInvoice(label, "Lost the connection to lightningd");
+        }
+    }
+}
+
+void PosGateway::failInvoice(const QString &label, const QString &error)
+{
+    TerminalInvoice invoice = m_invoices.take(label);
+    invoice.status = "failed";
+    if (m_terminals.contains(invoice.socket)) {
+        m_terminals[invoice.socket].invoicesFailed++;
+    }
+
+    notify("pos.invoiceStatus", label, invoice, error);
+    emit statisticsChanged();
+}
+
+void PosGateway::invoiceStatusChanged(QString label, QString status)
+{
+    if (!m_invoices.contains(label) || status == "unpaid") {
+        return;
+    }
+
+    TerminalInvoice invoice = m_invoices.take(label);
+    invoice.status = status;
+    if (status == "paid" && m_terminals.contains(invoice.socket)) {
+        m_terminals[invoice.socket].invoicesPaid++;
+    }
+
+    notify("pos.invoiceStatus", label, invoice);
+    emit statisticsChanged();
+}
+
+void PosGateway::terminalDestroyed()
+{
+    // Another socket may get the same address, so it can't stay a key
+    QJsonRpcAbstractSocket *socket = static_cast<QJsonRpcAbstractSocket *>(sender());
+    if (m_terminals.contains(socket)) {
+        Terminal terminal = m_terminals.take(socket);
+
+        // Or the next terminal at that address gets its notifications and counts
+        for (QHash<QString, TerminalInvoice>::iterator it = m_invoices.begin(); it != m_invoices.end(); ++it) {
+            if (it.value().socket == socket) {
+                it.value().socket = nullptr;
+            }
+        }
+
+        qDebug() << "POS terminal" << terminal.name << "disconnected after" << terminal.invoicesCreated << "invoices";
+
+        m_disconnectedTerminals.append(terminal);
+        while (m_disconnectedTerminals.size() > maxDisconnectedTerminals) {
+            m_disconnectedTerminals.removeFirst();
+        }
+    }
+    emit statisticsChanged();
+}
+
+void PosGateway::logStatistics()
+{
+    foreach (const QVariant &terminal, terminals()) {
+        QVariantMap terminalMap = terminal.toMap();
+        if (!terminalMap.value("connected").toBool()) {
+            continue;
+        }
+        qDebug() << "POS terminal" << terminalMap.value("name").toString()
+                 << "invoices:" << terminalMap.value("invoicesCreated").toInt()
+                 << "paid:" << terminalMap.value("invoicesPaid").toInt()
+                 << "average create latency:" << terminalMap.value("averageCreateLatency").toLongLong() << "ms";
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef POSGATEWAY_H
+#define POSGATEWAY_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include "./3rdparty/qjsonrpc/src/qjsonrpcservice.h"
+
+class QJsonRpcAbstractSocket;
+class QJsonRpcLocalServer;
+class QJsonRpcTcpServer;
+class InvoicesModel;
+class PosGateway;
+
+// The "pos" JSON-RPC service, one per server, everything goes to the gateway
+class PosGatewayService : public QJsonRpcService
+{
+    Q_OBJECT
+    Q_CLASSINFO("serviceName", "pos")
+
+public:
+    PosGatewayService(PosGateway *gateway, QObject *parent = 0);
+
+public slots:
+    QVariantMap hello(QString terminalName, QString token);
+    QVariantMap createInvoice(QString amountInMsatoshi, QString description, int expiryInSeconds);
+    QVariantMap invoiceStatus(QString label);
+    bool subscribeAll(bool subscribe);
+    QVariantList stats();
+
+private:
+    PosGateway* m_gateway;
+};
+
+// Lets thin POS terminals share this node. They create invoices over a
+// local socket or TCP and get pos.invoiceCreated and pos.invoiceStatus
+// notifications for them, or for every invoice after subscribeAll. With a
+// token set, a terminal has to say hello with it before anything else.
+class PosGateway : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantList terminals READ terminals NOTIFY statisticsChanged)
+
+public:
+    PosGateway(InvoicesModel *invoicesModel, QObject *parent = 0);
+
+    // Shared by the terminals, required for TCP
+    void setToken(const QString &token);
+
+    bool listenLocal(const QString &serverName);
+    bool listenTcp(quint16 port, const QHostAddress &address = QHostAddress(QHostAddress::LocalHost));
+
+    // Per terminal counts and invoice creation latency
+    QVariantList terminals() const;
+
+    QVariantMap hello(QJsonRpcAbstractSocket *socket, const QString &terminalName, const QString &token);
+    QVariantMap createInvoice(QJsonRpcAbstractSocket *socket, const QString &amountInMsatoshi,
+                              const QString &description, int expiryInSeconds);
+    // Only for invoices the terminal created
+    QVariantMap invoiceStatus(QJsonRpcAbstractSocket *socket, const QString &label);
+    bool subscribeAll(QJsonRpcAbstractSocket *socket, bool subscribe);
+    bool authorized(QJsonRpcAbstractSocket *socket) const;
+
+signals:
+    void statisticsChanged();
+
+public slots:
+    // Invoices still being created fail, the daemon is gone
+    void connectionLost();
+
+private slots:
+    void invoiceCreated(QString label, QString bolt11);
+    void invoiceCreationFailed(QString label, QString error);
+    void invoiceStatusChanged(QString label, QString status);
+    void terminalDestroyed();
+    void logStatistics();
+
+private:
+    struct Terminal {
+        QString name;
+        QPointer<QJsonRpcAbstractSocket> socket;
+        bool authenticated;
+        bool subscribedToAll;
+
+        int requests;
+        int invoicesCreated;
+        int invoicesFailed;
+        int invoicesPaid;
+        int notificationsSent;
+        qint64 totalCreateLatency;
+        qint64 maxCreateLatency;
+        qint64 connectedAt;
+    };
+
+    struct TerminalInvoice {
+        // Null once the terminal is gone, another one may get its address
+        QJsonRpcAbstractSocket* socket;
+        QString bolt11;
+        QString status;
+        qint64 requestedAt;
+    };
+
+    Terminal &terminal(QJsonRpcAbstractSocket *socket);
+    QString labelPrefix(const QString &terminalName) const;
+    static QVariantMap unauthorized();
+    void notify(const QString &method, const QString &label, const TerminalInvoice &invoice,
+                const QString &error = QString());
+    void failInvoice(const QString &label, const QString &error);
+
+    InvoicesModel* m_invoicesModel;
+    QJsonRpcLocalServer* m_localServer;
+    QJsonRpcTcpServer* m_tcpServer;
+    QString m_token;
+
+    QHash<QJsonRpcAbstractSocket*, Terminal> m_terminals;
+    QList<Terminal> m_disconnectedTerminals;
+    // By label, until paid or expired
+    QHash<QString, TerminalInvoice> m_invoices;
+    int m_terminalCount;
+    int m_invoiceCount;
+
+    QElapsedTimer m_clock;
+    QTimer* m_statisticsTimer;
+};
+
+#endif // POSGATEWAY_H
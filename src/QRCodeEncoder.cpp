@@ -0,0 +1,590 @@
+/*
+ * Port to Qt of the QR Code generator library (C++)
+ *
+ * Copyright (c) Project Nayuki. (MIT License)
+ * https://www.nayuki.io/page/qr-code-generator-library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * - The above copyright notice and this permission notice shall be included in
+ *   all copies or substantial portions of the Software.
+ * - The Software is provided "as is", without warranty of any kind, express or
+ *   implied, including but not limited to the warranties of merchantability,
+ *   fitness for a particular purpose and noninfringement. In no event shall the
+ *   authors or copyright holders be liable for any claim, damages or other
+ *   liability, whether in an action of contract, tort or otherwise, arising from,
+ *   out of or in connection with the Software or the use or other dealings in the
+ *   Software.
+ */
+
+#include <QtGlobal>
+#include <climits>
+#include <cstdlib>
+
+#include "QRCodeEncoder.h"
+
+// Indexed by error correction level and version, index 0 is padding
+static const qint8 ECC_CODEWORDS_PER_BLOCK[4][41] = {
+    {-1,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28, 28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30}, // L
+    {-1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26, 26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28}, // M
+    {-1, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30, 28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30}, // Q
+    {-1, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28, 30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30}  // H
+};
+
+static const qint8 NUM_ERROR_CORRECTION_BLOCKS[4][41] = {
+    {-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4,  4,  4,  4,  4,  6,  6,  6,  6,  7,  8,  8,  9,  9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25}, // L
+    {-1, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5,  5,  8,  9,  9, 10, 10, 11, 13, 14, 16, 17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49}, // M
+    {-1, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8,  8, 10, 12, 16, 12, 17, 16, 18, 21, 20, 23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68}, // Q
+    {-1, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25, 25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81}  // H
+};
+
+// Format information bits for L, M, Q and H
+static const int FORMAT_BITS[4] = {1, 0, 3, 2};
+
+static const int PENALTY_N1 = 3;
+static const int PENALTY_N2 = 3;
+static const int PENALTY_N3 = 40;
+static const int PENALTY_N4 = 10;
+
+static bool getBit(int x, int i)
+{
+    return ((x >> i) & 1) != 0;
+}
+
+static int numRawDataModules(int version)
+{
+    int result = (16 * version + 128) * version + 64;
+    if (version >= 2) {
+        int numAlign = version / 7 + 2;
+        result -= (25 * numAlign - 10) * numAlign - 55;
+        if (version >= 7) {
+            result -= 36;
+        }
+    }
+    return result;
+}
+
+static int numDataCodewords(int version, int level)
+{
+    return numRawDataModules(version) / 8
+            - ECC_CODEWORDS_PER_BLOCK[level][version] * NUM_ERROR_CORRECTION_BLOCKS[level][version];
+}
+
+// GF(2^8) with the 0x11D polynomial
+static quint8 gfMultiply(quint8 x, quint8 y)
+{
+    int z = 0;
+    for (int i = 7; i >= 0; i--) {
+        z = (z << 1) ^ ((z >> 7) * 0x11D);
+        z ^= ((y >> i) & 1) * x;
+    }
+    return (quint8)z;
+}
+
+static QByteArray reedSolomonDivisor(int degree)
+{
+    QByteArray result(degree, 0);
+    result[degree - 1] = 1;
+
+    quint8 root = 1;
+    for (int i = 0; i < degree; i++) {
+        for (int j = 0; j < degree; j++) {
+            result[j] = gfMultiply((quint8)result.at(j), root);
+            if (j + 1 < degree) {
+                result[j] = result.at(j) ^ result.at(j + 1);
+            }
+        }
+        root = gfMultiply(root, 0x02);
+    }
+    return result;
+}
+
+static QByteArray reedSolomonRemainder(const QByteArray &data, const QByteArray &divisor)
+{
+    QByteArray result(divisor.size(), 0);
+    for (int i = 0; i < data.size(); i++) {
+        quint8 factor = (quint8)data.at(i) ^ (quint8)result.at(0);
+        result.remove(0, 1);
+        result.append((char)0);
+        for (int j = 0; j < result.size(); j++) {
+            result[j] = result.at(j) ^ gfMultiply((quint8)divisor.at(j), factor);
+        }
+    }
+    return result;
+}
+
+// Draws one symbol of a given version, keeps track of function modules
+class QRCodeBuilder
+{
+public:
+    QRCodeBuilder(int version, int level);
+
+    QRCodeMatrix build(const QByteArray &dataCodewords);
+
+private:
+    bool module(int x, int y) const;
+    void setFunctionModule(int x, int y, bool dark);
+
+    void drawFunctionPatterns();
+    void drawFormatBits(int mask);
+    void drawVersion();
+    void drawFinderPattern(int x, int y);
+    void drawAlignmentPattern(int x, int y);
+    QVector<int> alignmentPatternPositions() const;
+
+    QByteArray addEccAndInterleave(const QByteArray &data) const;
+    void drawCodewords(const QByteArray &data);
+    void applyMask(int mask);
+
+    int penaltyScore() const;
+    int finderPenaltyCountPatterns(const int *runHistory) const;
+    int finderPenaltyTerminateAndCount(bool currentRunColor, int currentRunLength, int *runHistory) const;
+    void finderPenaltyAddHistory(int currentRunLength, int *runHistory) const;
+
+private:
+    int m_version;
+    int m_level;
+    int m_size;
+    QVector<bool> m_modules;
+    QVector<bool> m_isFunction;
+};
+
+QRCodeBuilder::QRCodeBuilder(int version, int level)
+{
+    m_version = version;
+    m_level = level;
+    m_size = version * 4 + 17;
+    m_modules = QVector<bool>(m_size * m_size, false);
+    m_isFunction = QVector<bool>(m_size * m_size, false);
+}
+
+QRCodeMatrix QRCodeBuilder::build(const QByteArray &dataCodewords)
+{
+    drawFunctionPatterns();
+    drawCodewords(addEccAndInterleave(dataCodewords));
+
+    // Pick the mask with the lowest penalty
+    int bestMask = 0;
+    int minPenalty = INT_MAX;
+    for (int mask = 0; mask < 8; mask++) {
+        applyMask(mask);
+        drawFormatBits(mask);
+        int penalty = penaltyScore();
+        if (penalty < minPenalty) {
+            bestMask = mask;
+            minPenalty = penalty;
+        }
+        applyMask(mask); // XOR undoes it
+    }
+
+    applyMask(bestMask);
+    drawFormatBits(bestMask);
+
+    QRCodeMatrix matrix(m_size);
+    for (int y = 0; y < m_size; y++) {
+        for (int x = 0; x < m_size; x++) {
+            matrix.setModule(x, y, module(x, y));
+        }
+    }
+    return matrix;
+}
+
+bool QRCodeBuilder::module(int x, int y) const
+{
+    return m_modules.at(y * m_size + x);
+}
+
+void QRCodeBuilder::setFunctionModule(int x, int y, bool dark)
+{
+    m_modules[y * m_size + x] = dark;
+    m_isFunction[y * m_size + x] = true;
+}
+
+void QRCodeBuilder::drawFunctionPatterns()
+{
+    // Timing patterns
+    for (int i = 0; i < m_size; i++) {
+        setFunctionModule(6, i, i % 2 == 0);
+        setFunctionModule(i, 6, i % 2 == 0);
+    }
+
+    drawFinderPattern(3, 3);
+    drawFinderPattern(m_size - 4, 3);
+    drawFinderPattern(3, m_size - 4);
+
+    QVector<int> alignmentPositions = alignmentPatternPositions();
+    int numAlign = alignmentPositions.size();
+    for (int i = 0; i < numAlign; i++) {
+        for (int j = 0; j < numAlign; j++) {
+            // Skip the three corners taken by finder patterns
+            if (!((i == 0 && j == 0) || (i == 0 && j == numAlign - 1) || (i == numAlign - 1 && j == 0))) {
+                drawAlignmentPattern(alignmentPositions.at(i), alignmentPositions.at(j));
+            }
+        }
+    }
+
+    // Reserve the format area, real bits are drawn after masking
+    drawFormatBits(0);
+    drawVersion();
+}
+
+void QRCodeBuilder::drawFormatBits(int mask)
+{
+    int data = FORMAT_BITS[m_level] << 3 | mask;
+    int remainder = data;
+    for (int i = 0; i < 10; i++) {
+        remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+    }
+    int bits = (data << 10 | remainder) ^ 0x5412;
+
+    // First copy
+    for (int i = 0; i <= 5; i++) {
+        setFunctionModule(8, i, getBit(bits, i));
+    }
+    setFunctionModule(8, 7, getBit(bits, 6));
+    setFunctionModule(8, 8, getBit(bits, 7));
+    setFunctionModule(7, 8, getBit(bits, 8));
+    for (int i = 9; i < 15; i++) {
+        setFunctionModule(14 - i, 8, getBit(bits, i));
+    }
+
+    // Second copy
+    for (int i = 0; i < 8; i++) {
+        setFunctionModule(m_size - 1 - i, 8, getBit(bits, i));
+    }
+    for (int i = 8; i < 15; i++) {
+        setFunctionModule(8, m_size - 15 + i, getBit(bits, i));
+    }
+
+    // Always dark
+    setFunctionModule(8, m_size - 8, true);
+}
+
+void QRCodeBuilder::drawVersion()
+{
+    if (m_version < 7) {
+        return;
+    }
+
+    int remainder = m_version;
+    for (int i = 0; i < 12; i++) {
+        remainder = (remainder << 1) ^ ((remainder >> 11) * 0x1F25);
+    }
+    int bits = m_version << 12 | remainder;
+
+    for (int i = 0; i < 18; i++) {
+        bool bit = getBit(bits, i);
+        int a = m_size - 11 + i % 3;
+        int b = i / 3;
+        setFunctionModule(a, b, bit);
+        setFunctionModule(b, a, bit);
+    }
+}
+
+void QRCodeBuilder::drawFinderPattern(int x, int y)
+{
+    for (int dy = -4; dy <= 4; dy++) {
+        for (int dx = -4; dx <= 4; dx++) {
+            int distance = qMax(std::abs(dx), std::abs(dy));
+            int xx = x + dx;
+            int yy = y + dy;
+            if (0 <= xx && xx < m_size && 0 <= yy && yy < m_size) {
+                setFunctionModule(xx, yy, distance != 2 && distance != 4);
+            }
+        }
+    }
+}
+
+void QRCodeBuilder::drawAlignmentPattern(int x, int y)
+{
+    for (int dy = -2; dy <= 2; dy++) {
+        for (int dx = -2; dx <= 2; dx++) {
+            setFunctionModule(x + dx, y + dy, qMax(std::abs(dx), std::abs(dy)) != 1);
+        }
+    }
+}
+
+QVector<int> QRCodeBuilder::alignmentPatternPositions() const
+{
+    QVector<int> result;
+    if (m_version == 1) {
+        return result;
+    }
+
+    int numAlign = m_version / 7 + 2;
+    int step = (m_version == 32) ? 26 : (m_version * 4 + numAlign * 2 + 1) / (numAlign * 2 - 2) * 2;
+
+    result.append(6);
+    for (int position = m_size - 7; result.size() < numAlign; position -= step) {
+        result.insert(1, position);
+    }
+    return result;
+}
+
+QByteArray QRCodeBuilder::addEccAndInterleave(const QByteArray &data) const
+{
+    int numBlocks = NUM_ERROR_CORRECTION_BLOCKS[m_level][m_version];
+    int blockEccLength = ECC_CODEWORDS_PER_BLOCK[m_level][m_version];
+    int rawCodewords = numRawDataModules(m_version) / 8;
+    int numShortBlocks = numBlocks - rawCodewords % numBlocks;
+    int shortBlockLength = rawCodewords / numBlocks;
+
+    QByteArray divisor = reedSolomonDivisor(blockEccLength);
+
+    QVector<QByteArray> blocks;
+    int k = 0;
+    for (int i = 0; i < numBlocks; i++) {
+        int dataLength = shortBlockLength - blockEccLength + (i < numShortBlocks ? 0 : 1);
+        QByteArray block = data.mid(k, dataLength);
+        k += dataLength;
+
+        QByteArray ecc = reedSolomonRemainder(block, divisor);
+        if (i < numShortBlocks) {
+            // Padding, skipped while interleaving
+            block.append((char)0);
+        }
+        block.append(ecc);
+        blocks.append(block);
+    }
+
+    QByteArray result;
+    result.reserve(rawCodewords);
+    for (int i = 0; i < blocks.at(0).size(); i++) {
+        for (int j = 0; j < blocks.size(); j++) {
+            if (i != shortBlockLength - blockEccLength || j >= numShortBlocks) {
+                result.append(blocks.at(j).at(i));
+            }
+        }
+    }
+    return result;
+}
+
+void QRCodeBuilder::drawCodewords(const QByteArray &data)
+{
+    int i = 0; // Bit index into the data
+
+    // Zigzag through two columns at a time, right to left
+    for (int right = m_size - 1; right >= 1; right -= 2) {
+        if (right == 6) {
+            right = 5; // Skip the vertical timing pattern
+        }
+        for (int vertical = 0; vertical < m_size; vertical++) {
+            for (int j = 0; j < 2; j++) {
+                int x = right - j;
+                bool upward = ((right + 1) & 2) == 0;
+                int y = upward ? m_size - 1 - vertical : vertical;
+                if (!m_isFunction.at(y * m_size + x) && i < data.size() * 8) {
+                    m_modules[y * m_size + x] = getBit((quint8)data.at(i >> 3), 7 - (i & 7));
+                    i++;
+                }
+                // Remainder bits stay light
+            }
+        }
+    }
+}
+
+void QRCodeBuilder::applyMask(int mask)
+{
+    for (int y = 0; y < m_size; y++) {
+        for (int x = 0; x < m_size; x++) {
+            bool invert = false;
+            switch (mask) {
+            case 0: invert = (x + y) % 2 == 0; break;
+            case 1: invert = y % 2 == 0; break;
+            case 2: invert = x % 3 == 0; break;
+            case 3: invert = (x + y) % 3 == 0; break;
+            case 4: invert = (x / 3 + y / 2) % 2 == 0; break;
+            case 5: invert = x * y % 2 + x * y % 3 == 0; break;
+            case 6: invert = (x * y % 2 + x * y % 3) % 2 == 0; break;
+            case 7: invert = ((x + y) % 2 + x * y % 3) % 2 == 0; break;
+            }
+            if (invert && !m_isFunction.at(y * m_size + x)) {
+                m_modules[y * m_size + x] = !m_modules.at(y * m_size + x);
+            }
+        }
+    }
+}
+
+int QRCodeBuilder::penaltyScore() const
+{
+    int result = 0;
+
+    // Runs and finder-like patterns in rows and columns
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < m_size; i++) {
+            bool runColor = false;
+            int runLength = 0;
+            int runHistory[7] = {0, 0, 0, 0, 0, 0, 0};
+            for (int j = 0; j < m_size; j++) {
+                bool color = pass == 0 ? module(j, i) : module(i, j);
+                if (color == runColor) {
+                    runLength++;
+                    if (runLength == 5) {
+                        result += PENALTY_N1;
+                    }
+                    else if (runLength > 5) {
+                        result++;
+                    }
+                }
+                else {
+                    finderPenaltyAddHistory(runLength, runHistory);
+                    if (!runColor) {
+                        result += finderPenaltyCountPatterns(runHistory) * PENALTY_N3;
+                    }
+                    runColor = color;
+                    runLength = 1;
+                }
+            }
+            result += finderPenaltyTerminateAndCount(runColor, runLength, runHistory) * PENALTY_N3;
+        }
+    }
+
+    // 2x2 blocks of the same color
+    for (int y = 0; y < m_size - 1; y++) {
+        for (int x = 0; x < m_size - 1; x++) {
+            bool color = module(x, y);
+            if (color == module(x + 1, y) && color == module(x, y + 1) && color == module(x + 1, y + 1)) {
+                result += PENALTY_N2;
+            }
+        }
+    }
+
+    // Balance of dark and light modules
+    int dark = 0;
+    foreach (bool color, m_modules) {
+        if (color) {
+            dark++;
+        }
+    }
+    int total = m_size * m_size;
+    int k = (std::abs(dark * 20 - total * 10) + total - 1) / total - 1;
+    result += k * PENALTY_N4;
+
+    return result;
+}
+
+int QRCodeBuilder::finderPenaltyCountPatterns(const int *runHistory) const
+{
+    int n = runHistory[1];
+    bool core = n > 0 && runHistory[2] == n && runHistory[3] == n * 3 && runHistory[4] == n && runHistory[5] == n;
+    return (core && runHistory[0] >= n * 4 && runHistory[6] >= n ? 1 : 0)
+            + (core && runHistory[6] >= n * 4 && runHistory[0] >= n ? 1 : 0);
+}
+
+int QRCodeBuilder::finderPenaltyTerminateAndCount(bool currentRunColor, int currentRunLength, int *runHistory) const
+{
+    if (currentRunColor) {
+        finderPenaltyAddHistory(currentRunLength, runHistory);
+        currentRunLength = 0;
+    }
+    currentRunLength += m_size; // Light border after the last run
+    finderPenaltyAddHistory(currentRunLength, runHistory);
+    return finderPenaltyCountPatterns(runHistory);
+}
+
+void QRCodeBuilder::finderPenaltyAddHistory(int currentRunLength, int *runHistory) const
+{
+    if (runHistory[0] == 0) {
+        currentRunLength += m_size; // Light border before the first run
+    }
+    for (int i = 6; i > 0; i--) {
+        runHistory[i] = runHistory[i - 1];
+    }
+    runHistory[0] = currentRunLength;
+}
+
+QRCodeEncoder::ErrorCorrectionLevel QRCodeEncoder::levelFromString(const QString &level)
+{
+    QString upperLevel = level.toUpper();
+    if (upperLevel == "M") return LevelM;
+    else if (upperLevel == "Q") return LevelQ;
+    else if (upperLevel == "H") return LevelH;
+    return LevelL;
+}
+
+QRCodeMatrix QRCodeEncoder::encode(const QByteArray &data, ErrorCorrectionLevel level)
+{
+    // Find the smallest version that fits
+    int version = 1;
+    int characterCountBits = 8;
+    for (; version <= 40; version++) {
+        characterCountBits = version < 10 ? 8 : 16;
+        int usedBits = 4 + characterCountBits + data.size() * 8;
+        if (data.size() < (1 << characterCountBits) && usedBits <= numDataCodewords(version, level) * 8) {
+            break;
+        }
+    }
+
+    if (version > 40) {
+        return QRCodeMatrix();
+    }
+
+    QVector<bool> bits;
+    int capacity = numDataCodewords(version, level) * 8;
+    bits.reserve(capacity);
+
+    auto appendBits = [&bits](int value, int length) {
+        for (int i = length - 1; i >= 0; i--) {
+            bits.append(getBit(value, i));
+        }
+    };
+
+    // Byte mode segment
+    appendBits(0x4, 4);
+    appendBits(data.size(), characterCountBits);
+    for (int i = 0; i < data.size(); i++) {
+        appendBits((quint8)data.at(i), 8);
+    }
+
+    // Terminator and padding
+    appendBits(0, qMin(4, capacity - bits.size()));
+    appendBits(0, (8 - bits.size() % 8) % 8);
+    for (int padByte = 0xEC; bits.size() < capacity; padByte ^= 0xEC ^ 0x11) {
+        appendBits(padByte, 8);
+    }
+
+    QByteArray dataCodewords(bits.size() / 8, 0);
+    for (int i = 0; i < bits.size(); i++) {
+        if (bits.at(i)) {
+            dataCodewords[i >> 3] = dataCodewords.at(i >> 3) | (1 << (7 - (i & 7)));
+        }
+    }
+
+    QRCodeBuilder builder(version, level);
+    return builder.build(dataCodewords);
+}
+
+QRCodeMatrix::QRCodeMatrix()
+{
+    m_size = 0;
+}
+
+QRCodeMatrix::QRCodeMatrix(int size)
+{
+    m_size = size;
+    m_modules = QVector<bool>(size * size, false);
+}
+
+bool QRCodeMatrix::isNull() const
+{
+    return m_size == 0;
+}
+
+int QRCodeMatrix::size() const
+{
+    return m_size;
+}
+
+bool QRCodeMatrix::module(int x, int y) const
+{
+    return m_modules.at(y * m_size + x);
+}
+
+void QRCodeMatrix::setModule(int x, int y, bool dark)
+{
+    m_modules[y * m_size + x] = dark;
+}
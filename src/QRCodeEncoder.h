@@ -0,0 +1,67 @@
+/*
+ * Port to Qt of the QR Code generator library (C++)
+ *
+ * Copyright (c) Project Nayuki. (MIT License)
+ * https://www.nayuki.io/page/qr-code-generator-library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * - The above copyright notice and this permission notice shall be included in
+ *   all copies or substantial portions of the Software.
+ * - The Software is provided "as is", without warranty of any kind, express or
+ *   implied, including but not limited to the warranties of merchantability,
+ *   fitness for a particular purpose and noninfringement. In no event shall the
+ *   authors or copyright holders be liable for any claim, damages or other
+ *   liability, whether in an action of contract, tort or otherwise, arising from,
+ *   out of or in connection with the Software or the use or other dealings in the
+ *   Software.
+ */
+
+#ifndef QRCODEENCODER_H
+#define QRCODEENCODER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Encoded QR code symbol, true is a dark module
+class QRCodeMatrix
+{
+public:
+    QRCodeMatrix();
+    explicit QRCodeMatrix(int size);
+
+    bool isNull() const;
+    int size() const;
+
+    bool module(int x, int y) const;
+    void setModule(int x, int y, bool dark);
+
+private:
+    int m_size;
+    QVector<bool> m_modules;
+};
+
+// Byte mode QR code encoder, versions 1 to 40
+// Follows ISO/IEC 18004, including automatic mask selection
+class QRCodeEncoder
+{
+public:
+    enum ErrorCorrectionLevel {
+        LevelL,
+        LevelM,
+        LevelQ,
+        LevelH
+    };
+
+    static ErrorCorrectionLevel levelFromString(const QString &level);
+
+    // Returns a null matrix if the data doesn't fit into a version 40 symbol
+    static QRCodeMatrix encode(const QByteArray &data, ErrorCorrectionLevel level);
+};
+
+#endif // QRCODEENCODER_H
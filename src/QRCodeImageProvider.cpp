@@ -0,0 +1,77 @@
+#include <QColor>
+#include <QImage>
+#include <QMutexLocker>
+#include <QUrl>
+
+#include "QRCodeImageProvider.h"
+
+// Room for a few dozen invoice sized symbols
+static const int matrixCacheMaxCost = 64 * 1024 * 8;
+
+QRCodeImageProvider::QRCodeImageProvider() : QQuickImageProvider(QQuickImageProvider::Image)
+{
+    m_matrixCache.setMaxCost(matrixCacheMaxCost);
+}
+
+QImage QRCodeImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    Q_UNUSED(requestedSize)
+
+    // The value goes last so it may contain slashes
+    QString level = id.section('/', 0, 0);
+    QColor foreground("#" + id.section('/', 1, 1));
+    QColor background("#" + id.section('/', 2, 2));
+    QString value = QUrl::fromPercentEncoding(id.section('/', 3).toUtf8());
+
+    if (!foreground.isValid()) foreground = Qt::black;
+    if (!background.isValid()) background = Qt::white;
+
+    QRCodeMatrix matrix = encodedMatrix(value, QRCodeEncoder::levelFromString(level));
+    if (matrix.isNull()) {
+        if (size) {
+            *size = QSize();
+        }
+        return QImage();
+    }
+
+    QImage image(matrix.size(), matrix.size(), QImage::Format_Indexed8);
+    image.setColorCount(2);
+    image.setColor(0, background.rgba());
+    image.setColor(1, foreground.rgba());
+
+    for (int y = 0; y < matrix.size(); y++) {
+        uchar *scanLine = image.scanLine(y);
+        for (int x = 0; x < matrix.size(); x++) {
+            scanLine[x] = matrix.module(x, y) ? 1 : 0;
+        }
+    }
+
+    if (size) {
+        *size = image.size();
+    }
+
+    return image;
+}
+
+QRCodeMatrix QRCodeImageProvider::encodedMatrix(const QString &value, QRCodeEncoder::ErrorCorrectionLevel level)
+{
+    QString cacheKey = QString::number(level) + value;
+
+    // Asynchronous Images request from a loader thread
+    QMutexLocker locker(&m_cacheMutex);
+
+    QRCodeMatrix *cachedMatrix = m_matrixCache.object(cacheKey);
+    if (cachedMatrix) {
+        return *cachedMatrix;
+    }
+
+    locker.unlock();
+    QRCodeMatrix matrix = QRCodeEncoder::encode(value.toUtf8(), level);
+    locker.relock();
+
+    if (!matrix.isNull()) {
+        m_matrixCache.insert(cacheKey, new QRCodeMatrix(matrix), matrix.size() * matrix.size());
+    }
+
+    return matrix;
+}
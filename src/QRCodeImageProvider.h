@@ -0,0 +1,28 @@
+#ifndef QRCODEIMAGEPROVIDER_H
+#define QRCODEIMAGEPROVIDER_H
+
+#include <QQuickImageProvider>
+#include <QCache>
+#include <QMutex>
+
+#include "QRCodeEncoder.h"
+
+// Serves image://qrcode/<level>/<foreground>/<background>/<value>
+// Images come out at one pixel per module, QML scales them up on the GPU
+class QRCodeImageProvider : public QQuickImageProvider
+{
+public:
+    QRCodeImageProvider();
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize);
+
+private:
+    QRCodeMatrix encodedMatrix(const QString &value, QRCodeEncoder::ErrorCorrectionLevel level);
+
+private:
+    QMutex m_cacheMutex;
+    // Keyed by level and value, cost is the number of modules
+    QCache<QString, QRCodeMatrix> m_matrixCache;
+};
+
+#endif // QRCODEIMAGEPROVIDER_H
@@ -0,0 +1,353 @@
+#include <QDebug>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QRegularExpression>
+#include <QVideoFrame>
+#include <QVideoSurfaceFormat>
+
+#include "QRScannerFilter.h"
+#include "./3rdparty/qzxing/src/QZXing.h"
+
+// Keep the decoder input around this size, larger gains nothing for QR codes
+static const int maxDecodeSide = 640;
+// Adapt downsampling to keep decodes around these times (ms)
+static const int slowDecodeTime = 80;
+static const int fastDecodeTime = 25;
+static const int maxDownsampleFactor = 4;
+
+static inline uchar luminance(uchar r, uchar g, uchar b)
+{
+    return (uchar)((r * 77 + g * 150 + b * 29) >> 8);
+}
+
+// Reads just the capture rect out of a GL texture frame (Android camera)
+static QImage textureRoi(QVideoFrame *frame, const QRect &roi)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context) {
+        return QImage();
+    }
+
+    QOpenGLFunctions *functions = context->functions();
+    GLuint texture = frame->handle().toUInt();
+
+    GLint previousFramebuffer = 0;
+    functions->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    GLuint framebuffer = 0;
+    functions->glGenFramebuffers(1, &framebuffer);
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    QImage rgba(roi.size(), QImage::Format_RGBA8888);
+    // GL rows go bottom up
+    functions->glReadPixels(roi.x(), frame->height() - roi.y() - roi.height(),
+                            roi.width(), roi.height(),
+                            GL_RGBA, GL_UNSIGNED_BYTE, rgba.bits());
+
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    functions->glDeleteFramebuffers(1, &framebuffer);
+
+    return rgba.mirrored();
+}
+
+// Converts the capture rect of a frame to grayscale, taking every step-th pixel
+static QImage grayscaleRoi(QVideoFrame *frame, const QRect &roi, int step)
+{
+    QImage gray(roi.width() / step, roi.height() / step, QImage::Format_Grayscale8);
+    if (gray.isNull()) {
+        return gray;
+    }
+
+    if (frame->handleType() == QAbstractVideoBuffer::GLTextureHandle) {
+        QImage rgba = textureRoi(frame, roi);
+        if (rgba.isNull()) {
+            return QImage();
+        }
+        for (int y = 0; y < gray.height(); y++) {
+            const uchar *source = rgba.constScanLine(y * step);
+            uchar *destination = gray.scanLine(y);
+            for (int x = 0; x < gray.width(); x++) {
+                const uchar *pixel = source + x * step * 4;
+                destination[x] = luminance(pixel[0], pixel[1], pixel[2]);
+            }
+        }
+        return gray;
+    }
+
+    if (!frame->map(QAbstractVideoBuffer::ReadOnly)) {
+        return QImage();
+    }
+
+    const uchar *bits = frame->bits();
+    int bytesPerLine = frame->bytesPerLine();
+
+    switch (frame->pixelFormat()) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_Y8:
+        // Luma plane comes first, no conversion needed
+        for (int y = 0; y < gray.height(); y++) {
+            const uchar *source = bits + (roi.y() + y * step) * bytesPerLine + roi.x();
+            uchar *destination = gray.scanLine(y);
+            for (int x = 0; x < gray.width(); x++) {
+                destination[x] = source[x * step];
+            }
+        }
+        break;
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV: {
+        int lumaOffset = frame->pixelFormat() == QVideoFrame::Format_UYVY ? 1 : 0;
+        for (int y = 0; y < gray.height(); y++) {
+            const uchar *source = bits + (roi.y() + y * step) * bytesPerLine + roi.x() * 2 + lumaOffset;
+            uchar *destination = gray.scanLine(y);
+            for (int x = 0; x < gray.width(); x++) {
+                destination[x] = source[x * step * 2];
+            }
+        }
+        break;
+    }
+    case QVideoFrame::Format_RGB32:
+    case QVideoFrame::Format_ARGB32:
+    case QVideoFrame::Format_ARGB32_Premultiplied:
+        for (int y = 0; y < gray.height(); y++) {
+            const QRgb *source = (const QRgb *)(bits + (roi.y() + y * step) * bytesPerLine) + roi.x();
+            uchar *destination = gray.scanLine(y);
+            for (int x = 0; x < gray.width(); x++) {
+                QRgb pixel = source[x * step];
+                destination[x] = luminance(qRed(pixel), qGreen(pixel), qBlue(pixel));
+            }
+        }
+        break;
+    case QVideoFrame::Format_BGR32:
+    case QVideoFrame::Format_BGRA32:
+    case QVideoFrame::Format_BGRA32_Premultiplied:
+        for (int y = 0; y < gray.height(); y++) {
+            const uchar *source = bits + (roi.y() + y * step) * bytesPerLine + roi.x() * 4;
+            uchar *destination = gray.scanLine(y);
+            for (int x = 0; x < gray.width(); x++) {
+                const uchar *pixel = source + x * step * 4;
+                destination[x] = luminance(pixel[1], pixel[2], pixel[3]);
+            }
+        }
+        break;
+    default:
+        qDebug() << "Unsupported camera pixel format: " << frame->pixelFormat();
+        gray = QImage();
+        break;
+    }
+
+    frame->unmap();
+    return gray;
+}
+
+class QRScannerFilterRunnable : public QVideoFilterRunnable
+{
+public:
+    QRScannerFilterRunnable(QRScannerFilter *filter) : m_filter(filter)
+    {}
+
+    QVideoFrame run(QVideoFrame *input, const QVideoSurfaceFormat &surfaceFormat, RunFlags flags)
+    {
+        Q_UNUSED(surfaceFormat)
+        Q_UNUSED(flags)
+
+        if (!m_filter->scanning() || !input->isValid()) {
+            return *input;
+        }
+
+        if (!m_filter->tryBeginDecode()) {
+            // Previous frame is still being decoded
+            m_filter->frameDropped();
+            return *input;
+        }
+
+        QRect frameRect(0, 0, input->width(), input->height());
+        QRect roi = m_filter->captureRect().toRect().intersected(frameRect);
+        if (roi.isEmpty()) {
+            roi = QRect(frameRect.width() / 4, frameRect.height() / 4,
+                        frameRect.width() / 2, frameRect.height() / 2);
+        }
+
+        int step = m_filter->downsampleFactor();
+        while (qMax(roi.width(), roi.height()) / step > maxDecodeSide && step < maxDownsampleFactor) {
+            step++;
+        }
+
+        // The worker clears the busy flag once it is done, even on a null image
+        m_filter->decodeImage(grayscaleRoi(input, roi, step));
+
+        return *input;
+    }
+
+private:
+    QRScannerFilter* m_filter;
+};
+
+QRScannerWorker::QRScannerWorker(QObject *parent) : QObject(parent)
+{
+    m_decoder = nullptr;
+}
+
+void QRScannerWorker::decode(QImage image)
+{
+    if (!m_decoder) {
+        // Created here so it lives on the worker thread
+        m_decoder = new QZXing(this);
+        m_decoder->setDecoder(QZXing::DecoderFormat_QR_CODE);
+    }
+
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+
+    QString tag;
+    if (!image.isNull()) {
+        tag = m_decoder->decodeImage(image);
+    }
+
+    emit decoded(tag, decodeTimer.elapsed());
+}
+
+QRScannerFilter::QRScannerFilter(QObject *parent) : QAbstractVideoFilter(parent)
+{
+    m_busy.store(0);
+    m_scanning.store(1);
+    m_framesDropped.store(0);
+    m_downsampleFactor.store(1);
+
+    m_framesDecoded = 0;
+    m_lastDecodeTime = 0;
+    m_totalDecodeTime = 0;
+
+    m_worker = new QRScannerWorker;
+    m_worker->moveToThread(&m_workerThread);
+    QObject::connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    QObject::connect(m_worker, &QRScannerWorker::decoded, this, &QRScannerFilter::workerDecoded);
+    m_workerThread.start(QThread::LowPriority);
+}
+
+QRScannerFilter::~QRScannerFilter()
+{
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+QVideoFilterRunnable *QRScannerFilter::createFilterRunnable()
+{
+    return new QRScannerFilterRunnable(this);
+}
+
+bool QRScannerFilter::tryBeginDecode()
+{
+    return m_busy.testAndSetAcquire(0, 1);
+}
+
+void QRScannerFilter::frameDropped()
+{
+    m_framesDropped.ref();
+}
+
+void QRScannerFilter::decodeImage(const QImage &image)
+{
+    QMetaObject::invokeMethod(m_worker, "decode", Qt::QueuedConnection, Q_ARG(QImage, image));
+}
+
+void QRScannerFilter::workerDecoded(QString tag, qint64 decodeTime)
+{
+    m_framesDecoded++;
+    m_lastDecodeTime = decodeTime;
+    m_totalDecodeTime += decodeTime;
+
+    // Trade resolution for frame rate on slow devices
+    if (decodeTime > slowDecodeTime && downsampleFactor() < maxDownsampleFactor) {
+        m_downsampleFactor.ref();
+    }
+    else if (decodeTime < fastDecodeTime && downsampleFactor() > 1) {
+        m_downsampleFactor.deref();
+    }
+
+    if (!tag.isEmpty() && scanning()) {
+        QRegularExpression acceptExpression(acceptPattern(), QRegularExpression::CaseInsensitiveOption);
+        if (acceptExpression.match(tag).hasMatch()) {
+            // Got what we came for, stop decoding frames
+            m_scanning.storeRelease(0);
+            emit scanningChanged();
+            emit tagFound(tag);
+        }
+    }
+
+    m_busy.storeRelease(0);
+    emit statisticsChanged();
+}
+
+void QRScannerFilter::reset()
+{
+    if (!scanning()) {
+        m_scanning.storeRelease(1);
+        emit scanningChanged();
+    }
+}
+
+QRectF QRScannerFilter::captureRect() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_captureRect;
+}
+
+void QRScannerFilter::setCaptureRect(const QRectF &captureRect)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_captureRect == captureRect) {
+        return;
+    }
+    m_captureRect = captureRect;
+    locker.unlock();
+    emit captureRectChanged();
+}
+
+QString QRScannerFilter::acceptPattern() const
+{
+    return m_acceptPattern;
+}
+
+void QRScannerFilter::setAcceptPattern(const QString &acceptPattern)
+{
+    m_acceptPattern = acceptPattern;
+    emit acceptPatternChanged();
+}
+
+bool QRScannerFilter::scanning() const
+{
+    return m_scanning.loadAcquire() != 0;
+}
+
+int QRScannerFilter::framesDecoded() const
+{
+    return m_framesDecoded;
+}
+
+int QRScannerFilter::framesDropped() const
+{
+    return m_framesDropped.load();
+}
+
+int QRScannerFilter::lastDecodeTime() const
+{
+    return m_lastDecodeTime;
+}
+
+int QRScannerFilter::averageDecodeTime() const
+{
+    if (m_framesDecoded == 0) {
+        return 0;
+    }
+    return m_totalDecodeTime / m_framesDecoded;
+}
+
+int QRScannerFilter::downsampleFactor() const
+{
+    return m_downsampleFactor.load();
+}
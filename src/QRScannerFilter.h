@@ -0,0 +1,103 @@
+#ifndef QRSCANNERFILTER_H
+#define QRSCANNERFILTER_H
+
+#include <QAbstractVideoFilter>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include <QRectF>
+#include <QThread>
+
+class QZXing;
+
+// Lives on the decoder thread, decodes one grayscale ROI at a time
+class QRScannerWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QRScannerWorker(QObject *parent = nullptr);
+
+public slots:
+    void decode(QImage image);
+
+signals:
+    void decoded(QString tag, qint64 decodeTime);
+
+private:
+    QZXing* m_decoder;
+};
+
+// Video filter that crops the capture rect to grayscale on the render thread
+// and decodes it on a worker thread, dropping frames while the worker is busy
+class QRScannerFilter : public QAbstractVideoFilter
+{
+    Q_OBJECT
+    Q_PROPERTY(QRectF captureRect READ captureRect WRITE setCaptureRect NOTIFY captureRectChanged)
+    Q_PROPERTY(QString acceptPattern READ acceptPattern WRITE setAcceptPattern NOTIFY acceptPatternChanged)
+    Q_PROPERTY(bool scanning READ scanning NOTIFY scanningChanged)
+
+    Q_PROPERTY(int framesDecoded READ framesDecoded NOTIFY statisticsChanged)
+    Q_PROPERTY(int framesDropped READ framesDropped NOTIFY statisticsChanged)
+    Q_PROPERTY(int lastDecodeTime READ lastDecodeTime NOTIFY statisticsChanged)
+    Q_PROPERTY(int averageDecodeTime READ averageDecodeTime NOTIFY statisticsChanged)
+    Q_PROPERTY(int downsampleFactor READ downsampleFactor NOTIFY statisticsChanged)
+
+public:
+    explicit QRScannerFilter(QObject *parent = nullptr);
+    ~QRScannerFilter();
+
+    QVideoFilterRunnable *createFilterRunnable();
+
+    QRectF captureRect() const;
+    void setCaptureRect(const QRectF &captureRect);
+
+    QString acceptPattern() const;
+    void setAcceptPattern(const QString &acceptPattern);
+
+    bool scanning() const;
+
+    int framesDecoded() const;
+    int framesDropped() const;
+    int lastDecodeTime() const;
+    int averageDecodeTime() const;
+    int downsampleFactor() const;
+
+    // Called from the render thread
+    bool tryBeginDecode();
+    void frameDropped();
+    void decodeImage(const QImage &image);
+
+public slots:
+    // Start scanning again after a payload was accepted
+    void reset();
+
+private slots:
+    void workerDecoded(QString tag, qint64 decodeTime);
+
+signals:
+    void tagFound(QString tag);
+    void captureRectChanged();
+    void acceptPatternChanged();
+    void scanningChanged();
+    void statisticsChanged();
+
+private:
+    QThread m_workerThread;
+    QRScannerWorker* m_worker;
+
+    mutable QMutex m_mutex;
+    QRectF m_captureRect;
+    QString m_acceptPattern;
+
+    QAtomicInt m_busy;
+    QAtomicInt m_scanning;
+    QAtomicInt m_framesDropped;
+    QAtomicInt m_downsampleFactor;
+
+    int m_framesDecoded;
+    int m_lastDecodeTime;
+    qint64 m_totalDecodeTime;
+};
+
+#endif // QRSCANNERFILTER_H
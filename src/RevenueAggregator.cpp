@@ -0,0 +1,247 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonObject>
+
+#include "RevenueAggregator.h"
+#include "InvoiceHistoryStore.h"
+#include "InvoicesModel.h"
+#include "PaymentsModel.h"
+#include "Tracer.h"
+
+static const int historyBatchSize = 5000;
+
+RevenueAggregator::RevenueAggregator(InvoicesModel *invoicesModel, PaymentsModel *paymentsModel,
+                                     InvoiceHistoryStore *historyStore, QObject *parent) : QObject(parent)
+{
+    m_invoicesModel = invoicesModel;
+    m_paymentsModel = paymentsModel;
+    m_historyStore = historyStore;
+
+    m_totalIncomingMsatoshi = 0;
+    m_totalOutgoingMsatoshi = 0;
+    m_batching = false;
+    m_historyOffset = 0;
+
+    for (int i = 0; i < 3; i++) {
+        m_cachedStart[i] = 0;
+        m_cachedEnd[i] = 0;
+    }
+
+    QObject::connect(m_invoicesModel, &QAbstractItemModel::rowsInserted, this, &RevenueAggregator::invoicesInserted);
+    QObject::connect(m_invoicesModel, &QAbstractItemModel::dataChanged, this, &RevenueAggregator::invoicesChanged);
+    QObject::connect(m_invoicesModel, &QAbstractItemModel::modelReset, this, &RevenueAggregator::invoicesReset);
+    QObject::connect(m_paymentsModel, &QAbstractItemModel::rowsInserted, this, &RevenueAggregator::paymentsInserted);
+    QObject::connect(m_paymentsModel, &QAbstractItemModel::dataChanged, this, &RevenueAggregator::paymentsChanged);
+    QObject::connect(m_paymentsModel, &QAbstractItemModel::modelReset, this, &RevenueAggregator::paymentsReset);
+
+    scanInvoices(0, m_invoicesModel->rowCount() - 1);
+    scanPayments(0, m_paymentsModel->rowCount() - 1);
+
+    // In slices so a long history doesn't hold up the UI
+    m_historyTimer = new QTimer(this);
+    m_historyTimer->setInterval(0);
+    QObject::connect(m_historyTimer, &QTimer::timeout, this, &RevenueAggregator::loadHistoryBatch);
+    m_historyTimer->start();
+}
+
+const QMap<qint64, RevenueBucket> &RevenueAggregator::buckets(Granularity granularity) const
+{
+    return m_buckets[granularity];
+}
+
+QVector<RevenueSample> RevenueAggregator::samples() const
+{
+    return m_samples;
+}
+
+qint64 RevenueAggregator::totalIncomingMsatoshi() const
+{
+    return m_totalIncomingMsatoshi;
+}
+
+qint64 RevenueAggregator::totalOutgoingMsatoshi() const
+{
+    return m_totalOutgoingMsatoshi;
+}
+
+bool RevenueAggregator::loadingHistory() const
+{
+    return m_historyTimer->isActive();
+}
+
+void RevenueAggregator::invoicesInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+    scanInvoices(first, last);
+}
+
+void RevenueAggregator::invoicesChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    scanInvoices(topLeft.row(), bottomRight.row());
+}
+
+void RevenueAggregator::invoicesReset()
+{
+    scanInvoices(0, m_invoicesModel->rowCount() - 1);
+}
+
+void RevenueAggregator::paymentsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+    scanPayments(first, last);
+}
+
+void RevenueAggregator::paymentsChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    scanPayments(topLeft.row(), bottomRight.row());
+}
+
+void RevenueAggregator::paymentsReset()
+{
+    scanPayments(0, m_paymentsModel->rowCount() - 1);
+}
+
+void RevenueAggregator::scanInvoices(int first, int last)
+{
+    for (int row = first; row <= last; row++) {
+        QModelIndex index = m_invoicesModel->index(row);
+        if (m_invoicesModel->data(index, InvoicesModel::StatusRole).toInt() != InvoiceTypes::PAID) {
+            continue;
+        }
+
+        // Labels get reused once an invoice is deleted, hashes don't
+        QString hash = m_invoicesModel->data(index, InvoicesModel::HashRole).toString();
+        if (m_countedInvoices.contains(hash) || m_historyStore->contains(hash)) {
+            continue;
+        }
+        m_countedInvoices.insert(hash);
+
+        qint64 msatoshi = m_invoicesModel->data(index, InvoicesModel::MSatishiReceivedRole).toLongLong();
+        if (msatoshi == 0) {
+            msatoshi = m_invoicesModel->data(index, InvoicesModel::MSatoshiRole).toLongLong();
+        }
+        add(m_invoicesModel->data(index, InvoicesModel::PaidAtTimestampRole).toLongLong(), msatoshi, true);
+    }
+}
+
+void RevenueAggregator::scanPayments(int first, int last)
+{
+    for (int row = first; row <= last; row++) {
+        QModelIndex index = m_paymentsModel->index(row);
+        // Incoming ones are the paid invoices, already counted
+        if (m_paymentsModel->data(index, PaymentsModel::IncomingRole).toBool()
+                || m_paymentsModel->data(index, PaymentsModel::PaymentStatusStringRole).toString() != "complete") {
+            continue;
+        }
+
+        QString hash = m_paymentsModel->data(index, PaymentsModel::HashRole).toString();
+        if (m_countedPayments.contains(hash)) {
+            continue;
+        }
+        m_countedPayments.insert(hash);
+
+        add(m_paymentsModel->data(index, PaymentsModel::TimestampRole).toLongLong(),
+            m_paymentsModel->data(index, PaymentsModel::MSatoshiRole).toLongLong(), false);
+    }
+}
+
+void RevenueAggregator::loadHistoryBatch()
+{
+    TRACE_SCOPE("model", "loadRevenueHistory");
+
+    QList<QJsonObject> invoices = m_historyStore->read(&m_historyOffset, historyBatchSize, "\"status\":\"paid\"");
+
+    m_batching = true;
+    foreach (const QJsonObject &invoiceObject, invoices) {
+        // Counted while it was still in the daemon
+        if (m_countedInvoices.contains(invoiceObject.value("payment_hash").toString())) {
+            continue;
+        }
+        qint64 msatoshi = (qint64)invoiceObject.value("msatoshi_received").toDouble();
+        if (msatoshi == 0) {
+            msatoshi = (qint64)invoiceObject.value("msatoshi").toDouble();
+        }
+        add((qint64)invoiceObject.value("paid_at").toDouble(), msatoshi, true);
+    }
+    m_batching = false;
+
+    if (!invoices.isEmpty()) {
+        emit bucketsReset();
+        emit totalsChanged();
+        emit samplesChanged();
+    }
+
+    if (invoices.size() < historyBatchSize) {
+        m_historyTimer->stop();
+        emit loadingHistoryChanged();
+    }
+}
+
+qint64 RevenueAggregator::bucketStart(Granularity granularity, qint64 timestamp)
+{
+    if (timestamp >= m_cachedStart[granularity] && timestamp < m_cachedEnd[granularity]) {
+        return m_cachedStart[granularity];
+    }
+
+    QDateTime dateTime = QDateTime::fromTime_t((uint)timestamp);
+    QDateTime start;
+    QDateTime end;
+    if (granularity == Hour) {
+        start = QDateTime(dateTime.date(), QTime(dateTime.time().hour(), 0));
+        end = start.addSecs(3600);
+    }
+    else if (granularity == Day) {
+        start = QDateTime(dateTime.date());
+        end = start.addDays(1);
+    }
+    else {
+        start = QDateTime(QDate(dateTime.date().year(), dateTime.date().month(), 1));
+        end = start.addMonths(1);
+    }
+
+    m_cachedStart[granularity] = start.toTime_t();
+    m_cachedEnd[granularity] = end.toTime_t();
+    return m_cachedStart[granularity];
+}
+
+void RevenueAggregator::add(qint64 timestamp, qint64 msatoshi, bool incoming)
+{
+    if (timestamp <= 0) {
+        return;
+    }
+
+    for (int granularity = Hour; granularity <= Month; granularity++) {
+        qint64 start = bucketStart((Granularity)granularity, timestamp);
+
+        RevenueBucket &bucket = m_buckets[granularity][start];
+        bucket.start = start;
+        if (incoming) {
+            bucket.incomingCount++;
+            bucket.incomingMsatoshi += msatoshi;
+        }
+        else {
+            bucket.outgoingCount++;
+            bucket.outgoingMsatoshi += msatoshi;
+        }
+
+        if (!m_batching) {
+            emit bucketChanged(granularity, start);
+        }
+    }
+
+    RevenueSample sample;
+    sample.timestamp = timestamp;
+    sample.msatoshi = incoming ? msatoshi : -msatoshi;
+    m_samples.append(sample);
+
+    if (incoming) {
+        m_totalIncomingMsatoshi += msatoshi;
+    }
+    else {
+        m_totalOutgoingMsatoshi += msatoshi;
+    }
+    if (!m_batching) {
+        emit totalsChanged();
+        emit samplesChanged();
+    }
+}
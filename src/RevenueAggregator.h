@@ -0,0 +1,122 @@
+#ifndef REVENUEAGGREGATOR_H
+#define REVENUEAGGREGATOR_H
+
+#include <QAbstractItemModel>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+class InvoiceHistoryStore;
+class InvoicesModel;
+class PaymentsModel;
+
+class RevenueBucket
+{
+public:
+    RevenueBucket()
+    {
+        start = 0;
+        incomingCount = 0;
+        incomingMsatoshi = 0;
+        outgoingCount = 0;
+        outgoingMsatoshi = 0;
+    }
+
+    // Local time, seconds since epoch
+    qint64 start;
+    int incomingCount;
+    qint64 incomingMsatoshi;
+    int outgoingCount;
+    qint64 outgoingMsatoshi;
+};
+
+// One counted invoice or payment, outgoing ones negative
+class RevenueSample
+{
+public:
+    qint64 timestamp;
+    qint64 msatoshi;
+};
+Q_DECLARE_TYPEINFO(RevenueSample, Q_PRIMITIVE_TYPE);
+
+// Takings per hour, day and month: paid invoices in, completed payments
+// out. Rows are added to their buckets as the models insert or change
+// them, each one once, and never taken out again so invoices swept from
+// the daemon keep counting. The archived history is folded in at start.
+class RevenueAggregator : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 totalIncomingMsatoshi READ totalIncomingMsatoshi NOTIFY totalsChanged)
+    Q_PROPERTY(qint64 totalOutgoingMsatoshi READ totalOutgoingMsatoshi NOTIFY totalsChanged)
+    Q_PROPERTY(bool loadingHistory READ loadingHistory NOTIFY loadingHistoryChanged)
+
+public:
+    enum Granularity {
+        Hour,
+        Day,
+        Month
+    };
+    Q_ENUM(Granularity)
+
+    RevenueAggregator(InvoicesModel *invoicesModel, PaymentsModel *paymentsModel,
+                      InvoiceHistoryStore *historyStore, QObject *parent = 0);
+
+    // Keyed and sorted by bucket start
+    const QMap<qint64, RevenueBucket> &buckets(Granularity granularity) const;
+    // Everything counted, in the order it was, not necessarily by time.
+    // Cheap to copy, e.g. to hand to another thread.
+    QVector<RevenueSample> samples() const;
+
+    qint64 totalIncomingMsatoshi() const;
+    qint64 totalOutgoingMsatoshi() const;
+    bool loadingHistory() const;
+
+signals:
+    void bucketChanged(int granularity, qint64 start);
+    // Too much changed at once to tell, e.g. a batch of history
+    void bucketsReset();
+    void totalsChanged();
+    void samplesChanged();
+    void loadingHistoryChanged();
+
+private slots:
+    void invoicesInserted(const QModelIndex &parent, int first, int last);
+    void invoicesChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void invoicesReset();
+    void paymentsInserted(const QModelIndex &parent, int first, int last);
+    void paymentsChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void paymentsReset();
+    void loadHistoryBatch();
+
+private:
+    void scanInvoices(int first, int last);
+    void scanPayments(int first, int last);
+    void add(qint64 timestamp, qint64 msatoshi, bool incoming);
+    qint64 bucketStart(Granularity granularity, qint64 timestamp);
+
+    InvoicesModel* m_invoicesModel;
+    PaymentsModel* m_paymentsModel;
+    InvoiceHistoryStore* m_historyStore;
+
+    QMap<qint64, RevenueBucket> m_buckets[3];
+    QVector<RevenueSample> m_samples;
+    // Payment hashes counted from the models, the history has its own set
+    QSet<QString> m_countedInvoices;
+    QSet<QString> m_countedPayments;
+
+    qint64 m_totalIncomingMsatoshi;
+    qint64 m_totalOutgoingMsatoshi;
+    // Signals are held back while a history batch is added
+    bool m_batching;
+
+    qint64 m_historyOffset;
+    QTimer* m_historyTimer;
+
+    // Rows mostly come in time order, saves a local time conversion each
+    qint64 m_cachedStart[3];
+    qint64 m_cachedEnd[3];
+};
+
+#endif // REVENUEAGGREGATOR_H
@@ -0,0 +1,188 @@
+#include <QDateTime>
+
+#include <algorithm>
+
+#include "RevenueBucketModel.h"
+
+RevenueBucketModel::RevenueBucketModel(RevenueAggregator *aggregator, RevenueAggregator::Granularity granularity,
+                                       QObject *parent) : QAbstractListModel(parent)
+{
+    m_aggregator = aggregator;
+    m_granularity = granularity;
+    m_bucketLimit = 0;
+    m_fiatPerBtc = 0;
+    m_maxIncomingMsatoshi = 0;
+
+    QObject::connect(m_aggregator, &RevenueAggregator::bucketChanged, this, &RevenueBucketModel::bucketChanged);
+    QObject::connect(m_aggregator, &RevenueAggregator::bucketsReset, this, &RevenueBucketModel::rebuild);
+
+    rebuild();
+}
+
+QHash<int, QByteArray> RevenueBucketModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[StartRole] = "start";
+    roles[IncomingCountRole] = "incomingcount";
+    roles[IncomingMSatoshiRole] = "incomingmsatoshi";
+    roles[IncomingFiatRole] = "incomingfiat";
+    roles[OutgoingCountRole] = "outgoingcount";
+    roles[OutgoingMSatoshiRole] = "outgoingmsatoshi";
+    roles[OutgoingFiatRole] = "outgoingfiat";
+    roles[NetMSatoshiRole] = "netmsatoshi";
+    return roles;
+}
+
+int RevenueBucketModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_starts.count();
+}
+
+QVariant RevenueBucketModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_starts.count())
+        return QVariant();
+
+    const RevenueBucket bucket = m_aggregator->buckets(m_granularity).value(m_starts.at(index.row()));
+    if (role == StartRole)
+        return QDateTime::fromTime_t((uint)bucket.start);
+    else if (role == IncomingCountRole)
+        return bucket.incomingCount;
+    else if (role == IncomingMSatoshiRole)
+        return bucket.incomingMsatoshi;
+    else if (role == IncomingFiatRole)
+        return toFiat(bucket.incomingMsatoshi);
+    else if (role == OutgoingCountRole)
+        return bucket.outgoingCount;
+    else if (role == OutgoingMSatoshiRole)
+        return bucket.outgoingMsatoshi;
+    else if (role == OutgoingFiatRole)
+        return toFiat(bucket.outgoingMsatoshi);
+    else if (role == NetMSatoshiRole)
+        return bucket.incomingMsatoshi - bucket.outgoingMsatoshi;
+    return QVariant();
+}
+
+RevenueAggregator::Granularity RevenueBucketModel::granularity() const
+{
+    return m_granularity;
+}
+
+void RevenueBucketModel::setGranularity(RevenueAggregator::Granularity granularity)
+{
+    if (m_granularity == granularity) {
+        return;
+    }
+    m_granularity = granularity;
+    rebuild();
+    emit granularityChanged();
+}
+
+int RevenueBucketModel::bucketLimit() const
+{
+    return m_bucketLimit;
+}
+
+void RevenueBucketModel::setBucketLimit(int bucketLimit)
+{
+    bucketLimit = qMax(0, bucketLimit);
+    if (m_bucketLimit == bucketLimit) {
+        return;
+    }
+    m_bucketLimit = bucketLimit;
+    rebuild();
+    emit bucketLimitChanged();
+}
+
+double RevenueBucketModel::fiatPerBtc() const
+{
+    return m_fiatPerBtc;
+}
+
+void RevenueBucketModel::setFiatPerBtc(double fiatPerBtc)
+{
+    if (qFuzzyCompare(m_fiatPerBtc, fiatPerBtc)) {
+        return;
+    }
+    m_fiatPerBtc = fiatPerBtc;
+    emit fiatPerBtcChanged();
+
+    if (!m_starts.isEmpty()) {
+        emit dataChanged(index(0), index(m_starts.count() - 1), QVector<int>() << IncomingFiatRole << OutgoingFiatRole);
+    }
+}
+
+qint64 RevenueBucketModel::maxIncomingMsatoshi() const
+{
+    return m_maxIncomingMsatoshi;
+}
+
+double RevenueBucketModel::toFiat(qint64 msatoshi) const
+{
+    return msatoshi / 100000000000.0 * m_fiatPerBtc;
+}
+
+void RevenueBucketModel::updateMaxIncoming(qint64 incomingMsatoshi)
+{
+    if (incomingMsatoshi > m_maxIncomingMsatoshi) {
+        m_maxIncomingMsatoshi = incomingMsatoshi;
+        emit maxIncomingMsatoshiChanged();
+    }
+}
+
+void RevenueBucketModel::rebuild()
+{
+    const QMap<qint64, RevenueBucket> &buckets = m_aggregator->buckets(m_granularity);
+
+    beginResetModel();
+    m_starts.clear();
+
+    QMap<qint64, RevenueBucket>::const_iterator it = buckets.constBegin();
+    if (m_bucketLimit > 0 && buckets.size() > m_bucketLimit) {
+        it += buckets.size() - m_bucketLimit;
+    }
+
+    qint64 maxIncomingMsatoshi = 0;
+    for (; it != buckets.constEnd(); ++it) {
+        m_starts.append(it.key());
+        maxIncomingMsatoshi = qMax(maxIncomingMsatoshi, it.value().incomingMsatoshi);
+    }
+    endResetModel();
+
+    if (m_maxIncomingMsatoshi != maxIncomingMsatoshi) {
+        m_maxIncomingMsatoshi = maxIncomingMsatoshi;
+        emit maxIncomingMsatoshiChanged();
+    }
+}
+
+void RevenueBucketModel::bucketChanged(int granularity, qint64 start)
+{
+    if (granularity != m_granularity) {
+        return;
+    }
+
+    QList<qint64>::iterator it = std::lower_bound(m_starts.begin(), m_starts.end(), start);
+    int row = it - m_starts.begin();
+    if (it != m_starts.end() && *it == start) {
+        updateMaxIncoming(m_aggregator->buckets(m_granularity).value(start).incomingMsatoshi);
+        emit dataChanged(index(row), index(row));
+        return;
+    }
+
+    // Older than what a limited model shows
+    if (m_bucketLimit > 0 && row == 0 && m_starts.count() >= m_bucketLimit) {
+        return;
+    }
+    updateMaxIncoming(m_aggregator->buckets(m_granularity).value(start).incomingMsatoshi);
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_starts.insert(row, start);
+    endInsertRows();
+
+    if (m_bucketLimit > 0 && m_starts.count() > m_bucketLimit) {
+        beginRemoveRows(QModelIndex(), 0, 0);
+        m_starts.removeFirst();
+        endRemoveRows();
+    }
+}
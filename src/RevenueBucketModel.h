@@ -0,0 +1,78 @@
+#ifndef REVENUEBUCKETMODEL_H
+#define REVENUEBUCKETMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+
+#include "RevenueAggregator.h"
+
+// One row per bucket of the chosen granularity, oldest first, for charts.
+// Only ever as big as the number of buckets, however many invoices there
+// are behind them.
+class RevenueBucketModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(RevenueAggregator::Granularity granularity READ granularity WRITE setGranularity NOTIFY granularityChanged)
+    // The most recent buckets only, 0 for all of them
+    Q_PROPERTY(int bucketLimit READ bucketLimit WRITE setBucketLimit NOTIFY bucketLimitChanged)
+    // For the fiat roles, at today's rate
+    Q_PROPERTY(double fiatPerBtc READ fiatPerBtc WRITE setFiatPerBtc NOTIFY fiatPerBtcChanged)
+    Q_PROPERTY(qint64 maxIncomingMsatoshi READ maxIncomingMsatoshi NOTIFY maxIncomingMsatoshiChanged)
+
+public:
+    enum BucketRoles {
+        StartRole = Qt::UserRole + 1,
+        IncomingCountRole,
+        IncomingMSatoshiRole,
+        IncomingFiatRole,
+        OutgoingCountRole,
+        OutgoingMSatoshiRole,
+        OutgoingFiatRole,
+        NetMSatoshiRole
+    };
+
+    RevenueBucketModel(RevenueAggregator *aggregator,
+                       RevenueAggregator::Granularity granularity = RevenueAggregator::Day, QObject *parent = 0);
+
+    QHash<int, QByteArray> roleNames() const;
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    RevenueAggregator::Granularity granularity() const;
+    void setGranularity(RevenueAggregator::Granularity granularity);
+
+    int bucketLimit() const;
+    void setBucketLimit(int bucketLimit);
+
+    double fiatPerBtc() const;
+    void setFiatPerBtc(double fiatPerBtc);
+
+    // Tallest bar, to scale a chart by
+    qint64 maxIncomingMsatoshi() const;
+
+signals:
+    void granularityChanged();
+    void bucketLimitChanged();
+    void fiatPerBtcChanged();
+    void maxIncomingMsatoshiChanged();
+
+private slots:
+    void bucketChanged(int granularity, qint64 start);
+    void rebuild();
+
+private:
+    double toFiat(qint64 msatoshi) const;
+    void updateMaxIncoming(qint64 incomingMsatoshi);
+
+    RevenueAggregator* m_aggregator;
+    RevenueAggregator::Granularity m_granularity;
+    int m_bucketLimit;
+    double m_fiatPerBtc;
+    qint64 m_maxIncomingMsatoshi;
+
+    // Bucket starts of the rows, sorted
+    QList<qint64> m_starts;
+};
+
+#endif // REVENUEBUCKETMODEL_H
@@ -0,0 +1,366 @@
+#include <QDebug>
+
+#include "RpcConnectionPool.h"
+#include "RpcDiagnostics.h"
+#include "RpcLaneDevice.h"
+#include "RpcRecorder.h"
+#include "SnapshotCache.h"
+#include "Tracer.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
+
+// How long a request waits for its connection to come up
+static const int queueExpiry = 10 * 1000;
+
+RpcConnectionPool::RpcConnectionPool(int blockingConnections, QObject *parent) : QObject(parent)
+{
+    m_clock.start();
+    m_waitTime[FastLane] = 0;
+    m_waitTime[BlockingLane] = 0;
+    m_waitTime[LongPollLane] = 0;
+    m_waitTime[ProbeLane] = 0;
+
+    m_expiryTimer = new QTimer(this);
+    m_expiryTimer->setInterval(1000);
+    QObject::connect(m_expiryTimer, &QTimer::timeout, this, &RpcConnectionPool::expireQueued);
+
+    // Connection 0 is the primary, the refreshes stay on it in order
+    addConnection(FastLane);
+    for (int i = 0; i < blockingConnections; i++) {
+        addConnection(BlockingLane);
+    }
+    addConnection(LongPollLane);
+    addConnection(ProbeLane);
+}
+
+int RpcConnectionPool::addConnection(Lane lane)
+{
+    Connection connection;
+    connection.unixSocket = new QLocalSocket(this);
+    connection.lane = lane;
+    connection.bytesReceived = 0;
+    connection.bytesAtLastReply = 0;
+    connection.readStartedAt = 0;
+
+    // Connected before the RPC socket so we see the data before it gets parsed
+    QObject::connect(connection.unixSocket, &QLocalSocket::readyRead,
+                     this, &RpcConnectionPool::socketReadyRead);
+    connection.device = new RpcLaneDevice(connection.unixSocket, this);
+    connection.rpcSocket = new QJsonRpcSocket(connection.device, this);
+
+    QObject::connect(connection.rpcSocket, &QJsonRpcAbstractSocket::messageReceived,
+                     this, &RpcConnectionPool::messageReceived);
+    QObject::connect(connection.unixSocket, &QLocalSocket::disconnected,
+                     this, &RpcConnectionPool::socketDisconnected);
+
+    m_connections.append(connection);
+    return m_connections.size() - 1;
+}
+
+QLocalSocket *RpcConnectionPool::primarySocket() const
+{
+    return m_connections.at(0).unixSocket;
+}
+
+void RpcConnectionPool::connectBlockingLane(const QString &serverName)
+{
+    for (int i = 0; i < m_connections.size(); i++) {
+        QLocalSocket* unixSocket = m_connections.at(i).unixSocket;
+        if (m_connections.at(i).lane != FastLane
+                && unixSocket->state() == QLocalSocket::UnconnectedState) {
+            unixSocket->connectToServer(serverName);
+        }
+    }
+}
+
+void RpcConnectionPool::disconnectBlockingLane()
+{
+    for (int i = 0; i < m_connections.size(); i++) {
+        if (m_connections.at(i).lane != FastLane) {
+            m_connections.at(i).unixSocket->abort();
+        }
+    }
+}
+
+RpcConnectionPool::Lane RpcConnectionPool::laneForMethod(const QString &method)
+{
+    // Anything that can take longer than a round trip to the daemon
+    static const QSet<QString> blockingMethods = QSet<QString>()
+            << "pay"
+            << "sendpay"
+            << "waitsendpay"
+            << "fundchannel"
+            << "connect"
+            << "close"
+            << "withdraw"
+            << "newaddr";
+
+    // Anything that waits for someone else to act
+    static const QSet<QString> longPollMethods = QSet<QString>()
+            << "waitinvoice"
+            << "waitanyinvoice";
+
+    if (longPollMethods.contains(method)) {
+        return LongPollLane;
+    }
+    return blockingMethods.contains(method) ? BlockingLane : FastLane;
+}
+
+bool RpcConnectionPool::mayQueue(Lane lane, const QString &method)
+{
+    // Sent minutes later to a restarted daemon, after the UI gave up on them
+    static const QSet<QString> moneyMovingMethods = QSet<QString>()
+            << "pay"
+            << "sendpay"
+            << "fundchannel"
+            << "close"
+            << "withdraw";
+
+    // The fast lane is the primary, nothing gets sent while it is down
+    return lane != FastLane && !moneyMovingMethods.contains(method);
+}
+
+int RpcConnectionPool::pickConnection(Lane lane) const
+{
+    // The least busy connection of the lane that is up. If none is, the
+    // least busy one anyway, it holds the request until it connects.
+    int picked = -1;
+    bool pickedConnected = false;
+    for (int i = 0; i < m_connections.size(); i++) {
+        const Connection &connection = m_connections.at(i);
+        if (connection.lane != lane) {
+            continue;
+        }
+        bool connected = connection.unixSocket->state() == QLocalSocket::ConnectedState;
+        if (picked == -1 || (connected && !pickedConnected)
+                || (connected == pickedConnected && connection.pending.size() < m_connections.at(picked).pending.size())) {
+            picked = i;
+            pickedConnected = connected;
+        }
+    }
+
+    // A pool without blocking connections
+    return picked == -1 ? 0 : picked;
+}
+
+QJsonRpcServiceReply *RpcConnectionPool::sendMessage(const QJsonRpcMessage &message)
+{
+    return sendMessage(message, laneForMethod(message.method()));
+}
+
+QJsonRpcServiceReply *RpcConnectionPool::sendMessage(const QJsonRpcMessage &message, Lane lane)
+{
+    int connectionIndex = pickConnection(lane);
+    Connection &connection = m_connections[connectionIndex];
+    bool connected = connection.unixSocket->state() == QLocalSocket::ConnectedState;
+
+    QJsonRpcServiceReply* reply = connection.rpcSocket->sendMessage(message);
+    TRACE_ASYNC_BEGIN("rpc", message.method(), reply);
+
+    PendingRequest request;
+    request.connection = connectionIndex;
+    request.sentAt = m_clock.elapsed();
+    request.waitRecorded = connection.pending.isEmpty();
+    request.failed = false;
+    if (request.waitRecorded) {
+        recordWait(connection.lane, 0);
+    }
+
+    connection.pending.append(reply);
+    m_pendingRequests.insert(reply, request);
+    QObject::connect(reply, &QJsonRpcServiceReply::finished, this, &RpcConnectionPool::replyFinished);
+
+    if (!connected) {
+        if (mayQueue(lane, message.method())) {
+            m_expiryTimer->start();
+        }
+        else {
+            // Just queued by the device, take it back out
+            connection.device->dropQueued(connection.device->queuedCount() - 1);
+            failRequest(connection, reply, "Not connected to lightningd");
+        }
+    }
+
+    emit statisticsChanged();
+    return reply;
+}
+
+void RpcConnectionPool::replyFinished()
+{
+    QJsonRpcServiceReply *reply = static_cast<QJsonRpcServiceReply *>(sender());
+    QObject::disconnect(reply, &QJsonRpcServiceReply::finished, this, &RpcConnectionPool::replyFinished);
+
+    if (!m_pendingRequests.contains(reply)) {
+        return;
+    }
+
+    TRACE_ASYNC_END("rpc", reply->request().method(), reply);
+
+    PendingRequest request = m_pendingRequests.take(reply);
+    Connection &connection = m_connections[request.connection];
+    qint64 now = m_clock.elapsed();
+
+    if (!request.waitRecorded) {
+        // Answered out of order, count the whole time as waiting
+        recordWait(connection.lane, now - request.sentAt);
+    }
+
+    if (RpcDiagnostics::instance()) {
+        // The reply is finished from within the RPC socket's readyRead handler,
+        // so everything since our own readyRead is reading and parsing it
+        qint64 bytes = connection.bytesReceived - connection.bytesAtLastReply;
+        connection.bytesAtLastReply = connection.bytesReceived;
+
+        QString method = reply->request().method();
+        bool error = reply->response().type() == QJsonRpcMessage::Error;
+        RpcDiagnostics::instance()->recordReply(method, now - request.sentAt, bytes, error);
+        RpcDiagnostics::instance()->recordStage(method, RpcDiagnostics::ParseStage, now - connection.readStartedAt);
+    }
+
+    if (RpcRecorder::isRecording() && !request.failed) {
+        RpcRecorder::record(reply->request(), reply->response(), now - request.sentAt);
+    }
+
+    if (SnapshotCache::instance() && !request.failed) {
+        SnapshotCache::instance()->storeResult(reply->request(), reply->response());
+    }
+
+    bool wasHead = !connection.pending.isEmpty() && connection.pending.first() == reply;
+    connection.pending.removeOne(reply);
+
+    // The next one in line only starts being worked on now
+    if (wasHead && !connection.pending.isEmpty()) {
+        PendingRequest &next = m_pendingRequests[connection.pending.first()];
+        if (!next.waitRecorded) {
+            next.waitRecorded = true;
+            recordWait(connection.lane, now - next.sentAt);
+        }
+    }
+
+    emit statisticsChanged();
+}
+
+int RpcConnectionPool::connectionForSocket(QObject *unixSocket) const
+{
+    for (int i = 0; i < m_connections.size(); i++) {
+        if (m_connections.at(i).unixSocket == unixSocket) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void RpcConnectionPool::socketDisconnected()
+{
+    int connectionIndex = connectionForSocket(sender());
+    if (connectionIndex == -1) {
+        return;
+    }
+
+    // Those answers are never coming. Whatever was queued goes too, the
+    // daemon we'd reconnect to is a different one.
+    Connection &connection = m_connections[connectionIndex];
+    connection.device->dropAllQueued();
+    foreach (QJsonRpcServiceReply* reply, connection.pending) {
+        failRequest(connection, reply, "Lost the connection to lightningd");
+    }
+    connection.bytesAtLastReply = connection.bytesReceived;
+}
+
+void RpcConnectionPool::failRequest(Connection &connection, QJsonRpcServiceReply *reply, const QString &error)
+{
+    PendingRequest &request = m_pendingRequests[reply];
+    if (request.failed) {
+        return;
+    }
+    request.failed = true;
+
+    // Finishes through replyFinished like any other reply
+    QJsonRpcMessage errorMessage = reply->request().createErrorResponse(QJsonRpc::InternalError, error);
+    connection.device->inject(errorMessage.toJson());
+}
+
+void RpcConnectionPool::expireQueued()
+{
+    qint64 now = m_clock.elapsed();
+    bool waiting = false;
+
+    for (int i = 0; i < m_connections.size(); i++) {
+        Connection &connection = m_connections[i];
+        if (connection.unixSocket->state() == QLocalSocket::ConnectedState) {
+            continue;
+        }
+
+        // Everything unfailed on a connection that is down is queued, the
+        // oldest first, so the expired ones are always at the front
+        foreach (QJsonRpcServiceReply* reply, connection.pending) {
+            const PendingRequest &request = m_pendingRequests[reply];
+            if (request.failed) {
+                continue;
+            }
+            if (now - request.sentAt < queueExpiry) {
+                waiting = true;
+                break;
+            }
+            connection.device->dropQueued(0);
+            failRequest(connection, reply, "Timed out waiting for the connection to lightningd");
+        }
+    }
+
+    if (!waiting) {
+        m_expiryTimer->stop();
+    }
+}
+
+void RpcConnectionPool::socketReadyRead()
+{
+    int connectionIndex = connectionForSocket(sender());
+    if (connectionIndex == -1) {
+        return;
+    }
+
+    // The RPC socket reads everything available right after us
+    Connection &connection = m_connections[connectionIndex];
+    connection.bytesReceived += connection.unixSocket->bytesAvailable();
+    connection.readStartedAt = m_clock.elapsed();
+}
+
+void RpcConnectionPool::recordWait(Lane lane, qint64 wait)
+{
+    m_waitTime[lane] = (m_waitTime[lane] * 7 + (int)wait) / 8;
+}
+
+int RpcConnectionPool::queueDepth(Lane lane) const
+{
+    int depth = 0;
+    for (int i = 0; i < m_connections.size(); i++) {
+        if (m_connections.at(i).lane == lane) {
+            depth += m_connections.at(i).pending.size();
+        }
+    }
+    return depth;
+}
+
+int RpcConnectionPool::waitTime(Lane lane) const
+{
+    return m_waitTime[lane];
+}
+
+int RpcConnectionPool::fastQueueDepth() const
+{
+    return queueDepth(FastLane);
+}
+
+int RpcConnectionPool::blockingQueueDepth() const
+{
+    return queueDepth(BlockingLane);
+}
+
+int RpcConnectionPool::fastWaitTime() const
+{
+    return waitTime(FastLane);
+}
+
+int RpcConnectionPool::blockingWaitTime() const
+{
+    return waitTime(BlockingLane);
+}
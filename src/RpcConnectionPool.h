@@ -0,0 +1,119 @@
+#ifndef RPCCONNECTIONPOOL_H
+#define RPCCONNECTIONPOOL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLocalSocket>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
+
+class QJsonRpcServiceReply;
+class RpcLaneDevice;
+
+// A handful of RPC connections to lightningd, split into lanes so a long
+// running pay never sits in front of a balance refresh. waitinvoice and
+// waitanyinvoice can take until the next customer pays, they get a
+// connection of their own, and so does DaemonSupervisor's health probe so
+// it never waits behind a big listinvoices. Has the same sendMessage() as QJsonRpcSocket
+// so the models don't care.
+//
+// Every reply finishes: a request that is lost with its connection, or
+// can't be sent, gets a JSON-RPC error instead of the daemon's answer.
+// While a blocking or long poll connection is down its requests wait a
+// few seconds for it, except those that move money, which fail right away.
+class RpcConnectionPool : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int fastQueueDepth READ fastQueueDepth NOTIFY statisticsChanged)
+    Q_PROPERTY(int blockingQueueDepth READ blockingQueueDepth NOTIFY statisticsChanged)
+    Q_PROPERTY(int fastWaitTime READ fastWaitTime NOTIFY statisticsChanged)
+    Q_PROPERTY(int blockingWaitTime READ blockingWaitTime NOTIFY statisticsChanged)
+
+public:
+    enum Lane {
+        FastLane,
+        BlockingLane,
+        LongPollLane,
+        ProbeLane
+    };
+    Q_ENUM(Lane)
+
+    RpcConnectionPool(int blockingConnections = 2, QObject *parent = 0);
+
+    // The fast lane connection, LightningModel drives the connection state off it
+    QLocalSocket *primarySocket() const;
+
+    // Opens the blocking, long poll and probe connections, call once the primary
+    // is connected. Requests for them wait until they are up.
+    void connectBlockingLane(const QString &serverName);
+    void disconnectBlockingLane();
+
+    QJsonRpcServiceReply *sendMessage(const QJsonRpcMessage &message);
+    QJsonRpcServiceReply *sendMessage(const QJsonRpcMessage &message, Lane lane);
+
+    static Lane laneForMethod(const QString &method);
+    // Whether a request may wait for its connection to come up
+    static bool mayQueue(Lane lane, const QString &method);
+
+    int queueDepth(Lane lane) const;
+    // Moving average of how long requests sat behind others on their connection (ms)
+    int waitTime(Lane lane) const;
+
+    int fastQueueDepth() const;
+    int blockingQueueDepth() const;
+    int fastWaitTime() const;
+    int blockingWaitTime() const;
+
+signals:
+    void messageReceived(const QJsonRpcMessage &message);
+    void statisticsChanged();
+
+private slots:
+    void replyFinished();
+    void socketDisconnected();
+    void socketReadyRead();
+    void expireQueued();
+
+private:
+    struct Connection {
+        QLocalSocket* unixSocket;
+        QJsonRpcSocket* rpcSocket;
+        RpcLaneDevice* device;
+        Lane lane;
+        // In flight, in send order; lightningd answers a connection in order
+        QList<QJsonRpcServiceReply*> pending;
+
+        // Bytes that arrived on the socket, and when the last chunk started being read
+        qint64 bytesReceived;
+        qint64 bytesAtLastReply;
+        qint64 readStartedAt;
+    };
+
+    struct PendingRequest {
+        int connection;
+        qint64 sentAt;
+        bool waitRecorded;
+        // Answered with an error by us, the daemon never saw it or won't answer
+        bool failed;
+    };
+
+    int addConnection(Lane lane);
+    int pickConnection(Lane lane) const;
+    int connectionForSocket(QObject *unixSocket) const;
+    void recordWait(Lane lane, qint64 wait);
+    void failRequest(Connection &connection, QJsonRpcServiceReply *reply, const QString &error);
+
+    QVector<Connection> m_connections;
+    QHash<QJsonRpcServiceReply*, PendingRequest> m_pendingRequests;
+    QElapsedTimer m_clock;
+    QTimer* m_expiryTimer;
+
+    int m_waitTime[4];
+};
+
+#endif // RPCCONNECTIONPOOL_H
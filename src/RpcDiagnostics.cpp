@@ -0,0 +1,231 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtMath>
+
+#include "RpcDiagnostics.h"
+
+RpcDiagnostics *RpcDiagnostics::sInstance = 0;
+
+// Don't push every single reply to QML
+static const int updateInterval = 1000;
+static const int dumpInterval = 60000;
+
+RpcMethodStatistics::RpcMethodStatistics()
+{
+    m_count = 0;
+    m_errorCount = 0;
+    m_latencyHistogram = QVector<int>(bucketBounds().size() + 1, 0);
+    m_totalLatency = 0;
+    m_maxLatency = 0;
+
+    m_lastBytes = 0;
+    m_maxBytes = 0;
+    m_totalBytes = 0;
+
+    m_parseCount = 0;
+    m_totalParseTime = 0;
+    m_applyCount = 0;
+    m_totalApplyTime = 0;
+}
+
+const QVector<qint64> &RpcMethodStatistics::bucketBounds()
+{
+    // Last bucket is everything above 10 s
+    static const QVector<qint64> bounds = QVector<qint64>()
+            << 1 << 2 << 5 << 10 << 25 << 50 << 100 << 250
+            << 500 << 1000 << 2500 << 5000 << 10000;
+    return bounds;
+}
+
+void RpcMethodStatistics::addLatency(qint64 latency)
+{
+    const QVector<qint64> &bounds = bucketBounds();
+
+    int bucket = 0;
+    while (bucket < bounds.size() && latency > bounds.at(bucket)) {
+        bucket++;
+    }
+    m_latencyHistogram[bucket]++;
+
+    m_totalLatency += latency;
+    m_maxLatency = qMax(m_maxLatency, latency);
+}
+
+qint64 RpcMethodStatistics::latencyPercentile(double quantile) const
+{
+    int samples = 0;
+    for (int i = 0; i < m_latencyHistogram.size(); i++) {
+        samples += m_latencyHistogram.at(i);
+    }
+    if (samples == 0) {
+        return 0;
+    }
+
+    int wanted = qCeil(samples * quantile);
+    int seen = 0;
+    for (int i = 0; i < m_latencyHistogram.size(); i++) {
+        seen += m_latencyHistogram.at(i);
+        if (seen >= wanted) {
+            return i < bucketBounds().size() ? bucketBounds().at(i) : m_maxLatency;
+        }
+    }
+    return m_maxLatency;
+}
+
+QJsonObject RpcMethodStatistics::toJson(const QString &method) const
+{
+    QJsonObject methodObject;
+    methodObject.insert("method", method);
+    methodObject.insert("count", m_count);
+    methodObject.insert("errors", m_errorCount);
+    methodObject.insert("averageLatency", m_count ? (double)m_totalLatency / m_count : 0.0);
+    methodObject.insert("p50Latency", latencyPercentile(0.5));
+    methodObject.insert("p95Latency", latencyPercentile(0.95));
+    methodObject.insert("maxLatency", m_maxLatency);
+    methodObject.insert("lastBytes", m_lastBytes);
+    methodObject.insert("maxBytes", m_maxBytes);
+    methodObject.insert("totalBytes", m_totalBytes);
+    methodObject.insert("averageParseTime", m_parseCount ? (double)m_totalParseTime / m_parseCount : 0.0);
+    methodObject.insert("averageApplyTime", m_applyCount ? (double)m_totalApplyTime / m_applyCount : 0.0);
+
+    QJsonArray histogramArray;
+    for (int i = 0; i < m_latencyHistogram.size(); i++) {
+        QJsonObject bucketObject;
+        bucketObject.insert("upTo", i < bucketBounds().size() ? QJsonValue(bucketBounds().at(i)) : QJsonValue());
+        bucketObject.insert("count", m_latencyHistogram.at(i));
+        histogramArray.append(bucketObject);
+    }
+    methodObject.insert("latencyHistogram", histogramArray);
+
+    return methodObject;
+}
+
+RpcDiagnostics::RpcDiagnostics(QObject *parent) : QObject(parent)
+{
+    sInstance = this;
+
+    m_totalRequests = 0;
+
+    QString dumpDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dumpDirectory);
+    m_dumpFilePath = dumpDirectory + "/rpc-diagnostics.json";
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(updateInterval);
+    m_updateTimer->setSingleShot(true);
+    QObject::connect(m_updateTimer, &QTimer::timeout, this, &RpcDiagnostics::updated);
+
+    m_dumpTimer = new QTimer(this);
+    m_dumpTimer->setInterval(dumpInterval);
+    QObject::connect(m_dumpTimer, &QTimer::timeout, this, &RpcDiagnostics::dump);
+    m_dumpTimer->start();
+}
+
+RpcDiagnostics *RpcDiagnostics::instance()
+{
+    return sInstance;
+}
+
+void RpcDiagnostics::recordReply(const QString &method, qint64 latency, qint64 bytes, bool error)
+{
+    RpcMethodStatistics &statistics = m_methods[method];
+    statistics.m_count++;
+    if (error) {
+        statistics.m_errorCount++;
+    }
+    statistics.addLatency(latency);
+
+    statistics.m_lastBytes = bytes;
+    statistics.m_maxBytes = qMax(statistics.m_maxBytes, bytes);
+    statistics.m_totalBytes += bytes;
+
+    m_totalRequests++;
+    scheduleUpdate();
+}
+
+void RpcDiagnostics::recordStage(const QString &method, Stage stage, qint64 elapsed)
+{
+    RpcMethodStatistics &statistics = m_methods[method];
+    if (stage == ParseStage) {
+        statistics.m_parseCount++;
+        statistics.m_totalParseTime += elapsed;
+    }
+    else {
+        statistics.m_applyCount++;
+        statistics.m_totalApplyTime += elapsed;
+    }
+
+    scheduleUpdate();
+}
+
+QVariantList RpcDiagnostics::methods() const
+{
+    QVariantList methodsList;
+    QStringList methodNames = m_methods.keys();
+    methodNames.sort();
+    foreach (QString method, methodNames) {
+        methodsList.append(m_methods.value(method).toJson(method).toVariantMap());
+    }
+    return methodsList;
+}
+
+int RpcDiagnostics::totalRequests() const
+{
+    return m_totalRequests;
+}
+
+QString RpcDiagnostics::dumpFilePath() const
+{
+    return m_dumpFilePath;
+}
+
+QJsonObject RpcDiagnostics::toJson() const
+{
+    QJsonArray methodsArray;
+    QStringList methodNames = m_methods.keys();
+    methodNames.sort();
+    foreach (QString method, methodNames) {
+        methodsArray.append(m_methods.value(method).toJson(method));
+    }
+
+    QJsonObject diagnosticsObject;
+    diagnosticsObject.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    diagnosticsObject.insert("totalRequests", m_totalRequests);
+    diagnosticsObject.insert("methods", methodsArray);
+    return diagnosticsObject;
+}
+
+bool RpcDiagnostics::dump()
+{
+    if (m_totalRequests == 0) {
+        return false;
+    }
+
+    QSaveFile dumpFile(m_dumpFilePath);
+    if (!dumpFile.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write RPC diagnostics to" << m_dumpFilePath;
+        return false;
+    }
+
+    dumpFile.write(QJsonDocument(toJson()).toJson());
+    return dumpFile.commit();
+}
+
+void RpcDiagnostics::reset()
+{
+    m_methods.clear();
+    m_totalRequests = 0;
+    emit updated();
+}
+
+void RpcDiagnostics::scheduleUpdate()
+{
+    if (!m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef RPCDIAGNOSTICS_H
+#define RPCDIAGNOSTICS_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QTimer>
+#include <QVariantList>
+#include <QVector>
+
+class RpcMethodStatistics
+{
+public:
+    RpcMethodStatistics();
+
+    void addLatency(qint64 latency);
+    // Upper bound of the histogram bucket the quantile falls in (ms)
+    qint64 latencyPercentile(double quantile) const;
+
+    QJsonObject toJson(const QString &method) const;
+
+    static const QVector<qint64> &bucketBounds();
+
+    int m_count;
+    int m_errorCount;
+    QVector<int> m_latencyHistogram;
+    qint64 m_totalLatency;
+    qint64 m_maxLatency;
+
+    qint64 m_lastBytes;
+    qint64 m_maxBytes;
+    qint64 m_totalBytes;
+
+    int m_parseCount;
+    qint64 m_totalParseTime;
+    int m_applyCount;
+    qint64 m_totalApplyTime;
+};
+
+// Per method RPC latency, size and processing time. Filled by
+// RpcConnectionPool for everything on the wire and by the models for the
+// time spent applying a reply. Dumped as JSON every minute.
+class RpcDiagnostics : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantList methods READ methods NOTIFY updated)
+    Q_PROPERTY(int totalRequests READ totalRequests NOTIFY updated)
+    Q_PROPERTY(QString dumpFilePath READ dumpFilePath CONSTANT)
+
+public:
+    enum Stage {
+        ParseStage,
+        ApplyStage
+    };
+
+    RpcDiagnostics(QObject *parent = 0);
+
+    static RpcDiagnostics* instance();
+
+    void recordReply(const QString &method, qint64 latency, qint64 bytes, bool error);
+    void recordStage(const QString &method, Stage stage, qint64 elapsed);
+
+    QVariantList methods() const;
+    int totalRequests() const;
+    QString dumpFilePath() const;
+
+    QJsonObject toJson() const;
+
+public slots:
+    bool dump();
+    void reset();
+
+signals:
+    void updated();
+
+private:
+    void scheduleUpdate();
+
+    static RpcDiagnostics *sInstance;
+
+    QHash<QString, RpcMethodStatistics> m_methods;
+    int m_totalRequests;
+
+    QTimer* m_updateTimer;
+    QTimer* m_dumpTimer;
+    QString m_dumpFilePath;
+};
+
+// Times the rest of the scope as the apply stage of a reply
+class RpcApplyTimer
+{
+public:
+    explicit RpcApplyTimer(const char *method) : m_method(method)
+    {
+        m_timer.start();
+    }
+
+    ~RpcApplyTimer()
+    {
+        if (RpcDiagnostics::instance()) {
+            RpcDiagnostics::instance()->recordStage(QLatin1String(m_method), RpcDiagnostics::ApplyStage, m_timer.elapsed());
+        }
+    }
+
+private:
+    const char* m_method;
+    QElapsedTimer m_timer;
+};
+
+#endif // RPCDIAGNOSTICS_H
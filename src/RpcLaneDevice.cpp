@@ -0,0 +1,80 @@
+#include "RpcLaneDevice.h"
+
+RpcLaneDevice::RpcLaneDevice(QLocalSocket *socket, QObject *parent) : QIODevice(parent)
+{
+    m_socket = socket;
+
+    QObject::connect(m_socket, &QLocalSocket::readyRead, this, &QIODevice::readyRead);
+    QObject::connect(m_socket, &QLocalSocket::connected, this, &RpcLaneDevice::socketConnected);
+
+    // Open for good, whatever state the socket is in
+    open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+bool RpcLaneDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 RpcLaneDevice::bytesAvailable() const
+{
+    return m_injected.size() + m_socket->bytesAvailable() + QIODevice::bytesAvailable();
+}
+
+int RpcLaneDevice::queuedCount() const
+{
+    return m_queued.size();
+}
+
+void RpcLaneDevice::dropQueued(int index)
+{
+    if (index >= 0 && index < m_queued.size()) {
+        m_queued.removeAt(index);
+    }
+}
+
+void RpcLaneDevice::dropAllQueued()
+{
+    m_queued.clear();
+}
+
+void RpcLaneDevice::inject(const QByteArray &data)
+{
+    m_injected.append(data);
+    // Not from within sendMessage() or a disconnected() handler
+    QMetaObject::invokeMethod(this, "readyRead", Qt::QueuedConnection);
+}
+
+qint64 RpcLaneDevice::readData(char *data, qint64 maxSize)
+{
+    if (!m_injected.isEmpty()) {
+        qint64 size = qMin<qint64>(maxSize, m_injected.size());
+        memcpy(data, m_injected.constData(), size);
+        m_injected.remove(0, (int)size);
+        return size;
+    }
+
+    if (m_socket->state() != QLocalSocket::ConnectedState && m_socket->bytesAvailable() == 0) {
+        return 0;
+    }
+    return m_socket->read(data, maxSize);
+}
+
+qint64 RpcLaneDevice::writeData(const char *data, qint64 maxSize)
+{
+    if (m_socket->state() == QLocalSocket::ConnectedState) {
+        return m_socket->write(data, maxSize);
+    }
+
+    // QJsonRpcSocket writes each request in one go
+    m_queued.append(QByteArray(data, (int)maxSize));
+    return maxSize;
+}
+
+void RpcLaneDevice::socketConnected()
+{
+    foreach (const QByteArray &request, m_queued) {
+        m_socket->write(request);
+    }
+    m_queued.clear();
+}
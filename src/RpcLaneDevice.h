@@ -0,0 +1,45 @@
+#ifndef RPCLANEDEVICE_H
+#define RPCLANEDEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QLocalSocket>
+
+// The socket of a pool connection as QJsonRpcSocket sees it. Requests
+// written before the socket is connected are held back, one entry per
+// request, and written once it is. RpcConnectionPool decides which of
+// them may wait and for how long. It can also inject replies, so a request
+// that will never reach the daemon still finishes with an error.
+class RpcLaneDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    RpcLaneDevice(QLocalSocket *socket, QObject *parent = 0);
+
+    bool isSequential() const;
+    qint64 bytesAvailable() const;
+
+    // Held back until the socket connects, oldest first
+    int queuedCount() const;
+    void dropQueued(int index);
+    void dropAllQueued();
+
+    // Read back as if the daemon had sent it, from the event loop
+    void inject(const QByteArray &data);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void socketConnected();
+
+private:
+    QLocalSocket* m_socket;
+    QList<QByteArray> m_queued;
+    QByteArray m_injected;
+};
+
+#endif // RPCLANEDEVICE_H
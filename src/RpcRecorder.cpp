@@ -0,0 +1,171 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+
+#include "RpcRecorder.h"
+
+QAtomicInt RpcRecorder::sRecording;
+
+static QFile sFile;
+static QElapsedTimer sClock;
+// Hash of the last result per request, to store repeats as references
+static QHash<QByteArray, QByteArray> sLastResults;
+static qint64 sEntries = 0;
+static qint64 sRepeatedEntries = 0;
+
+static QByteArray compact(const QJsonValue &value)
+{
+    if (value.isObject()) {
+        return QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+    }
+    if (value.isArray()) {
+        return QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+    }
+    QByteArray array = QJsonDocument(QJsonArray() << value).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
+
+static bool isSecretKey(const QString &key)
+{
+    static const QSet<QString> secretKeys = QSet<QString>()
+            << "payment_preimage"
+            << "preimage"
+            << "payment_secret"
+            << "secret"
+            << "hsm_secret"
+            << "password"
+            << "seed";
+
+    return secretKeys.contains(key);
+}
+
+// Same length and still distinct per value, so the models see the same shapes
+static QString pseudonym(const QString &secret)
+{
+    QByteArray hash = QCryptographicHash::hash(secret.toUtf8(), QCryptographicHash::Sha256).toHex();
+    QString result;
+    while (result.size() < secret.size()) {
+        result += QString::fromLatin1(hash);
+        hash = QCryptographicHash::hash(hash, QCryptographicHash::Sha256).toHex();
+    }
+    return result.left(secret.size());
+}
+
+bool RpcRecorder::start(const QString &filePath)
+{
+    if (isRecording()) {
+        stop();
+    }
+
+    sFile.setFileName(filePath);
+    if (!sFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Couldn't record RPC traffic to" << filePath << sFile.errorString();
+        return false;
+    }
+
+    QJsonObject header;
+    header.insert("format", QString("presto-rpc-recording"));
+    header.insert("version", 1);
+    header.insert("started", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    sFile.write(QJsonDocument(header).toJson(QJsonDocument::Compact) + '\n');
+
+    sLastResults.clear();
+    sEntries = 0;
+    sRepeatedEntries = 0;
+    sClock.start();
+    sRecording.store(1);
+
+    qDebug() << "Recording RPC traffic to" << filePath;
+    return true;
+}
+
+void RpcRecorder::stop()
+{
+    if (!isRecording()) {
+        return;
+    }
+    sRecording.store(0);
+
+    sFile.close();
+    sLastResults.clear();
+
+    qDebug() << "Recorded" << sEntries << "RPC calls," << sRepeatedEntries << "with repeated results";
+}
+
+void RpcRecorder::record(const QJsonRpcMessage &request, const QJsonRpcMessage &response, qint64 duration)
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    QByteArray method = request.method().toUtf8();
+    QByteArray params = compact(scrubbed(request.params()));
+
+    QByteArray entry;
+    entry += "{\"t\":" + QByteArray::number(sClock.elapsed() - duration);
+    entry += ",\"d\":" + QByteArray::number(duration);
+    entry += ",\"method\":" + compact(QJsonValue(request.method()));
+    if (!request.params().isUndefined() && !request.params().isNull()) {
+        entry += ",\"params\":" + params;
+    }
+
+    if (response.type() == QJsonRpcMessage::Error) {
+        QJsonObject error;
+        error.insert("code", response.errorCode());
+        error.insert("message", response.errorMessage());
+        entry += ",\"error\":" + compact(error);
+    }
+    else {
+        QByteArray result = compact(scrubbed(response.result()));
+        QByteArray requestKey = method + '\0' + params;
+        QByteArray resultHash = QCryptographicHash::hash(result, QCryptographicHash::Sha1);
+
+        if (sLastResults.value(requestKey) == resultHash) {
+            entry += ",\"same\":true";
+            sRepeatedEntries++;
+        }
+        else {
+            entry += ",\"result\":" + result;
+            sLastResults.insert(requestKey, resultHash);
+        }
+    }
+    entry += "}\n";
+
+    sFile.write(entry);
+    sEntries++;
+}
+
+QJsonValue RpcRecorder::scrubbed(const QJsonValue &value)
+{
+    if (value.isObject()) {
+        QJsonObject object = value.toObject();
+        for (QJsonObject::iterator it = object.begin(); it != object.end(); ++it) {
+            if (isSecretKey(it.key()) && it.value().isString()) {
+                it.value() = pseudonym(it.value().toString());
+            }
+            else if (it.value().isObject() || it.value().isArray()) {
+                it.value() = scrubbed(it.value());
+            }
+        }
+        return object;
+    }
+
+    if (value.isArray()) {
+        QJsonArray array = value.toArray();
+        for (int i = 0; i < array.size(); i++) {
+            if (array.at(i).isObject() || array.at(i).isArray()) {
+                array.replace(i, scrubbed(array.at(i)));
+            }
+        }
+        return array;
+    }
+
+    return value;
+}
@@ -0,0 +1,35 @@
+#ifndef RPCRECORDER_H
+#define RPCRECORDER_H
+
+#include <QAtomicInt>
+#include <QString>
+
+#include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
+
+// Records every RPC request and its answer as JSON lines, so a terminal's
+// real workload can be replayed offline with RpcReplayDaemon. Secrets are
+// replaced by a hash of the same length before anything hits the disk, and
+// a result identical to the previous one for the same request is stored as
+// a reference to it, which keeps hours of polling small.
+class RpcRecorder
+{
+public:
+    static bool isRecording()
+    {
+        return sRecording.load() != 0;
+    }
+
+    static bool start(const QString &filePath);
+    static void stop();
+
+    // duration is from sending the request to its answer (ms)
+    static void record(const QJsonRpcMessage &request, const QJsonRpcMessage &response, qint64 duration);
+
+    // Replaces the values of secret fields anywhere in value
+    static QJsonValue scrubbed(const QJsonValue &value);
+
+private:
+    static QAtomicInt sRecording;
+};
+
+#endif // RPCRECORDER_H
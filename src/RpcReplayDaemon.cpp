@@ -0,0 +1,146 @@
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "RpcReplayDaemon.h"
+#include "RpcRecorder.h"
+
+// How far ahead to look for an answer to the same params before taking the next one
+static const int paramsLookahead = 64;
+
+static QByteArray compact(const QJsonValue &value)
+{
+    if (value.isUndefined() || value.isNull()) {
+        return QByteArray();
+    }
+    if (value.isObject()) {
+        return QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+    }
+    if (value.isArray()) {
+        return QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+    }
+    QByteArray array = QJsonDocument(QJsonArray() << value).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
+
+RpcReplayDaemon::RpcReplayDaemon(QObject *parent) : MockLightningDaemon(parent)
+{
+    m_speed = 1.0;
+    m_entryCount = 0;
+}
+
+bool RpcReplayDaemon::load(const QString &filePath)
+{
+    QFile recordingFile(filePath);
+    if (!recordingFile.open(QIODevice::ReadOnly)) {
+        qDebug() << "Couldn't open RPC recording" << filePath << recordingFile.errorString();
+        return false;
+    }
+
+    QJsonObject header = QJsonDocument::fromJson(recordingFile.readLine()).object();
+    if (header.value("format").toString() != "presto-rpc-recording" || header.value("version").toInt() != 1) {
+        qDebug() << filePath << "is not an RPC recording";
+        return false;
+    }
+
+    m_methods.clear();
+    m_entryCount = 0;
+
+    // Repeated results only reference the previous one for the same request
+    QHash<QByteArray, QByteArray> lastResults;
+    int lineNumber = 1;
+
+    while (!recordingFile.atEnd()) {
+        QByteArray line = recordingFile.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError parseError;
+        QJsonObject entryObject = QJsonDocument::fromJson(line, &parseError).object();
+        if (parseError.error != QJsonParseError::NoError) {
+            // A recording cut short by a crash ends in half a line
+            qDebug() << "Skipping unreadable line" << lineNumber << "of" << filePath;
+            continue;
+        }
+
+        QString method = entryObject.value("method").toString();
+
+        Entry entry;
+        entry.duration = (qint64)entryObject.value("d").toDouble();
+        entry.params = compact(entryObject.value("params"));
+
+        QByteArray requestKey = method.toUtf8() + '\0' + entry.params;
+        if (entryObject.contains("error")) {
+            entry.result = "!" + entryObject.value("error").toObject().value("message").toString().toUtf8();
+        }
+        else if (entryObject.value("same").toBool()) {
+            entry.result = lastResults.value(requestKey);
+        }
+        else {
+            entry.result = compact(entryObject.value("result"));
+            lastResults.insert(requestKey, entry.result);
+        }
+
+        if (entry.result.isNull()) {
+            continue;
+        }
+
+        m_methods[method].entries.append(entry);
+        m_entryCount++;
+    }
+
+    qDebug() << "Replaying" << m_entryCount << "RPC calls of" << m_methods.size() << "methods from" << filePath;
+    return true;
+}
+
+double RpcReplayDaemon::speed() const
+{
+    return m_speed;
+}
+
+void RpcReplayDaemon::setSpeed(double speed)
+{
+    m_speed = qMax(0.0, speed);
+}
+
+int RpcReplayDaemon::entryCount() const
+{
+    return m_entryCount;
+}
+
+QByteArray RpcReplayDaemon::handleMethod(QLocalSocket *socket, const QString &method, const QJsonValue &id,
+                                         const QJsonValue &params, int &extraLatency, bool &deferred)
+{
+    Q_UNUSED(socket)
+    Q_UNUSED(id)
+    Q_UNUSED(deferred)
+
+    if (!m_methods.contains(method)) {
+        return "!Not in the recording";
+    }
+
+    MethodEntries &methodEntries = m_methods[method];
+    const QList<Entry> &entries = methodEntries.entries;
+
+    // Recorded params are scrubbed, so secrets never match and we fall back to order
+    QByteArray requestParams = compact(RpcRecorder::scrubbed(params));
+    int index = qMin(methodEntries.next, entries.size() - 1);
+    int lookaheadEnd = qMin(entries.size(), methodEntries.next + paramsLookahead);
+    for (int i = methodEntries.next; i < lookaheadEnd; i++) {
+        if (entries.at(i).params == requestParams) {
+            index = i;
+            break;
+        }
+    }
+    methodEntries.next = qMin(index + 1, entries.size());
+
+    const Entry &entry = entries.at(index);
+    if (m_speed > 0) {
+        extraLatency = (int)(entry.duration / m_speed);
+    }
+    return entry.result;
+}
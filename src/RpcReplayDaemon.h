@@ -0,0 +1,53 @@
+#ifndef RPCREPLAYDAEMON_H
+#define RPCREPLAYDAEMON_H
+
+#include <QHash>
+#include <QList>
+
+#include "MockLightningDaemon.h"
+
+// Answers RPC calls from an RpcRecorder file instead of synthetic data.
+// Each method gets its recorded answers in order, preferring one recorded
+// with the same params, and each answer takes its recorded time divided by
+// speed. Once a method runs out it keeps getting its last answer, so the
+// models can keep polling after the recording ends.
+class RpcReplayDaemon : public MockLightningDaemon
+{
+    Q_OBJECT
+
+public:
+    RpcReplayDaemon(QObject *parent = 0);
+
+    bool load(const QString &filePath);
+
+    // 1 is real time, 10 ten times faster, 0 answers immediately
+    double speed() const;
+    void setSpeed(double speed);
+
+    int entryCount() const;
+
+protected:
+    QByteArray handleMethod(QLocalSocket *socket, const QString &method, const QJsonValue &id,
+                            const QJsonValue &params, int &extraLatency, bool &deferred);
+
+private:
+    struct Entry {
+        qint64 duration;
+        QByteArray params;
+        // Result JSON, or "!" and the error message
+        QByteArray result;
+    };
+
+    struct MethodEntries {
+        MethodEntries() : next(0) {}
+
+        QList<Entry> entries;
+        int next;
+    };
+
+    QHash<QString, MethodEntries> m_methods;
+    double m_speed;
+    int m_entryCount;
+};
+
+#endif // RPCREPLAYDAEMON_H
@@ -0,0 +1,290 @@
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QStringList>
+
+#include "SnapshotCache.h"
+#include "Tracer.h"
+
+static const quint32 snapshotMagic = 0x50534e50; // PSNP
+static const quint32 snapshotVersion = 1;
+// Binary JSON has to start 4 byte aligned, the mapping itself is page aligned
+static const int sectionAlignment = 8;
+static const int saveInterval = 5 * 60 * 1000;
+
+SnapshotCache *SnapshotCache::sInstance = 0;
+
+static int aligned(int offset)
+{
+    return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+}
+
+SnapshotCache::SnapshotCache(QObject *parent) : QObject(parent)
+{
+    sInstance = this;
+
+    m_map = nullptr;
+    m_dirty = false;
+
+    QString snapshotDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(snapshotDirectory);
+    m_filePath = snapshotDirectory + "/snapshot.bin";
+
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setInterval(saveInterval);
+    QObject::connect(m_saveTimer, &QTimer::timeout, this, &SnapshotCache::save);
+    m_saveTimer->start();
+}
+
+SnapshotCache::~SnapshotCache()
+{
+    unmap();
+    if (sInstance == this) {
+        sInstance = 0;
+    }
+}
+
+SnapshotCache *SnapshotCache::instance()
+{
+    return sInstance;
+}
+
+bool SnapshotCache::isSnapshotMethod(const QString &method)
+{
+    static const QSet<QString> snapshotMethods = QSet<QString>()
+            << "getinfo"
+            << "listinvoices"
+            << "listpayments"
+            << "listpeers"
+            << "listfunds"
+            << "listnodes";
+
+    return snapshotMethods.contains(method);
+}
+
+QString SnapshotCache::filePath() const
+{
+    return m_filePath;
+}
+
+bool SnapshotCache::load()
+{
+    TRACE_SCOPE("startup", "loadSnapshot");
+
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+
+    qint64 savedAt = 0;
+    if (!mapFile(&savedAt)) {
+        return false;
+    }
+    m_savedAt = QDateTime::fromMSecsSinceEpoch(savedAt);
+
+    qDebug() << "Loaded snapshot from" << m_savedAt.toString(Qt::ISODate)
+             << "with" << m_sections.size() << "sections in" << loadTimer.elapsed() << "ms";
+    emit loaded();
+    return true;
+}
+
+bool SnapshotCache::mapFile(qint64 *savedAt)
+{
+    unmap();
+
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 fileSize = m_file.size();
+    m_map = m_file.map(0, fileSize);
+    if (!m_map) {
+        qDebug() << "Couldn't map snapshot" << m_filePath << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    QByteArray mapped = QByteArray::fromRawData((const char *)m_map, (int)fileSize);
+    QDataStream stream(mapped);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 fileSavedAt = 0;
+    quint32 sectionCount = 0;
+    stream >> magic >> version >> fileSavedAt >> sectionCount;
+
+    if (stream.status() != QDataStream::Ok || magic != snapshotMagic || version != snapshotVersion) {
+        qDebug() << "Ignoring snapshot" << m_filePath << "with unknown format";
+        unmap();
+        return false;
+    }
+
+    QHash<QString, Section> sections;
+    for (quint32 i = 0; i < sectionCount; i++) {
+        QString method;
+        Section section;
+        quint32 offset = 0;
+        stream >> method >> section.receivedAt >> offset >> section.size;
+
+        if (stream.status() != QDataStream::Ok || offset % sectionAlignment != 0
+                || (qint64)offset + section.size > fileSize) {
+            qDebug() << "Ignoring truncated snapshot" << m_filePath;
+            unmap();
+            return false;
+        }
+
+        section.data = m_map + offset;
+        section.fresh = false;
+        sections.insert(method, section);
+    }
+
+    // Whatever came in since is newer than the file
+    for (QHash<QString, Section>::const_iterator it = sections.constBegin(); it != sections.constEnd(); ++it) {
+        if (!m_sections.value(it.key()).fresh) {
+            m_sections.insert(it.key(), it.value());
+        }
+    }
+
+    if (savedAt) {
+        *savedAt = fileSavedAt;
+    }
+    return true;
+}
+
+void SnapshotCache::unmap()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+
+    // Nothing may point into the mapping anymore
+    QHash<QString, Section>::iterator it = m_sections.begin();
+    while (it != m_sections.end()) {
+        if (it.value().fresh) {
+            ++it;
+        }
+        else {
+            it = m_sections.erase(it);
+        }
+    }
+}
+
+QJsonObject SnapshotCache::result(const QString &method) const
+{
+    if (!m_sections.contains(method)) {
+        return QJsonObject();
+    }
+
+    const Section &section = m_sections[method];
+    if (section.fresh) {
+        return section.result;
+    }
+
+    // No copy, the document reads straight from the mapping
+    QJsonDocument document = QJsonDocument::fromRawData((const char *)section.data, (int)section.size,
+                                                        QJsonDocument::Validate);
+    return document.object();
+}
+
+QDateTime SnapshotCache::savedAt() const
+{
+    return m_savedAt;
+}
+
+void SnapshotCache::storeResult(const QJsonRpcMessage &request, const QJsonRpcMessage &response)
+{
+    // Only the whole lists, not a listinvoices for a single label
+    if (response.type() != QJsonRpcMessage::Response || !isSnapshotMethod(request.method())) {
+        return;
+    }
+    QJsonValue params = request.params();
+    if (!(params.isUndefined() || params.isNull()
+          || (params.isArray() && params.toArray().isEmpty())
+          || (params.isObject() && params.toObject().isEmpty()))) {
+        return;
+    }
+
+    Section section;
+    section.receivedAt = QDateTime::currentMSecsSinceEpoch();
+    section.data = nullptr;
+    section.size = 0;
+    section.result = response.result().toObject();
+    section.fresh = true;
+    m_sections.insert(request.method(), section);
+
+    m_dirty = true;
+}
+
+bool SnapshotCache::save()
+{
+    if (!m_dirty) {
+        return true;
+    }
+
+    TRACE_SCOPE("model", "saveSnapshot");
+
+    QStringList methods = m_sections.keys();
+    QList<QByteArray> sectionData;
+    foreach (QString method, methods) {
+        const Section &section = m_sections[method];
+        if (section.fresh) {
+            sectionData << QJsonDocument(section.result).toBinaryData();
+        }
+        else {
+            sectionData << QByteArray((const char *)section.data, (int)section.size);
+        }
+    }
+
+    // The index has fixed width fields but for the names, so write it once
+    // to learn its size and again with the real offsets
+    QByteArray index;
+    for (int pass = 0; pass < 2; pass++) {
+        int offset = aligned(index.size());
+        index.clear();
+
+        QDataStream stream(&index, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_6);
+        stream << snapshotMagic << snapshotVersion << QDateTime::currentMSecsSinceEpoch()
+               << (quint32)methods.size();
+
+        for (int i = 0; i < methods.size(); i++) {
+            stream << methods.at(i) << m_sections[methods.at(i)].receivedAt
+                   << (quint32)offset << (quint32)sectionData.at(i).size();
+            offset = aligned(offset + sectionData.at(i).size());
+        }
+    }
+
+    QSaveFile snapshotFile(m_filePath);
+    if (!snapshotFile.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write snapshot to" << m_filePath;
+        return false;
+    }
+
+    snapshotFile.write(index);
+    qint64 written = index.size();
+    foreach (const QByteArray &data, sectionData) {
+        snapshotFile.write(QByteArray(aligned(written) - written, '\0'));
+        snapshotFile.write(data);
+        written = aligned(written) + data.size();
+    }
+
+    // The old mapping has been copied, let go of it before the file is replaced
+    unmap();
+    bool committed = snapshotFile.commit();
+    if (committed) {
+        m_dirty = false;
+    }
+    else {
+        qDebug() << "Couldn't write snapshot to" << m_filePath << snapshotFile.errorString();
+    }
+
+    mapFile();
+    return committed;
+}
@@ -0,0 +1,74 @@
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QTimer>
+
+#include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
+
+// Keeps the last getinfo and list* results on disk so the models can show
+// the last known state at launch, before the daemon answers. Sections are
+// Qt binary JSON behind a QDataStream index, read straight out of a memory
+// mapping without parsing.
+class SnapshotCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    SnapshotCache(QObject *parent = 0);
+    ~SnapshotCache();
+
+    static SnapshotCache* instance();
+
+    // Whether method's answer is part of the snapshot
+    static bool isSnapshotMethod(const QString &method);
+
+    QString filePath() const;
+
+    bool load();
+    // Empty if the loaded snapshot has no result for method. Only valid
+    // until the next save(), the data lives in the mapping.
+    QJsonObject result(const QString &method) const;
+    // When the snapshot that was loaded was written, invalid if none
+    QDateTime savedAt() const;
+
+    // Called with every RPC answer, keeps the ones that belong in the snapshot
+    void storeResult(const QJsonRpcMessage &request, const QJsonRpcMessage &response);
+
+public slots:
+    bool save();
+
+signals:
+    void loaded();
+
+private:
+    struct Section {
+        qint64 receivedAt;
+        // Into the mapping, or the result that replaced it
+        const uchar* data;
+        quint32 size;
+        QJsonObject result;
+        bool fresh;
+    };
+
+    // Maps the file and points the sections that weren't refreshed into it
+    bool mapFile(qint64 *savedAt = nullptr);
+    void unmap();
+
+    static SnapshotCache *sInstance;
+
+    QString m_filePath;
+    QFile m_file;
+    uchar* m_map;
+    QHash<QString, Section> m_sections;
+    QDateTime m_savedAt;
+    bool m_dirty;
+
+    QTimer* m_saveTimer;
+};
+
+#endif // SNAPSHOTCACHE_H
@@ -0,0 +1,351 @@
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+#include "TimeSeriesModel.h"
+#include "Tracer.h"
+
+// New samples arrive in bursts, e.g. a listinvoices or a history slice
+static const int updateDelay = 100;
+
+static bool sampleBefore(const RevenueSample &a, const RevenueSample &b)
+{
+    return a.timestamp < b.timestamp;
+}
+
+TimeSeriesModel::TimeSeriesModel(RevenueAggregator *aggregator, Series series, QObject *parent)
+    : QAbstractListModel(parent)
+{
+    m_aggregator = aggregator;
+    m_series = series;
+    m_method = Lttb;
+    m_width = 600;
+    m_from = 0;
+    m_to = 0;
+    m_minValue = 0;
+    m_maxValue = 0;
+    m_stale = false;
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(updateDelay);
+    m_updateTimer->setSingleShot(true);
+    QObject::connect(m_updateTimer, &QTimer::timeout, this, &TimeSeriesModel::startUpdate);
+
+    QObject::connect(&m_watcher, &QFutureWatcher<QVector<QPointF> >::finished, this, &TimeSeriesModel::updateFinished);
+    QObject::connect(m_aggregator, &RevenueAggregator::samplesChanged, this, &TimeSeriesModel::scheduleUpdate);
+
+    startUpdate();
+}
+
+TimeSeriesModel::~TimeSeriesModel()
+{
+    // The worker only has its own copies, but the watcher must not outlive us
+    m_watcher.waitForFinished();
+}
+
+QHash<int, QByteArray> TimeSeriesModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[TimestampRole] = "timestamp";
+    roles[ValueRole] = "value";
+    return roles;
+}
+
+int TimeSeriesModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_points.count();
+}
+
+QVariant TimeSeriesModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_points.count())
+        return QVariant();
+
+    const QPointF &point = m_points.at(index.row());
+    if (role == TimestampRole)
+        return point.x();
+    else if (role == ValueRole)
+        return point.y();
+    return QVariant();
+}
+
+TimeSeriesModel::Series TimeSeriesModel::series() const
+{
+    return m_series;
+}
+
+void TimeSeriesModel::setSeries(Series series)
+{
+    if (m_series == series) {
+        return;
+    }
+    m_series = series;
+    emit seriesChanged();
+    scheduleUpdate();
+}
+
+TimeSeriesModel::Method TimeSeriesModel::method() const
+{
+    return m_method;
+}
+
+void TimeSeriesModel::setMethod(Method method)
+{
+    if (m_method == method) {
+        return;
+    }
+    m_method = method;
+    emit methodChanged();
+    scheduleUpdate();
+}
+
+int TimeSeriesModel::width() const
+{
+    return m_width;
+}
+
+void TimeSeriesModel::setWidth(int width)
+{
+    width = qMax(3, width);
+    if (m_width == width) {
+        return;
+    }
+    m_width = width;
+    emit widthChanged();
+    scheduleUpdate();
+}
+
+qint64 TimeSeriesModel::from() const
+{
+    return m_from;
+}
+
+void TimeSeriesModel::setFrom(qint64 from)
+{
+    if (m_from == from) {
+        return;
+    }
+    m_from = from;
+    emit rangeChanged();
+    scheduleUpdate();
+}
+
+qint64 TimeSeriesModel::to() const
+{
+    return m_to;
+}
+
+void TimeSeriesModel::setTo(qint64 to)
+{
+    if (m_to == to) {
+        return;
+    }
+    m_to = to;
+    emit rangeChanged();
+    scheduleUpdate();
+}
+
+bool TimeSeriesModel::computing() const
+{
+    return m_watcher.isRunning();
+}
+
+double TimeSeriesModel::minValue() const
+{
+    return m_minValue;
+}
+
+double TimeSeriesModel::maxValue() const
+{
+    return m_maxValue;
+}
+
+double TimeSeriesModel::minTimestamp() const
+{
+    return m_points.isEmpty() ? 0 : m_points.first().x();
+}
+
+double TimeSeriesModel::maxTimestamp() const
+{
+    return m_points.isEmpty() ? 0 : m_points.last().x();
+}
+
+void TimeSeriesModel::scheduleUpdate()
+{
+    if (!m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
+
+void TimeSeriesModel::startUpdate()
+{
+    if (m_watcher.isRunning()) {
+        m_stale = true;
+        return;
+    }
+    m_stale = false;
+
+    Query query;
+    query.series = m_series;
+    query.method = m_method;
+    query.width = m_width;
+    query.from = m_from;
+    query.to = m_to;
+
+    m_watcher.setFuture(QtConcurrent::run(&TimeSeriesModel::downsample, m_aggregator->samples(), query));
+    emit computingChanged();
+}
+
+void TimeSeriesModel::updateFinished()
+{
+    if (m_stale) {
+        // Outdated already, don't make the view draw it
+        startUpdate();
+        return;
+    }
+
+    beginResetModel();
+    m_points = m_watcher.result();
+    endResetModel();
+
+    m_minValue = 0;
+    m_maxValue = 0;
+    if (!m_points.isEmpty()) {
+        m_minValue = m_maxValue = m_points.first().y();
+        foreach (const QPointF &point, m_points) {
+            m_minValue = qMin(m_minValue, point.y());
+            m_maxValue = qMax(m_maxValue, point.y());
+        }
+    }
+
+    emit pointsChanged();
+    emit computingChanged();
+}
+
+QVector<QPointF> TimeSeriesModel::downsample(QVector<RevenueSample> samples, const Query &query)
+{
+    TRACE_SCOPE("model", "downsampleTimeSeries");
+
+    // Mostly in order already, history may come in after the live rows
+    if (!std::is_sorted(samples.constBegin(), samples.constEnd(), sampleBefore)) {
+        std::stable_sort(samples.begin(), samples.end(), sampleBefore);
+    }
+
+    QVector<QPointF> points;
+    points.reserve(samples.size());
+
+    qint64 balance = 0;
+    foreach (const RevenueSample &sample, samples) {
+        // The balance has to include what came before the range
+        balance += sample.msatoshi;
+        if ((query.from > 0 && sample.timestamp < query.from) || (query.to > 0 && sample.timestamp > query.to)) {
+            continue;
+        }
+        points.append(QPointF(sample.timestamp, query.series == Balance ? balance : sample.msatoshi));
+    }
+
+    if (points.size() <= query.width) {
+        return points;
+    }
+    if (query.method == MinMax) {
+        return minMaxEnvelope(points, qMax(1, query.width / 2));
+    }
+    return largestTriangleThreeBuckets(points, query.width);
+}
+
+QVector<QPointF> TimeSeriesModel::largestTriangleThreeBuckets(const QVector<QPointF> &points, int threshold)
+{
+    int count = points.size();
+    if (threshold >= count || threshold < 3) {
+        return points;
+    }
+
+    QVector<QPointF> sampled;
+    sampled.reserve(threshold);
+
+    // First and last are always kept, the rest is split into even buckets
+    double bucketSize = double(count - 2) / (threshold - 2);
+    int previous = 0;
+    sampled.append(points.at(0));
+
+    for (int bucket = 0; bucket < threshold - 2; bucket++) {
+        // Average of the next bucket is the third corner of the triangle
+        int nextStart = (int)std::floor((bucket + 1) * bucketSize) + 1;
+        int nextEnd = qMin((int)std::floor((bucket + 2) * bucketSize) + 1, count);
+        double averageX = 0;
+        double averageY = 0;
+        for (int i = nextStart; i < nextEnd; i++) {
+            averageX += points.at(i).x();
+            averageY += points.at(i).y();
+        }
+        int nextCount = qMax(1, nextEnd - nextStart);
+        averageX /= nextCount;
+        averageY /= nextCount;
+
+        int start = (int)std::floor(bucket * bucketSize) + 1;
+        int end = (int)std::floor((bucket + 1) * bucketSize) + 1;
+        const QPointF &a = points.at(previous);
+
+        double maxArea = -1;
+        int chosen = start;
+        for (int i = start; i < end; i++) {
+            double area = std::fabs((a.x() - averageX) * (points.at(i).y() - a.y())
+                                    - (a.x() - points.at(i).x()) * (averageY - a.y()));
+            if (area > maxArea) {
+                maxArea = area;
+                chosen = i;
+            }
+        }
+
+        sampled.append(points.at(chosen));
+        previous = chosen;
+    }
+
+    sampled.append(points.at(count - 1));
+    return sampled;
+}
+
+QVector<QPointF> TimeSeriesModel::minMaxEnvelope(const QVector<QPointF> &points, int columns)
+{
+    QVector<QPointF> envelope;
+    if (points.isEmpty()) {
+        return envelope;
+    }
+    envelope.reserve(columns * 2);
+
+    double first = points.first().x();
+    double span = points.last().x() - first;
+
+    int column = -1;
+    int minIndex = 0;
+    int maxIndex = 0;
+    for (int i = 0; i < points.size(); i++) {
+        int pointColumn = span > 0 ? qMin(columns - 1, (int)((points.at(i).x() - first) / span * columns)) : 0;
+        if (pointColumn != column) {
+            if (column >= 0) {
+                // In time order so the line doesn't double back
+                envelope.append(points.at(qMin(minIndex, maxIndex)));
+                if (minIndex != maxIndex) {
+                    envelope.append(points.at(qMax(minIndex, maxIndex)));
+                }
+            }
+            column = pointColumn;
+            minIndex = maxIndex = i;
+            continue;
+        }
+        if (points.at(i).y() < points.at(minIndex).y()) {
+            minIndex = i;
+        }
+        if (points.at(i).y() > points.at(maxIndex).y()) {
+            maxIndex = i;
+        }
+    }
+    envelope.append(points.at(qMin(minIndex, maxIndex)));
+    if (minIndex != maxIndex) {
+        envelope.append(points.at(qMax(minIndex, maxIndex)));
+    }
+
+    return envelope;
+}
@@ -0,0 +1,128 @@
+#ifndef TIMESERIESMODEL_H
+#define TIMESERIESMODEL_H
+
+#include <QAbstractListModel>
+#include <QFutureWatcher>
+#include <QPointF>
+#include <QTimer>
+#include <QVector>
+
+#include "RevenueAggregator.h"
+
+// Balance or payments over time, cut down to about one point per pixel of
+// the chart so a year of activity is a few hundred rows, not thousands.
+// The downsampling runs on the thread pool; the rows are replaced in one
+// go when it is done.
+class TimeSeriesModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(Series series READ series WRITE setSeries NOTIFY seriesChanged)
+    Q_PROPERTY(Method method READ method WRITE setMethod NOTIFY methodChanged)
+    // Points to aim for, usually the chart's width in pixels
+    Q_PROPERTY(int width READ width WRITE setWidth NOTIFY widthChanged)
+    // Seconds since epoch, 0 leaves that end open
+    Q_PROPERTY(qint64 from READ from WRITE setFrom NOTIFY rangeChanged)
+    Q_PROPERTY(qint64 to READ to WRITE setTo NOTIFY rangeChanged)
+    Q_PROPERTY(bool computing READ computing NOTIFY computingChanged)
+    // Of the current rows, for the axes
+    Q_PROPERTY(double minValue READ minValue NOTIFY pointsChanged)
+    Q_PROPERTY(double maxValue READ maxValue NOTIFY pointsChanged)
+    Q_PROPERTY(double minTimestamp READ minTimestamp NOTIFY pointsChanged)
+    Q_PROPERTY(double maxTimestamp READ maxTimestamp NOTIFY pointsChanged)
+
+public:
+    enum Series {
+        // Running sum of what came in and went out. Relative to where the
+        // history starts, funds that were never an invoice or payment
+        // aren't in it.
+        Balance,
+        // Each payment, outgoing ones negative
+        Payments
+    };
+    Q_ENUM(Series)
+
+    enum Method {
+        // Largest-Triangle-Three-Buckets, keeps the shape of a line
+        Lttb,
+        // Lowest and highest point of each column, keeps every spike
+        MinMax
+    };
+    Q_ENUM(Method)
+
+    // What to compute, with everything the worker needs besides the samples
+    struct Query {
+        Series series;
+        Method method;
+        int width;
+        qint64 from;
+        qint64 to;
+    };
+
+    enum PointRoles {
+        TimestampRole = Qt::UserRole + 1,
+        ValueRole
+    };
+
+    TimeSeriesModel(RevenueAggregator *aggregator, Series series = Balance, QObject *parent = 0);
+    ~TimeSeriesModel();
+
+    QHash<int, QByteArray> roleNames() const;
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    Series series() const;
+    void setSeries(Series series);
+    Method method() const;
+    void setMethod(Method method);
+    int width() const;
+    void setWidth(int width);
+    qint64 from() const;
+    void setFrom(qint64 from);
+    qint64 to() const;
+    void setTo(qint64 to);
+
+    bool computing() const;
+    double minValue() const;
+    double maxValue() const;
+    double minTimestamp() const;
+    double maxTimestamp() const;
+
+    // The whole pipeline, thread safe. x is seconds, y msat.
+    static QVector<QPointF> downsample(QVector<RevenueSample> samples, const Query &query);
+    static QVector<QPointF> largestTriangleThreeBuckets(const QVector<QPointF> &points, int threshold);
+    static QVector<QPointF> minMaxEnvelope(const QVector<QPointF> &points, int columns);
+
+signals:
+    void seriesChanged();
+    void methodChanged();
+    void widthChanged();
+    void rangeChanged();
+    void computingChanged();
+    void pointsChanged();
+
+private slots:
+    void scheduleUpdate();
+    void startUpdate();
+    void updateFinished();
+
+private:
+    RevenueAggregator* m_aggregator;
+
+    Series m_series;
+    Method m_method;
+    int m_width;
+    qint64 m_from;
+    qint64 m_to;
+
+    QVector<QPointF> m_points;
+    double m_minValue;
+    double m_maxValue;
+
+    // Something changed while the last update was running
+    bool m_stale;
+    QTimer* m_updateTimer;
+    QFutureWatcher<QVector<QPointF> > m_watcher;
+};
+
+#endif // TIMESERIESMODEL_H
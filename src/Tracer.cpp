@@ -0,0 +1,159 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+
+#include "Tracer.h"
+
+// Keeps a forgotten tracer from eating all memory, roughly 50 MB
+static const int maxEvents = 1000000;
+
+struct TraceEvent
+{
+    char phase;
+    const char* category;
+    QString name;
+    qint64 timestamp;
+    qint64 duration;
+    quint64 id;
+    quintptr threadId;
+};
+
+QAtomicInt Tracer::sEnabled;
+
+static QMutex sMutex;
+static QElapsedTimer sClock;
+static QVector<TraceEvent> sEvents;
+static QString sFilePath;
+static int sDroppedEvents = 0;
+
+static void addEvent(char phase, const char *category, const QString &name,
+                     qint64 timestamp, qint64 duration, quint64 id)
+{
+    QMutexLocker locker(&sMutex);
+    if (sEvents.size() >= maxEvents) {
+        sDroppedEvents++;
+        return;
+    }
+
+    TraceEvent event;
+    event.phase = phase;
+    event.category = category;
+    event.name = name;
+    event.timestamp = timestamp;
+    event.duration = duration;
+    event.id = id;
+    event.threadId = (quintptr)QThread::currentThreadId();
+    sEvents.append(event);
+}
+
+static QString escaped(const QString &string)
+{
+    QString result;
+    result.reserve(string.size());
+    foreach (QChar character, string) {
+        if (character == '"' || character == '\\') {
+            result += '\\';
+            result += character;
+        }
+        else if (character.unicode() < 0x20) {
+            result += QString("\\u%1").arg(character.unicode(), 4, 16, QChar('0'));
+        }
+        else {
+            result += character;
+        }
+    }
+    return result;
+}
+
+void Tracer::start(const QString &filePath)
+{
+    QMutexLocker locker(&sMutex);
+    sFilePath = filePath;
+    sEvents.clear();
+    sEvents.reserve(4096);
+    sDroppedEvents = 0;
+    sClock.start();
+    sEnabled.store(1);
+
+    qDebug() << "Tracing to" << filePath;
+}
+
+bool Tracer::stop()
+{
+    if (!isEnabled()) {
+        return false;
+    }
+    sEnabled.store(0);
+
+    QMutexLocker locker(&sMutex);
+
+    QSaveFile traceFile(sFilePath);
+    if (!traceFile.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write trace to" << sFilePath;
+        return false;
+    }
+
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QTextStream stream(&traceFile);
+    stream.setCodec("UTF-8");
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (int i = 0; i < sEvents.size(); i++) {
+        const TraceEvent &event = sEvents.at(i);
+        stream << "{\"ph\":\"" << event.phase
+               << "\",\"cat\":\"" << event.category
+               << "\",\"name\":\"" << escaped(event.name)
+               << "\",\"ts\":" << event.timestamp
+               << ",\"pid\":" << pid
+               << ",\"tid\":" << (quint64)event.threadId;
+        if (event.phase == 'X') {
+            stream << ",\"dur\":" << event.duration;
+        }
+        else if (event.phase == 'b' || event.phase == 'e') {
+            stream << ",\"id\":\"0x" << QString::number(event.id, 16) << "\"";
+        }
+        else if (event.phase == 'i') {
+            stream << ",\"s\":\"t\"";
+        }
+        stream << (i + 1 < sEvents.size() ? "},\n" : "}\n");
+    }
+    stream << "]}\n";
+    stream.flush();
+
+    qDebug() << "Wrote" << sEvents.size() << "trace events," << sDroppedEvents << "dropped";
+    sEvents.clear();
+    sEvents.squeeze();
+
+    return traceFile.commit();
+}
+
+qint64 Tracer::timestamp()
+{
+    return sClock.nsecsElapsed() / 1000;
+}
+
+void Tracer::complete(const char *category, const QString &name, qint64 start, qint64 duration)
+{
+    addEvent('X', category, name, start, duration, 0);
+}
+
+void Tracer::instant(const char *category, const QString &name)
+{
+    addEvent('i', category, name, timestamp(), 0, 0);
+}
+
+void Tracer::beginAsync(const char *category, const QString &name, quint64 id)
+{
+    addEvent('b', category, name, timestamp(), 0, id);
+}
+
+void Tracer::endAsync(const char *category, const QString &name, quint64 id)
+{
+    addEvent('e', category, name, timestamp(), 0, id);
+}
@@ -0,0 +1,69 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QString>
+
+// Records spans in the Chrome trace event format, loadable in Perfetto or
+// chrome://tracing. Off unless started, every macro below is then a single
+// relaxed atomic load.
+class Tracer
+{
+public:
+    static bool isEnabled()
+    {
+        return sEnabled.load() != 0;
+    }
+
+    // Collects events in memory until stop() writes them to filePath
+    static void start(const QString &filePath);
+    static bool stop();
+
+    // Microseconds since the tracer was started
+    static qint64 timestamp();
+
+    static void complete(const char *category, const QString &name, qint64 start, qint64 duration);
+    static void instant(const char *category, const QString &name);
+    static void beginAsync(const char *category, const QString &name, quint64 id);
+    static void endAsync(const char *category, const QString &name, quint64 id);
+
+private:
+    static QAtomicInt sEnabled;
+};
+
+// Records a complete event from construction to the end of the scope
+class TraceScope
+{
+public:
+    TraceScope(const char *category, const char *name)
+        : m_category(category), m_name(name), m_start(Tracer::isEnabled() ? Tracer::timestamp() : -1)
+    {}
+
+    ~TraceScope()
+    {
+        if (m_start >= 0 && Tracer::isEnabled()) {
+            Tracer::complete(m_category, QLatin1String(m_name), m_start, Tracer::timestamp() - m_start);
+        }
+    }
+
+private:
+    const char* m_category;
+    const char* m_name;
+    qint64 m_start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+
+#define TRACE_INSTANT(category, name) \
+    do { if (Tracer::isEnabled()) Tracer::instant(category, name); } while (0)
+
+#define TRACE_ASYNC_BEGIN(category, name, id) \
+    do { if (Tracer::isEnabled()) Tracer::beginAsync(category, name, (quint64)(id)); } while (0)
+
+#define TRACE_ASYNC_END(category, name, id) \
+    do { if (Tracer::isEnabled()) Tracer::endAsync(category, name, (quint64)(id)); } while (0)
+
+#endif // TRACER_H
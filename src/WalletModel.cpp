@@ -1,49 +1,42 @@
 #include "WalletModel.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcservicereply.h"
 #include "macros.h"
+#include "RpcDiagnostics.h"
+#include "Tracer.h"
 
-WalletModel::WalletModel(QJsonRpcSocket *rpcSocket)
+static constexpr KeyedListModelField<FundsTransaction> outputFields[] = {
+    KEYED_FIELD(FundsTransaction, WalletModel::TxidRole, "txid", txId),
+    KEYED_FIELD(FundsTransaction, WalletModel::OutputRole, "output", outputs),
+    KEYED_FIELD(FundsTransaction, WalletModel::SatoshiRole, "satoshi", amountSatoshi),
+    KEYED_FIELD(FundsTransaction, WalletModel::ConfirmedRole, "confirmed", confirmed)
+};
+
+WalletModel::WalletModel(RpcConnectionPool *rpcSocket)
+    : KeyedListModel<FundsTransaction, QString>(outputFields, &WalletModel::outputKey)
 {
     m_rpcSocket = rpcSocket;
-    m_funds = QList<FundsTransaction>();
+    m_confirmedSatoshi = 0;
+    m_unconfirmedSatoshi = 0;
 }
 
-QHash<int, QByteArray> WalletModel::roleNames() const {
-    QHash<int, QByteArray> roles;
-    roles[TxidRole] = "txid";
-    roles[OutputRole] = "output";
-    roles[SatoshiRole] = "satoshi";
-    return roles;
+QString WalletModel::outputKey(const FundsTransaction &fundsTransaction)
+{
+    return fundsTransaction.txId() + ':' + QString::number(fundsTransaction.outputs());
 }
 
-int WalletModel::rowCount(const QModelIndex &parent) const
+qint64 WalletModel::totalAvailableFunds() const
 {
-    Q_UNUSED(parent);
-    return m_funds.count();
+    return m_confirmedSatoshi + m_unconfirmedSatoshi;
 }
 
-QVariant WalletModel::data(const QModelIndex &index, int role) const
+qint64 WalletModel::confirmedSatoshi() const
 {
-    if (index.row() < 0 || index.row() >= m_funds.count())
-        return QVariant();
-
-    const FundsTransaction &fundsTransaction = m_funds[index.row()];
-    if (role == TxidRole)
-        return fundsTransaction.txId();
-    else if (role == OutputRole)
-        return fundsTransaction.outputs();
-    else if (role == SatoshiRole)
-        return fundsTransaction.amountSatoshi();
-    return QVariant();
+    return m_confirmedSatoshi;
 }
 
-int WalletModel::totalAvailableFunds()
+qint64 WalletModel::unconfirmedSatoshi() const
 {
-    int sumOfAvailableFunds = 0;
-    foreach (FundsTransaction transaction, m_funds) {
-        sumOfAvailableFunds += transaction.amountSatoshi();
-    }
-    return sumOfAvailableFunds;
+    return m_unconfirmedSatoshi;
 }
 
 void WalletModel::requestNewAddress()
@@ -118,6 +111,7 @@ void WalletModel::updateFunds()
 void WalletModel::listFundsRequestFinished()
 {
     GET_MESSAGE_DISCONNECT_SLOT(message, &WalletModel::listFundsRequestFinished)
+    RpcApplyTimer applyTimer("listfunds");
     if (message.type() == QJsonRpcMessage::Response)
     {
         QJsonObject jsonObject = message.toObject();
@@ -133,26 +127,60 @@ void WalletModel::listFundsRequestFinished()
 
 void WalletModel::populateFundsFromJson(QJsonArray jsonArray)
 {
-    m_funds.clear();
-    endResetModel();
+    TRACE_SCOPE("model", "populateFundsFromJson");
 
+    qint64 previousConfirmed = m_confirmedSatoshi;
+    qint64 previousUnconfirmed = m_unconfirmedSatoshi;
+
+    QVector<FundsTransaction> funds;
+    funds.reserve(jsonArray.size());
     foreach (const QJsonValue &v, jsonArray)
     {
-        beginInsertRows(QModelIndex(), rowCount(), rowCount());
-
         QJsonObject OutputsJsonObject = v.toObject();
 
         FundsTransaction fundsTransaction;
-        fundsTransaction.setTxId(OutputsJsonObject.value("output").toString());
-        fundsTransaction.setOutputs(OutputsJsonObject.value("txid").toBool());
-        fundsTransaction.setAmountSatoshi(OutputsJsonObject.value("value").toInt());
+        fundsTransaction.setTxId(OutputsJsonObject.value("txid").toString());
+        fundsTransaction.setOutputs(OutputsJsonObject.value("output").toInt());
+        fundsTransaction.setAmountSatoshi((qint64)OutputsJsonObject.value("value").toDouble());
+        // Older daemons don't say, their outputs are all confirmed
+        fundsTransaction.setConfirmed(OutputsJsonObject.value("status").toString("confirmed") == "confirmed");
+        funds.append(fundsTransaction);
+    }
 
-        m_funds.append(fundsTransaction);
+    // The totals follow through recordAdded() and recordRemoved()
+    setRecords(funds);
 
-        endInsertRows();
+    bool confirmedChanged = m_confirmedSatoshi != previousConfirmed;
+    bool unconfirmedChanged = m_unconfirmedSatoshi != previousUnconfirmed;
+    if (confirmedChanged) {
+        emit confirmedSatoshiChanged();
     }
+    if (unconfirmedChanged) {
+        emit unconfirmedSatoshiChanged();
+    }
+    if (confirmedChanged || unconfirmedChanged) {
+        emit totalAvailableFundsChanged();
+    }
+}
 
-    emit totalAvailableFundsChanged();
+void WalletModel::recordAdded(const FundsTransaction &fundsTransaction)
+{
+    addToTotals(fundsTransaction, 1);
+}
+
+void WalletModel::recordRemoved(const FundsTransaction &fundsTransaction)
+{
+    addToTotals(fundsTransaction, -1);
+}
+
+void WalletModel::addToTotals(const FundsTransaction &fundsTransaction, int sign)
+{
+    if (fundsTransaction.confirmed()) {
+        m_confirmedSatoshi += sign * fundsTransaction.amountSatoshi();
+    }
+    else {
+        m_unconfirmedSatoshi += sign * fundsTransaction.amountSatoshi();
+    }
 }
 
 QString FundsTransaction::txId() const
@@ -175,12 +203,22 @@ void FundsTransaction::setOutputs(int outputs)
     m_outputs = outputs;
 }
 
-int FundsTransaction::amountSatoshi() const
+qint64 FundsTransaction::amountSatoshi() const
 {
     return m_amountSatoshi;
 }
 
-void FundsTransaction::setAmountSatoshi(int amountSatoshi)
+void FundsTransaction::setAmountSatoshi(qint64 amountSatoshi)
 {
     m_amountSatoshi = amountSatoshi;
 }
+
+bool FundsTransaction::confirmed() const
+{
+    return m_confirmed;
+}
+
+void FundsTransaction::setConfirmed(bool confirmed)
+{
+    m_confirmed = confirmed;
+}
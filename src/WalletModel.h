@@ -4,14 +4,19 @@
 #include <QObject>
 #include <QAbstractItemModel>
 
-#include "./3rdparty/qjsonrpc/src/qjsonrpcsocket.h"
+#include "KeyedListModel.h"
+#include "RpcConnectionPool.h"
 #include "./3rdparty/qjsonrpc/src/qjsonrpcmessage.h"
 
 class FundsTransaction
 {
 public:
     FundsTransaction()
-    {}
+    {
+        m_outputs = 0;
+        m_amountSatoshi = 0;
+        m_confirmed = false;
+    }
 
     QString txId() const;
     void setTxId(const QString &txId);
@@ -19,41 +24,48 @@ public:
     int outputs() const;
     void setOutputs(int outputs);
 
-    int amountSatoshi() const;
-    void setAmountSatoshi(int amountSatoshi);
+    qint64 amountSatoshi() const;
+    void setAmountSatoshi(qint64 amountSatoshi);
+
+    bool confirmed() const;
+    void setConfirmed(bool confirmed);
 
 private:
     QString m_txId;
     int m_outputs;
-    int m_amountSatoshi;
+    qint64 m_amountSatoshi;
+    bool m_confirmed;
 
 };
 
-class WalletModel : public QAbstractListModel
+class WalletModel : public KeyedListModel<FundsTransaction, QString>
 {
     Q_OBJECT
-    Q_PROPERTY(int totalAvailableFunds READ totalAvailableFunds NOTIFY totalAvailableFundsChanged)
+    Q_PROPERTY(qint64 totalAvailableFunds READ totalAvailableFunds NOTIFY totalAvailableFundsChanged)
+    Q_PROPERTY(qint64 confirmedSatoshi READ confirmedSatoshi NOTIFY confirmedSatoshiChanged)
+    Q_PROPERTY(qint64 unconfirmedSatoshi READ unconfirmedSatoshi NOTIFY unconfirmedSatoshiChanged)
 public:
 
     enum FundingRoles {
         TxidRole = Qt::UserRole + 1,
         OutputRole,
-        SatoshiRole
+        SatoshiRole,
+        ConfirmedRole
     };
 
-    WalletModel(QJsonRpcSocket* rpcSocket = 0);
-
-    QHash<int, QByteArray> roleNames() const;
+    WalletModel(RpcConnectionPool* rpcSocket = 0);
 
-    int rowCount(const QModelIndex & parent = QModelIndex()) const;
-    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
-
-    /*Q_INVOKABLE*/ int totalAvailableFunds();
+    // Kept up to date as outputs come and go, not summed per read
+    qint64 totalAvailableFunds() const;
+    qint64 confirmedSatoshi() const;
+    qint64 unconfirmedSatoshi() const;
 
     void updateFunds();
 
 signals:
     void totalAvailableFundsChanged();
+    void confirmedSatoshiChanged();
+    void unconfirmedSatoshiChanged();
     void newAddress(QString newAddress);
     void errorString(QString error);
 
@@ -67,10 +79,18 @@ private slots:
     void withdrawFundsRequestFinished();
 
 private:
-    QList<FundsTransaction> m_funds;
-    QJsonRpcSocket* m_rpcSocket;
+    static QString outputKey(const FundsTransaction &fundsTransaction);
 
-private:
+    void recordAdded(const FundsTransaction &fundsTransaction);
+    void recordRemoved(const FundsTransaction &fundsTransaction);
+    void addToTotals(const FundsTransaction &fundsTransaction, int sign);
+
+    RpcConnectionPool* m_rpcSocket;
+
+    qint64 m_confirmedSatoshi;
+    qint64 m_unconfirmedSatoshi;
+
+public:
     void populateFundsFromJson(QJsonArray jsonArray);
 };
 
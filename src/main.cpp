@@ -1,4 +1,8 @@
 #include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QLocalServer>
+#include <QScopedPointer>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QFont>
@@ -7,33 +11,92 @@
 #include "LightningModel.h"
 #include "QClipboardProxy.h"
 #include "AutoPilot.h"
+#include "QRCodeImageProvider.h"
+#include "QRScannerFilter.h"
+#include "RpcDiagnostics.h"
+#include "Tracer.h"
+#include "MockLightningDaemon.h"
+#include "RpcRecorder.h"
+#include "RpcReplayDaemon.h"
+#include "SnapshotCache.h"
+#include "HeadlessService.h"
+#include "PosGateway.h"
+#include "PointOfSaleSession.h"
+#include "RevenueBucketModel.h"
+#include "TimeSeriesModel.h"
+#include "InvoiceSearchModel.h"
 
 #ifdef Q_OS_ANDROID
 #include "AndroidNfcHelper.h"
 #else
 #include "NfcHelper.h"
+#include "NfcBenchmark.h"
+#include "LoopbackNfcTransceiver.h"
 #endif
 
 #include "./3rdparty/kirigami/src/kirigamiplugin.h"
 #include "./3rdparty/qzxing/src/QZXing.h"
+#include "./3rdparty/qjsonrpc/src/qjsonrpclocalserver.h"
 
-int main(int argc, char *argv[])
+// Has to be known before there is an application to parse arguments with
+static bool headlessRequested(int argc, char *argv[])
 {
-    QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
-    QGuiApplication app(argc, argv);
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    app.setOrganizationName("Codex Apertus");
-    app.setOrganizationDomain("codexapertus.com");
-    app.setApplicationName("Presto!");
+static int runHeadless(QCoreApplication *app, LightningModel *lightningModel, AutoPilot *autoPilot,
+                       const QString &apiServerName)
+{
+    QJsonRpcLocalServer apiServer;
+    apiServer.addService(new HeadlessService(lightningModel, autoPilot));
 
-    LightningModel* lightningModel = new LightningModel;
-    AutoPilot* autoPilot = new AutoPilot;
+    QLocalServer::removeServer(apiServerName);
+    if (!apiServer.listen(apiServerName)) {
+        qDebug() << "Couldn't listen for API requests on" << apiServerName << apiServer.errorString();
+        return 1;
+    }
+    qDebug() << "Running headless, API on" << apiServerName;
 
+    return app->exec();
+}
+
+static int runGui(QGuiApplication *app, LightningModel *lightningModel, AutoPilot *autoPilot,
+                  RpcDiagnostics *rpcDiagnostics, PosGateway *posGateway)
+{
 #ifdef Q_OS_ANDROID
     AndroidNfcHelper* nfcHelper = new AndroidNfcHelper;
 #else
-    NfcHelper* nfcHelper = new NfcHelper;
+    // No reader around? Emulate the phone side in-process, tapped every few
+    // seconds. PRESTO_NFC_TAG_CYCLE=present,away in ms changes how often.
+    NfcTransceiver* nfcTransceiver = nullptr;
+    bool loopback = qgetenv("PRESTO_NFC_BACKEND") == "loopback";
+#ifndef PRESTO_NXP_NFC
+    loopback = true;
 #endif
+    if (loopback) {
+        LoopbackNfcTransceiver* loopbackTransceiver = new LoopbackNfcTransceiver;
+        QList<QByteArray> tagCycle = qgetenv("PRESTO_NFC_TAG_CYCLE").split(',');
+        if (tagCycle.size() == 2) {
+            loopbackTransceiver->setTagCycle(tagCycle.at(0).toInt(), tagCycle.at(1).toInt());
+        }
+        else {
+            loopbackTransceiver->setTagCycle(3000, 5000);
+        }
+        nfcTransceiver = loopbackTransceiver;
+    }
+    NfcHelper* nfcHelper = new NfcHelper(nfcTransceiver);
+#endif
+
+    PointOfSaleSession pointOfSaleSession(lightningModel->invoicesModel());
+    RevenueBucketModel revenueModel(lightningModel->revenueAggregator());
+    TimeSeriesModel balanceSeries(lightningModel->revenueAggregator(), TimeSeriesModel::Balance);
+    TimeSeriesModel paymentsSeries(lightningModel->revenueAggregator(), TimeSeriesModel::Payments);
+    InvoiceSearchModel invoiceSearchModel(lightningModel->invoicesModel(), lightningModel->invoiceSearchIndex());
 
     QQmlApplicationEngine engine;
 
@@ -43,8 +106,24 @@ int main(int argc, char *argv[])
     engine.rootContext()->setContextProperty("paymentsModel", lightningModel->paymentsModel());
     engine.rootContext()->setContextProperty("walletModel", lightningModel->walletModel());
     engine.rootContext()->setContextProperty("invoicesModel", lightningModel->invoicesModel());
+    engine.rootContext()->setContextProperty("daemonSupervisor", lightningModel->daemonSupervisor());
+    engine.rootContext()->setContextProperty("invoiceDispatcher", lightningModel->invoiceDispatcher());
+    engine.rootContext()->setContextProperty("bulkInvoiceGenerator", lightningModel->bulkInvoiceGenerator());
+    engine.rootContext()->setContextProperty("invoiceHistory", lightningModel->invoiceHistoryStore());
+    engine.rootContext()->setContextProperty("invoiceSweeper", lightningModel->invoiceSweeper());
+    engine.rootContext()->setContextProperty("revenueAggregator", lightningModel->revenueAggregator());
+    engine.rootContext()->setContextProperty("revenueModel", &revenueModel);
+    engine.rootContext()->setContextProperty("balanceSeries", &balanceSeries);
+    engine.rootContext()->setContextProperty("paymentsSeries", &paymentsSeries);
+    engine.rootContext()->setContextProperty("invoiceSearchModel", &invoiceSearchModel);
+    engine.rootContext()->setContextProperty("rpcConnectionPool", lightningModel->rpcConnectionPool());
+    engine.rootContext()->setContextProperty("rpcDiagnostics", rpcDiagnostics);
+    engine.rootContext()->setContextProperty("daemonLogModel",
+                                             new DaemonLogFilterModel(lightningModel->daemonLogModel()));
     engine.rootContext()->setContextProperty("nfcHelper", nfcHelper);
     engine.rootContext()->setContextProperty("autoPilot", autoPilot);
+    engine.rootContext()->setContextProperty("posGateway", posGateway);
+    engine.rootContext()->setContextProperty("pointOfSaleSession", &pointOfSaleSession);
     qmlRegisterUncreatableMetaObject(
       InvoiceTypes::staticMetaObject,
       "Lightning.Invoice",
@@ -54,9 +133,18 @@ int main(int argc, char *argv[])
     );
 
 
+    qmlRegisterType<QRScannerFilter>("Presto", 1, 0, "QRScannerFilter");
+    qmlRegisterUncreatableType<PointOfSaleSession>("Presto", 1, 0, "PointOfSaleSession",
+                                                   "Error: use the pointOfSaleSession context property");
+    qmlRegisterUncreatableType<RevenueAggregator>("Presto", 1, 0, "RevenueAggregator",
+                                                  "Error: use the revenueAggregator context property");
+    qmlRegisterUncreatableType<TimeSeriesModel>("Presto", 1, 0, "TimeSeriesModel",
+                                                "Error: use the balanceSeries or paymentsSeries context properties");
+
     KirigamiPlugin::getInstance().registerTypes();
     QZXing::registerQMLTypes();
     QZXing::registerQMLImageProvider(engine);
+    engine.addImageProvider(QLatin1String("qrcode"), new QRCodeImageProvider);
 
     engine.rootContext()->setContextProperty("clipboard",
                                              new QClipboardProxy(QGuiApplication::clipboard()));
@@ -69,5 +157,148 @@ int main(int argc, char *argv[])
     if (engine.rootObjects().isEmpty())
         return -1;
 
-    return app.exec();
+    return app->exec();
+}
+
+int main(int argc, char *argv[])
+{
+    // No QML, platform plugin or NFC, just the models and the API
+    bool headless = headlessRequested(argc, argv);
+
+    QScopedPointer<QCoreApplication> app;
+    if (headless) {
+        app.reset(new QCoreApplication(argc, argv));
+    }
+    else {
+        QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+        app.reset(new QGuiApplication(argc, argv));
+    }
+
+    app->setOrganizationName("Codex Apertus");
+    app->setOrganizationDomain("codexapertus.com");
+    app->setApplicationName("Presto!");
+
+    // Load the result in https://ui.perfetto.dev
+    if (qEnvironmentVariableIsSet("PRESTO_TRACE_FILE")) {
+        Tracer::start(QString::fromLocal8Bit(qgetenv("PRESTO_TRACE_FILE")));
+    }
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption mockDaemonOption("mock-daemon", "Talk to an in-process mock daemon with synthetic data.");
+    QCommandLineOption mockScaleOption("mock-scale", "Mock daemon dataset and latency, e.g. invoices=100000,nodes=50000,latency=20.", "scale");
+    QCommandLineOption nfcBenchmarkOption("nfc-benchmark", "Benchmark bolt11 delivery and the socket tunnel over the "
+                                          "loopback NFC transceiver, write the results to file and exit.", "file");
+    QCommandLineOption recordRpcOption("record-rpc", "Record RPC traffic, secrets scrubbed, to file.", "file");
+    QCommandLineOption replayRpcOption("replay-rpc", "Answer RPC calls from a recording instead of a daemon.", "file");
+    QCommandLineOption replaySpeedOption("replay-speed", "Replay speed factor, 0 answers immediately.", "factor", "1");
+    QCommandLineOption headlessOption("headless", "Run without a UI, serving the JSON-RPC API on a local socket.");
+    QCommandLineOption apiServerOption("api-server", "Local socket name of the headless API.", "name", "presto-api");
+    parser.addOption(headlessOption);
+    parser.addOption(apiServerOption);
+    QCommandLineOption posGatewayOption("pos-gateway", "Serve invoices to POS terminals on this local socket.", "name");
+    QCommandLineOption posGatewayPortOption("pos-gateway-port", "Serve invoices to POS terminals on this TCP port.", "port");
+    QCommandLineOption posGatewayAddressOption("pos-gateway-address", "Address the POS gateway listens on, 127.0.0.1 by default.",
+                                               "address", "127.0.0.1");
+    QCommandLineOption posGatewayTokenOption("pos-gateway-token", "Token POS terminals have to say hello with, "
+                                             "PRESTO_POS_TOKEN if not given. Required for TCP.", "token");
+    parser.addOption(posGatewayOption);
+    parser.addOption(posGatewayPortOption);
+    parser.addOption(posGatewayAddressOption);
+    parser.addOption(posGatewayTokenOption);
+    parser.addOption(mockDaemonOption);
+    parser.addOption(mockScaleOption);
+#ifndef Q_OS_ANDROID
+    parser.addOption(nfcBenchmarkOption);
+#endif
+    parser.addOption(recordRpcOption);
+    parser.addOption(replayRpcOption);
+    parser.addOption(replaySpeedOption);
+    parser.process(*app);
+
+#ifndef Q_OS_ANDROID
+    if (parser.isSet(nfcBenchmarkOption)) {
+        NfcBenchmark benchmark;
+        bool written = benchmark.writeResults(benchmark.run(), parser.value(nfcBenchmarkOption));
+        Tracer::stop();
+        return written ? 0 : 1;
+    }
+#endif
+
+    if (parser.isSet(recordRpcOption)) {
+        RpcRecorder::start(parser.value(recordRpcOption));
+    }
+
+    QString serverName;
+    if (parser.isSet(replayRpcOption)) {
+        RpcReplayDaemon* replayDaemon = new RpcReplayDaemon(app.data());
+        replayDaemon->setSpeed(parser.value(replaySpeedOption).toDouble());
+        if (!replayDaemon->load(parser.value(replayRpcOption))
+                || !replayDaemon->listen("presto-replay-" + QString::number(app->applicationPid()))) {
+            // Carrying on would talk to the real wallet instead
+            qDebug() << "Couldn't replay" << parser.value(replayRpcOption) << "exiting";
+            RpcRecorder::stop();
+            Tracer::stop();
+            return 1;
+        }
+        serverName = replayDaemon->serverName();
+    }
+    else if (parser.isSet(mockDaemonOption) || parser.isSet(mockScaleOption)) {
+        MockLightningDaemon* mockDaemon = new MockLightningDaemon(app.data());
+        mockDaemon->setScale(parser.value(mockScaleOption));
+        if (!mockDaemon->listen("presto-mock-" + QString::number(app->applicationPid()))) {
+            qDebug() << "Couldn't start the mock daemon, exiting";
+            RpcRecorder::stop();
+            Tracer::stop();
+            return 1;
+        }
+        serverName = mockDaemon->serverName();
+    }
+
+    // Before the models so it sees their very first requests
+    RpcDiagnostics* rpcDiagnostics = new RpcDiagnostics;
+    // Synthetic or replayed data has no business in the real wallet's snapshot
+    SnapshotCache* snapshotCache = serverName.isEmpty() ? new SnapshotCache : nullptr;
+    LightningModel* lightningModel = new LightningModel(serverName);
+    AutoPilot* autoPilot = new AutoPilot;
+
+    PosGateway* posGateway = nullptr;
+    if (parser.isSet(posGatewayOption) || parser.isSet(posGatewayPortOption)) {
+        posGateway = new PosGateway(lightningModel->invoicesModel());
+        QObject::connect(lightningModel->rpcConnectionPool()->primarySocket(), &QLocalSocket::disconnected,
+                         posGateway, &PosGateway::connectionLost);
+        posGateway->setToken(parser.isSet(posGatewayTokenOption) ? parser.value(posGatewayTokenOption)
+                                                                 : QString::fromUtf8(qgetenv("PRESTO_POS_TOKEN")));
+        bool listening = true;
+        if (parser.isSet(posGatewayOption)) {
+            listening = posGateway->listenLocal(parser.value(posGatewayOption));
+        }
+        if (listening && parser.isSet(posGatewayPortOption)) {
+            listening = posGateway->listenTcp(parser.value(posGatewayPortOption).toUShort(),
+                                              QHostAddress(parser.value(posGatewayAddressOption)));
+        }
+        if (!listening) {
+            // The terminals would be left waiting on a gateway that isn't there
+            qDebug() << "Couldn't start the POS gateway, exiting";
+            RpcRecorder::stop();
+            Tracer::stop();
+            return 1;
+        }
+    }
+
+    int result;
+    if (headless) {
+        result = runHeadless(app.data(), lightningModel, autoPilot, parser.value(apiServerOption));
+    }
+    else {
+        result = runGui(static_cast<QGuiApplication *>(app.data()), lightningModel, autoPilot,
+                        rpcDiagnostics, posGateway);
+    }
+
+    if (snapshotCache) {
+        snapshotCache->save();
+    }
+    RpcRecorder::stop();
+    Tracer::stop();
+    return result;
 }
@@ -5,7 +5,7 @@ import org.kde.kirigami 2.1 as Kirigami
 import "." // QTBUG-34418
 
 ColumnLayout {
-    property int amount: peersModel.totalAvailableFunds / 1000 + walletModel.totalAvailableFunds
+    property real amount: peersModel.spendableMsatoshi / 1000 + walletModel.confirmedSatoshi + walletModel.unconfirmedSatoshi
     QQC2.Label {
         
         font.pixelSize: 26
@@ -14,7 +14,8 @@ ColumnLayout {
 
     QQC2.Label {
         
-        text: lightningModel.connectedToDaemon ? ExchangeRate.getAmountInCurrency(amount) : qsTr("Disconnected")
+        text: lightningModel.connectedToDaemon ? ExchangeRate.getAmountInCurrency(amount)
+                                               : daemonSupervisor.recovering ? qsTr("Reconnecting...") : qsTr("Disconnected")
 
     }
 }
@@ -32,7 +32,8 @@ Kirigami.OverlaySheet {
             width: parent.width * 0.9
             height: width
             Layout.alignment: Qt.AlignCenter
-            zxingFilter.decoder.onTagFound: {
+            scannerFilter.acceptPattern: "^(lightning:)?ln[a-z]+1[0-9a-z]+$"
+            scannerFilter.onTagFound: {
                 checkIfValidBolt11(tag)
             }
         }
@@ -53,6 +54,8 @@ Kirigami.OverlaySheet {
     }
 
     function checkIfValidBolt11(text) {
+        // QR codes in alphanumeric mode are all upper case, bech32 doesn't mind
+        text = text.trim().toLowerCase()
         if (text.startsWith("lightning:")) {
             text = text.slice(10)
         }
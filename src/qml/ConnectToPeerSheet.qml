@@ -28,7 +28,8 @@ Kirigami.OverlaySheet {
             width: parent.width * 0.9
             height: width
             Layout.alignment: Qt.AlignCenter
-            zxingFilter.decoder.onTagFound: {
+            scannerFilter.acceptPattern: "^[0-9a-f]{66}(@.+)?$"
+            scannerFilter.onTagFound: {
                 checkIfValidPeerUri(tag)
             }
         }
@@ -97,13 +98,19 @@ Kirigami.OverlaySheet {
                 connectButton.enabled = true
                 text = qsTr("Connect")
             }
+        }
+    }
 
-            function checkIfValidPeerUri(text) {
-                if (text.includes("@")) {
-                    idTextField.text = text
-                }
-            }
+    // Same set as the scanner's acceptPattern, which ignores case: a node
+    // id, with or without @host. Without one the address is left for the
+    // user to type.
+    function checkIfValidPeerUri(text) {
+        var uriParts = text.trim().split("@")
+        if (!/^[0-9a-f]{66}$/i.test(uriParts[0])) {
+            return
         }
+        idTextField.text = uriParts[0].toLowerCase()
+        addressTextField.text = uriParts.length > 1 ? uriParts.slice(1).join("@") : ""
     }
 
     function resetSheet () {
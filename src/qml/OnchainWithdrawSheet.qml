@@ -29,9 +29,16 @@ Kirigami.OverlaySheet {
             Layout.alignment: Qt.AlignCenter
             width: parent.width
             height: width
-            zxingFilter.decoder.onTagFound: {
-                if (tag.startsWith("bitcoin:")) {
-                    pasteTextArea.text = tag.substring(8);
+            scannerFilter.acceptPattern: "^bitcoin:"
+            scannerFilter.onTagFound: {
+                // The scanner matches BITCOIN: too. Only bech32 addresses
+                // may be lower cased, base58 ones are case sensitive.
+                if (tag.toLowerCase().startsWith("bitcoin:")) {
+                    var address = tag.substring(8).trim();
+                    if (/^(bc|tb|bcrt)1/i.test(address)) {
+                        address = address.toLowerCase();
+                    }
+                    pasteTextArea.text = address;
                 }
             }
         }
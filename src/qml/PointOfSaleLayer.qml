@@ -2,13 +2,13 @@ import QtQuick 2.7
 import QtQuick.Controls 2.0 as QQC2
 import QtQuick.Layouts 1.3
 import org.kde.kirigami 2.1 as Kirigami
+import Presto 1.0
 
 Kirigami.ScrollablePage {
     id: page
     Layout.fillWidth: true
     Layout.fillHeight: true
 
-    property string invoiceWeAreWaitingFor
     property string demoInvoiceDescription: "<img src=https://sites.google.com/a/codexapertus.com/www/home/LogoMakr_6tvqhe.png>" +
                                             "<table><tr><th>Item</th><th>Qty</th></tr>" +
                                             "<tr><td>Bananas</td><td>6</td><td>$2.49</td></tr>" +
@@ -21,9 +21,20 @@ Kirigami.ScrollablePage {
         MouseArea {
             anchors.fill: parent
             onClicked: {
-                demoReceipt.visible = true
-                demoReceiptPaidText.visible = false
-                getRandomInvoice()
+                if (pointOfSaleSession.state === PointOfSaleSession.Paid) {
+                    // Next customer, their cart is already being prepared
+                    pointOfSaleSession.reset()
+                    demoReceipt.visible = true
+                    demoReceiptPaidText.visible = false
+                } else if (pointOfSaleSession.state === PointOfSaleSession.Preparing
+                           || pointOfSaleSession.state === PointOfSaleSession.Failed
+                           || pointOfSaleSession.state === PointOfSaleSession.Expired) {
+                    // The daemon never answered or the invoice is gone, start over
+                    pointOfSaleSession.reset()
+                    pointOfSaleSession.checkout()
+                } else {
+                    pointOfSaleSession.checkout()
+                }
             }
         }
     }
@@ -48,6 +59,14 @@ Kirigami.ScrollablePage {
         text: demoInvoiceDescription
     }
 
+    QQC2.Label {
+        Layout.alignment: Qt.AlignHCenter
+        font.pixelSize: Kirigami.Units.gridUnit * 2
+        visible: pointOfSaleSession.state === PointOfSaleSession.Failed
+                 || pointOfSaleSession.state === PointOfSaleSession.Expired
+        text: "Couldn't get the invoice ready, tap to try again"
+    }
+
     QQC2.Label {
         id: demoReceiptPaidText
         Layout.alignment: Qt.AlignHCenter
@@ -58,32 +77,29 @@ Kirigami.ScrollablePage {
     YOU!"
     }
 
-    function getRandomInvoice() {
+    // The session starts on the invoice as soon as the cart is known
+    function setRandomCart() {
         var amount = Math.floor(((Math.random()) * 9000 + 1000) * 1000)
         grandTotal.amount = amount
-        invoiceWeAreWaitingFor = "INVOICE #" + Math.floor(Math.random()*10000)
-        invoicesModel.addInvoice(invoiceWeAreWaitingFor,
-                                 invoiceWeAreWaitingFor +
-                                 demoInvoiceDescription,
-                                 amount,
-                                 86400)
+        pointOfSaleSession.setCart(amount,
+                                   "INVOICE #" + Math.floor(Math.random()*10000) +
+                                   demoInvoiceDescription)
     }
 
     Connections {
-        target: invoicesModel
-        onInvoiceAdded: {
+        target: pointOfSaleSession
+        onPayable: {
             nfcHelper.setBolt11(bolt11)
-            invoicesModel.waitInvoice(invoiceWeAreWaitingFor)
         }
 
-        onInvoiceStatusChanged: {
+        onPaid: {
             demoReceipt.visible = false
             demoReceiptPaidText.visible = true
+            setRandomCart()
         }
-
     }
 
     Component.onCompleted: {
-        getRandomInvoice()
+        setRandomCart()
     }
 }
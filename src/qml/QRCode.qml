@@ -1,8 +1,7 @@
 import QtQuick 2.0
-import "qqr.js" as QRCodeBackend
 
-Canvas {
-    id: canvas
+Image {
+    id: qrCode
     // background colour to be used
     property color background : "white"
     // foreground colour to be used
@@ -15,39 +14,17 @@ Canvas {
     //width: 350
     height: width
 
-    onPaint : {
-        var qr = QRCodeBackend.get_qr()
-        qr.canvas({
-            background : canvas.background,
-            canvas : canvas,
-            value: canvas.value,
-            foreground : canvas.foreground,
-            level : canvas.level,
-            side : Math.min(canvas.width, canvas.height),
-            value : canvas.value
-        })
-    }
-    onHeightChanged : {
-        requestPaint()
-    }
+    // Encoded and cached natively, one pixel per module
+    source: value.length > 0 ? "image://qrcode/" + level + "/" +
+                               colorName(foreground) + "/" +
+                               colorName(background) + "/" +
+                               encodeURIComponent(value) : ""
 
-    onWidthChanged : {
-        requestPaint()
-    }
-
-    onBackgroundChanged : {
-        requestPaint()
-    }
-
-    onForegroundChanged : {
-        requestPaint()
-    }
-
-    onLevelChanged : {
-        requestPaint()
-    }
+    fillMode: Image.PreserveAspectFit
+    // Keep the modules sharp when scaling up
+    smooth: false
 
-    onValueChanged : {
-        requestPaint()
+    function colorName(color) {
+        return color.toString().substring(1)
     }
 }
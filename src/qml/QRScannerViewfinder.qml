@@ -5,7 +5,7 @@ import org.kde.kirigami 2.1 as Kirigami
 import QtGraphicalEffects 1.0
 
 import QtMultimedia 5.8
-import QZXing 2.3
+import Presto 1.0
 
 Rectangle {
     id: viewfinderRectangle
@@ -15,13 +15,13 @@ Rectangle {
     clip: true
 
     property alias camera: camera
-    property alias zxingFilter: zxingFilter
+    property alias scannerFilter: scannerFilter
     
     VideoOutput {
         id: viewfinderOutput
         source: camera
         autoOrientation: true
-        filters: [ zxingFilter ]
+        filters: [ scannerFilter ]
         anchors.fill: parent
         fillMode: VideoOutput.PreserveAspectCrop
         layer.enabled: true
@@ -46,6 +46,11 @@ Rectangle {
         Camera {
             id: camera
             cameraState: Camera.UnloadedState
+            onCameraStateChanged: {
+                if (cameraState === Camera.ActiveState) {
+                    scannerFilter.reset()
+                }
+            }
             imageCapture {
                 id: qrCapture
                 onImageCaptured: {
@@ -55,8 +60,8 @@ Rectangle {
             }
         }
         
-        QZXingFilter {
-            id: zxingFilter
+        QRScannerFilter {
+            id: scannerFilter
             captureRect: {
                 // setup bindings
                 viewfinderOutput.contentRect;
@@ -65,10 +70,6 @@ Rectangle {
                             viewfinderOutput.mapNormalizedRectToItem(
                                 Qt.rect(0.25, 0.25, 0.5, 0.5)));
             }
-            
-            decoder {
-                enabledDecoders: QZXing.DecoderFormat_QR_CODE
-            }
         }
     }
 }
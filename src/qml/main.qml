@@ -38,7 +38,7 @@ Kirigami.ApplicationWindow {
             Kirigami.Action {
                 enabled: lightningModel.connectedToDaemon
                 text: "Lightning Network (" +
-                      (peersModel.totalAvailableFunds / 1000).toLocaleString(locale, 'f', 0) +
+                      (peersModel.spendableMsatoshi / 1000).toLocaleString(locale, 'f', 0) +
                       " SAT)"
                 iconName: Kirigami.Settings.isMobile ? "wallet" : "view-list-icons"
                 Kirigami.Action {
@@ -187,8 +187,15 @@ Kirigami.ApplicationWindow {
 
             ListView {
                 id: invoicesListView
-                model: invoicesModel
+                model: invoiceSearchModel
                 anchors.fill: parent
+                headerPositioning: ListView.PullBackHeader
+                header: QQC2.TextField {
+                    width: invoicesListView.width
+                    placeholderText: qsTr("Search label, description, amount or hash")
+                    text: invoiceSearchModel.query
+                    onTextChanged: invoiceSearchModel.query = text
+                }
                 delegate: Kirigami.SwipeListItem {
                     supportsMouseEvents: true
                     GenericListDelegate {
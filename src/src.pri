@@ -0,0 +1,121 @@
+# Everything but main.cpp, shared by the app and tests/benchmarks
+
+INCLUDEPATH += \
+    $$PWD \
+    $$PWD/..
+
+include($$PWD/../3rdparty/qzxing/src/QZXing.pri)
+
+INCLUDEPATH += \
+    $$PWD/../3rdparty/QtCryptoHash/lib/include
+
+QCRYPTOHASH_SOURCES += \
+    $$PWD/../3rdparty/QtCryptoHash/lib/src/qcryptohash.cpp \
+    $$PWD/../3rdparty/QtCryptoHash/lib/src/rmd160.cpp \
+    $$PWD/../3rdparty/QtCryptoHash/lib/src/tiger.cpp \
+    $$PWD/../3rdparty/QtCryptoHash/lib/src/whirlpool.cpp \
+    $$PWD/../3rdparty/QtCryptoHash/lib/src/hashalgorithm.cpp
+
+QJSONRPC_HEADERS += \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcabstractserver.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcabstractserver_p.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcglobal.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpclocalserver.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcmessage.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcmetatype.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcservice.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcservice_p.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcserviceprovider.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcservicereply.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcservicereply_p.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcsocket.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcsocket_p.h \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpctcpserver.h
+
+QJSONRPC_SOURCES += \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcabstractserver.cpp \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpclocalserver.cpp \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcmessage.cpp \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcservice.cpp \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcserviceprovider.cpp \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcservicereply.cpp \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpcsocket.cpp \
+    $$PWD/../3rdparty/qjsonrpc/src/qjsonrpctcpserver.cpp \
+
+HEADERS += \
+    $${QJSONRPC_HEADERS} \
+    $$PWD/LightningModel.h \
+    $$PWD/PaymentsModel.h \
+    $$PWD/PeersModel.h \
+    $$PWD/WalletModel.h \
+    $$PWD/InvoicesModel.h \
+    $$PWD/QClipboardProxy.h \
+    $$PWD/NodesModel.h \
+    $$PWD/macros.h \
+    $$PWD/AutoPilot.h \
+    $$PWD/QRCodeEncoder.h \
+    $$PWD/QRCodeImageProvider.h \
+    $$PWD/QRScannerFilter.h \
+    $$PWD/DaemonInstaller.h \
+    $$PWD/DaemonLogModel.h \
+    $$PWD/DaemonSupervisor.h \
+    $$PWD/RpcConnectionPool.h \
+    $$PWD/RpcLaneDevice.h \
+    $$PWD/RpcDiagnostics.h \
+    $$PWD/Tracer.h \
+    $$PWD/MockLightningDaemon.h \
+    $$PWD/RpcRecorder.h \
+    $$PWD/RpcReplayDaemon.h \
+    $$PWD/SnapshotCache.h \
+    $$PWD/HeadlessService.h \
+    $$PWD/PosGateway.h \
+    $$PWD/InvoiceDispatcher.h \
+    $$PWD/PointOfSaleSession.h \
+    $$PWD/BulkInvoiceGenerator.h \
+    $$PWD/InvoiceHistoryStore.h \
+    $$PWD/InvoiceSweeper.h \
+    $$PWD/RevenueAggregator.h \
+    $$PWD/RevenueBucketModel.h \
+    $$PWD/TimeSeriesModel.h \
+    $$PWD/InvoiceSearchIndex.h \
+    $$PWD/InvoiceSearchModel.h \
+    $$PWD/KeyedListModel.h
+
+SOURCES += \
+    $${QJSONRPC_SOURCES} \
+    $${QCRYPTOHASH_SOURCES} \
+    $$PWD/LightningModel.cpp \
+    $$PWD/PaymentsModel.cpp \
+    $$PWD/PeersModel.cpp \
+    $$PWD/WalletModel.cpp \
+    $$PWD/InvoicesModel.cpp \
+    $$PWD/QClipboardProxy.cpp \
+    $$PWD/NodesModel.cpp \
+    $$PWD/AutoPilot.cpp \
+    $$PWD/QRCodeEncoder.cpp \
+    $$PWD/QRCodeImageProvider.cpp \
+    $$PWD/QRScannerFilter.cpp \
+    $$PWD/DaemonInstaller.cpp \
+    $$PWD/DaemonLogModel.cpp \
+    $$PWD/DaemonSupervisor.cpp \
+    $$PWD/RpcConnectionPool.cpp \
+    $$PWD/RpcLaneDevice.cpp \
+    $$PWD/RpcDiagnostics.cpp \
+    $$PWD/Tracer.cpp \
+    $$PWD/MockLightningDaemon.cpp \
+    $$PWD/RpcRecorder.cpp \
+    $$PWD/RpcReplayDaemon.cpp \
+    $$PWD/SnapshotCache.cpp \
+    $$PWD/HeadlessService.cpp \
+    $$PWD/PosGateway.cpp \
+    $$PWD/InvoiceDispatcher.cpp \
+    $$PWD/PointOfSaleSession.cpp \
+    $$PWD/BulkInvoiceGenerator.cpp \
+    $$PWD/InvoiceHistoryStore.cpp \
+    $$PWD/InvoiceSweeper.cpp \
+    $$PWD/RevenueAggregator.cpp \
+    $$PWD/RevenueBucketModel.cpp \
+    $$PWD/TimeSeriesModel.cpp \
+    $$PWD/InvoiceSearchIndex.cpp \
+    $$PWD/InvoiceSearchModel.cpp \
+    $$PWD/KeyedListModel.cpp
@@ -0,0 +1,320 @@
+#include <algorithm>
+
+#include <QAbstractItemModel>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSysInfo>
+
+#include "ModelBenchmark.h"
+#include "AutoPilot.h"
+#include "InvoicesModel.h"
+#include "MockLightningDaemon.h"
+#include "NodesModel.h"
+#include "PaymentsModel.h"
+#include "PeersModel.h"
+#include "WalletModel.h"
+
+// Not one of the generated nodes, so the candidate search has to hash it
+static const char benchmarkOurId[] = "02aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+static const int autoPilotIterations = 8;
+
+static QJsonObject caseResult(const QString &name, int rows)
+{
+    QJsonObject result;
+    result.insert("case", name);
+    result.insert("rows", rows);
+    return result;
+}
+
+ModelBenchmark::ModelBenchmark(QObject *parent) : QObject(parent)
+{
+    m_sizes << 1000 << 10000 << 100000 << 1000000;
+    m_iterations = 5;
+    m_timeBudget = 10000;
+}
+
+QList<int> ModelBenchmark::sizes() const
+{
+    return m_sizes;
+}
+
+void ModelBenchmark::setSizes(const QList<int> &sizes)
+{
+    m_sizes = sizes;
+}
+
+int ModelBenchmark::iterations() const
+{
+    return m_iterations;
+}
+
+void ModelBenchmark::setIterations(int iterations)
+{
+    m_iterations = qMax(1, iterations);
+}
+
+int ModelBenchmark::timeBudget() const
+{
+    return m_timeBudget;
+}
+
+void ModelBenchmark::setTimeBudget(int timeBudget)
+{
+    m_timeBudget = timeBudget;
+}
+
+QJsonObject ModelBenchmark::run()
+{
+    m_results = QJsonArray();
+    m_nsPerRow.clear();
+
+    QList<int> sizes = m_sizes;
+    std::sort(sizes.begin(), sizes.end());
+
+    foreach (int rows, sizes) {
+        qDebug() << "Benchmarking models at" << rows << "rows";
+
+        MockLightningDaemon dataset;
+        dataset.setInvoiceCount(rows);
+        dataset.setPaymentCount(rows);
+        dataset.setPeerCount(rows);
+        dataset.setOutputCount(rows);
+        dataset.setNodeCount(rows);
+
+        benchmarkListModel<InvoicesModel>("invoices", rows, dataset.listInvoicesJson(),
+                                          "invoices", &InvoicesModel::populateInvoicesFromJson);
+        benchmarkListModel<PaymentsModel>("payments", rows, dataset.listPaymentsJson(),
+                                          "payments", &PaymentsModel::populatePaymentsFromJson);
+        benchmarkListModel<PeersModel>("peers", rows, dataset.listPeersJson(),
+                                       "peers", &PeersModel::populatePeersFromJson);
+        benchmarkListModel<WalletModel>("funds", rows, dataset.listFundsJson(),
+                                        "outputs", &WalletModel::populateFundsFromJson);
+        benchmarkNodes(rows, dataset.listNodesJson());
+    }
+
+    QJsonObject resultsObject;
+    resultsObject.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    resultsObject.insert("qtVersion", QString(qVersion()));
+    resultsObject.insert("cpuArchitecture", QSysInfo::currentCpuArchitecture());
+    resultsObject.insert("productType", QSysInfo::prettyProductName());
+    resultsObject.insert("results", m_results);
+    return resultsObject;
+}
+
+bool ModelBenchmark::writeResults(const QJsonObject &results, const QString &filePath) const
+{
+    QSaveFile resultsFile(filePath);
+    if (!resultsFile.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write benchmark results to" << filePath;
+        return false;
+    }
+
+    resultsFile.write(QJsonDocument(results).toJson());
+    return resultsFile.commit();
+}
+
+template <class Model>
+void ModelBenchmark::benchmarkListModel(const QString &name, int rows, const QByteArray &json,
+                                        const QString &key, void (Model::*populate)(QJsonArray))
+{
+    QElapsedTimer timer;
+
+    QString parseCase = name + ".parse";
+    if (shouldRun(parseCase, rows)) {
+        QList<qint64> samples;
+        for (int i = 0; i < m_iterations; i++) {
+            timer.start();
+            QJsonArray jsonArray = parseArray(json, key);
+            samples << timer.nsecsElapsed();
+            if (jsonArray.size() != rows) {
+                qDebug() << "Benchmark dataset for" << name << "has" << jsonArray.size() << "rows, expected" << rows;
+            }
+        }
+        addResult(parseCase, rows, samples);
+    }
+
+    QString populateCase = name + ".populate";
+    QString refreshCase = name + ".refresh";
+    QString dataCase = name + ".data";
+    bool runPopulate = shouldRun(populateCase, rows);
+    bool runRefresh = shouldRun(refreshCase, rows);
+    bool runData = shouldRun(dataCase, rows);
+    if (!runPopulate && !runRefresh && !runData) {
+        return;
+    }
+
+    QJsonArray jsonArray = parseArray(json, key);
+
+    // Fresh model every time, populating an already filled one measures
+    // the reset rather than the parsing
+    Model *model = nullptr;
+    QList<qint64> populateSamples;
+    int populateIterations = runPopulate ? m_iterations : 1;
+    for (int i = 0; i < populateIterations; i++) {
+        delete model;
+        model = new Model;
+        timer.start();
+        (model->*populate)(jsonArray);
+        populateSamples << timer.nsecsElapsed();
+    }
+    if (runPopulate) {
+        addResult(populateCase, rows, populateSamples);
+    }
+
+    // The same list again, every row is matched by key and nothing changes
+    if (runRefresh) {
+        QList<qint64> samples;
+        for (int i = 0; i < m_iterations; i++) {
+            timer.start();
+            (model->*populate)(jsonArray);
+            samples << timer.nsecsElapsed();
+        }
+        addResult(refreshCase, rows, samples);
+    }
+
+    if (runData) {
+        QAbstractItemModel *itemModel = model;
+        QList<int> roles = itemModel->roleNames().keys();
+        int rowCount = itemModel->rowCount();
+        // Keeps the compiler from dropping the reads
+        int validCount = 0;
+
+        QList<qint64> samples;
+        for (int i = 0; i < m_iterations; i++) {
+            timer.start();
+            for (int row = 0; row < rowCount; row++) {
+                QModelIndex index = itemModel->index(row, 0);
+                foreach (int role, roles) {
+                    if (itemModel->data(index, role).isValid()) {
+                        validCount++;
+                    }
+                }
+            }
+            samples << timer.nsecsElapsed();
+        }
+        addResult(dataCase, rowCount, samples);
+
+        if (validCount == 0 && rowCount > 0) {
+            qDebug() << "No valid data in" << name << "model";
+        }
+    }
+
+    delete model;
+}
+
+void ModelBenchmark::benchmarkNodes(int rows, const QByteArray &json)
+{
+    QElapsedTimer timer;
+
+    if (shouldRun("nodes.parse", rows)) {
+        QList<qint64> samples;
+        for (int i = 0; i < m_iterations; i++) {
+            timer.start();
+            parseArray(json, "nodes");
+            samples << timer.nsecsElapsed();
+        }
+        addResult("nodes.parse", rows, samples);
+    }
+
+    bool runPopulate = shouldRun("nodes.populate", rows);
+    bool runAutoPilot = shouldRun("autopilot.candidate", rows);
+    if (!runPopulate && !runAutoPilot) {
+        return;
+    }
+
+    QJsonArray jsonArray = parseArray(json, "nodes");
+
+    NodesModel *nodesModel = nullptr;
+    QList<qint64> populateSamples;
+    int populateIterations = runPopulate ? m_iterations : 1;
+    for (int i = 0; i < populateIterations; i++) {
+        delete nodesModel;
+        nodesModel = new NodesModel(nullptr);
+        timer.start();
+        nodesModel->populateNodesFromJson(jsonArray);
+        populateSamples << timer.nsecsElapsed();
+    }
+    if (runPopulate) {
+        addResult("nodes.populate", rows, populateSamples);
+    }
+
+    if (runAutoPilot) {
+        QList<Node> nodes = nodesModel->getNodes();
+        QString ourId = QString::fromLatin1(benchmarkOurId);
+
+        // Each AutoPilot::go() iteration is a separate search, time them separately
+        QList<qint64> samples;
+        int iterations = qMin(m_iterations, autoPilotIterations);
+        for (int i = 0; i < iterations; i++) {
+            timer.start();
+            QString candidate = AutoPilot::candidateNode(nodes, ourId, i);
+            samples << timer.nsecsElapsed();
+            if (candidate.isEmpty() && !nodes.isEmpty()) {
+                qDebug() << "AutoPilot found no candidate among" << nodes.size() << "nodes";
+            }
+        }
+        addResult("autopilot.candidate", nodes.size(), samples);
+    }
+
+    delete nodesModel;
+}
+
+bool ModelBenchmark::shouldRun(const QString &name, int rows)
+{
+    if (!m_nsPerRow.contains(name)) {
+        return true;
+    }
+
+    double expectedTime = m_nsPerRow.value(name) * rows / 1000000.0;
+    if (expectedTime <= m_timeBudget) {
+        return true;
+    }
+
+    qDebug() << "Skipping" << name << "at" << rows << "rows, expected to take" << (qint64)expectedTime << "ms";
+
+    QJsonObject result = caseResult(name, rows);
+    result.insert("skipped", true);
+    result.insert("expectedMs", expectedTime);
+    m_results.append(result);
+    return false;
+}
+
+void ModelBenchmark::addResult(const QString &name, int rows, QList<qint64> samples)
+{
+    if (samples.isEmpty()) {
+        return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    qint64 total = 0;
+    foreach (qint64 sample, samples) {
+        total += sample;
+    }
+
+    double minMs = samples.first() / 1000000.0;
+    double medianMs = samples.at(samples.size() / 2) / 1000000.0;
+    double meanMs = total / 1000000.0 / samples.size();
+    double nsPerRow = rows > 0 ? (double)samples.first() / rows : 0;
+
+    QJsonObject result = caseResult(name, rows);
+    result.insert("iterations", samples.size());
+    result.insert("minMs", minMs);
+    result.insert("medianMs", medianMs);
+    result.insert("meanMs", meanMs);
+    result.insert("nsPerRow", nsPerRow);
+    m_results.append(result);
+
+    m_nsPerRow.insert(name, nsPerRow);
+
+    qDebug().nospace() << name << " rows: " << rows << " min: " << minMs << "ms median: " << medianMs
+                       << "ms ns/row: " << nsPerRow;
+}
+
+QJsonArray ModelBenchmark::parseArray(const QByteArray &json, const QString &key) const
+{
+    return QJsonDocument::fromJson(json).object().value(key).toArray();
+}
@@ -0,0 +1,61 @@
+#ifndef MODELBENCHMARK_H
+#define MODELBENCHMARK_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+
+// Times the models against synthetic datasets from MockLightningDaemon:
+// JSON parsing, populate*FromJson into an empty model and again into a
+// filled one (the diff every refresh runs), data() over every role and
+// the AutoPilot candidate search. Results are written as JSON so runs on
+// different builds and devices can be compared.
+class ModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    ModelBenchmark(QObject *parent = 0);
+
+    // Row counts to run every case at, 1k to 1M by default
+    QList<int> sizes() const;
+    void setSizes(const QList<int> &sizes);
+
+    // Upper bound on timed runs per case
+    int iterations() const;
+    void setIterations(int iterations);
+
+    // A case expected to take longer than this (ms) per run, extrapolated
+    // from the previous size, is skipped. The O(n^2) ones would otherwise
+    // run for hours at 1M rows
+    int timeBudget() const;
+    void setTimeBudget(int timeBudget);
+
+    QJsonObject run();
+    bool writeResults(const QJsonObject &results, const QString &filePath) const;
+
+private:
+    template <class Model>
+    void benchmarkListModel(const QString &name, int rows, const QByteArray &json,
+                            const QString &key, void (Model::*populate)(QJsonArray));
+    void benchmarkNodes(int rows, const QByteArray &json);
+
+    bool shouldRun(const QString &name, int rows);
+    // samples are in ns, one per iteration
+    void addResult(const QString &name, int rows, QList<qint64> samples);
+
+    QJsonArray parseArray(const QByteArray &json, const QString &key) const;
+
+    QList<int> m_sizes;
+    int m_iterations;
+    int m_timeBudget;
+
+    QJsonArray m_results;
+    // Fastest ns per row of each case at the last size it ran at
+    QHash<QString, double> m_nsPerRow;
+};
+
+#endif // MODELBENCHMARK_H
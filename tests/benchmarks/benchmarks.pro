@@ -0,0 +1,22 @@
+# Model benchmarks, kept out of the app. Run with
+#   ./presto-benchmarks                    QtTest output, -o results.json,json for JSON
+#   PRESTO_BENCHMARK_SIZES=1000,10000 ./presto-benchmarks
+#   PRESTO_BENCHMARK_JSON=results.json ./presto-benchmarks json
+# the last one writes ModelBenchmark's report, comparable with older runs
+TEMPLATE = app
+TARGET = presto-benchmarks
+
+QT += quick multimedia concurrent testlib
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../src/src.pri)
+
+HEADERS += \
+    ModelBenchmark.h
+
+SOURCES += \
+    ModelBenchmark.cpp \
+    tst_models.cpp
@@ -0,0 +1,311 @@
+#include <QAbstractItemModel>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtTest>
+
+#include "AutoPilot.h"
+#include "InvoicesModel.h"
+#include "MockLightningDaemon.h"
+#include "ModelBenchmark.h"
+#include "NodesModel.h"
+#include "PaymentsModel.h"
+#include "PeersModel.h"
+#include "WalletModel.h"
+
+// Not one of the generated nodes, so the candidate search has to hash it
+static const char benchmarkOurId[] = "02aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+
+// PRESTO_BENCHMARK_SIZES, e.g. "1000,10000", or 1k to 1M rows
+static QList<int> benchmarkSizes()
+{
+    QList<int> sizes;
+    QString sizesVariable = QString::fromLocal8Bit(qgetenv("PRESTO_BENCHMARK_SIZES"));
+    foreach (QString size, sizesVariable.split(',', QString::SkipEmptyParts)) {
+        if (size.toInt() > 0) {
+            sizes << size.toInt();
+        }
+    }
+
+    if (sizes.isEmpty()) {
+        sizes << 1000 << 10000 << 100000 << 1000000;
+    }
+    return sizes;
+}
+
+static QJsonArray parseArray(const QByteArray &json, const QString &key)
+{
+    return QJsonDocument::fromJson(json).object().value(key).toArray();
+}
+
+// The models against MockLightningDaemon's synthetic datasets, one data
+// row per step and size. Rows are ordered by size so every dataset is
+// generated once per test function.
+class ModelBenchmarks : public QObject
+{
+    Q_OBJECT
+
+public:
+    ModelBenchmarks();
+
+private slots:
+    void invoices_data();
+    void invoices();
+    void payments_data();
+    void payments();
+    void peers_data();
+    void peers();
+    void funds_data();
+    void funds();
+    void nodes_data();
+    void nodes();
+    void autoPilot_data();
+    void autoPilot();
+
+    // ModelBenchmark's JSON report when PRESTO_BENCHMARK_JSON names a file
+    void json();
+
+private:
+    enum Dataset {
+        NoDataset,
+        InvoicesDataset,
+        PaymentsDataset,
+        PeersDataset,
+        FundsDataset,
+        NodesDataset
+    };
+
+    QByteArray dataset(Dataset dataset, int rows);
+
+    void stepData(const QStringList &steps);
+    template <class Model>
+    void benchmarkListModel(Dataset dataset, const QString &key, void (Model::*populate)(QJsonArray));
+
+    Dataset m_dataset;
+    int m_datasetRows;
+    QByteArray m_datasetJson;
+};
+
+ModelBenchmarks::ModelBenchmarks()
+{
+    m_dataset = NoDataset;
+    m_datasetRows = 0;
+}
+
+QByteArray ModelBenchmarks::dataset(Dataset dataset, int rows)
+{
+    if (dataset == m_dataset && rows == m_datasetRows) {
+        return m_datasetJson;
+    }
+
+    // Drop the previous one first, at 1M rows it is a few hundred MB
+    m_datasetJson.clear();
+
+    MockLightningDaemon daemon;
+    switch (dataset) {
+    case InvoicesDataset:
+        daemon.setInvoiceCount(rows);
+        m_datasetJson = daemon.listInvoicesJson();
+        break;
+    case PaymentsDataset:
+        daemon.setPaymentCount(rows);
+        m_datasetJson = daemon.listPaymentsJson();
+        break;
+    case PeersDataset:
+        daemon.setPeerCount(rows);
+        m_datasetJson = daemon.listPeersJson();
+        break;
+    case FundsDataset:
+        daemon.setOutputCount(rows);
+        m_datasetJson = daemon.listFundsJson();
+        break;
+    case NodesDataset:
+        daemon.setNodeCount(rows);
+        m_datasetJson = daemon.listNodesJson();
+        break;
+    case NoDataset:
+        break;
+    }
+
+    m_dataset = dataset;
+    m_datasetRows = rows;
+    return m_datasetJson;
+}
+
+void ModelBenchmarks::stepData(const QStringList &steps)
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<QString>("step");
+
+    foreach (int rows, benchmarkSizes()) {
+        foreach (QString step, steps) {
+            QTest::newRow(qPrintable(step + "/" + QString::number(rows))) << rows << step;
+        }
+    }
+}
+
+template <class Model>
+void ModelBenchmarks::benchmarkListModel(Dataset datasetType, const QString &key,
+                                         void (Model::*populate)(QJsonArray))
+{
+    QFETCH(int, rows);
+    QFETCH(QString, step);
+
+    QByteArray json = dataset(datasetType, rows);
+
+    if (step == "parse") {
+        QBENCHMARK {
+            parseArray(json, key);
+        }
+        return;
+    }
+
+    QJsonArray jsonArray = parseArray(json, key);
+    QCOMPARE(jsonArray.size(), rows);
+
+    if (step == "populate") {
+        // Fresh model every time, populating a filled one is the refresh step.
+        // Includes tearing the model down again.
+        QBENCHMARK {
+            Model model;
+            (model.*populate)(jsonArray);
+        }
+        return;
+    }
+
+    Model model;
+    (model.*populate)(jsonArray);
+
+    if (step == "refresh") {
+        // The same list again, every row is matched by key and nothing changes
+        QBENCHMARK {
+            (model.*populate)(jsonArray);
+        }
+        return;
+    }
+
+    QAbstractItemModel *itemModel = &model;
+    QList<int> roles = itemModel->roleNames().keys();
+    int rowCount = itemModel->rowCount();
+    // Keeps the compiler from dropping the reads
+    int validCount = 0;
+
+    QBENCHMARK {
+        for (int row = 0; row < rowCount; row++) {
+            QModelIndex index = itemModel->index(row, 0);
+            foreach (int role, roles) {
+                if (itemModel->data(index, role).isValid()) {
+                    validCount++;
+                }
+            }
+        }
+    }
+
+    QVERIFY(validCount > 0 || rowCount == 0);
+}
+
+void ModelBenchmarks::invoices_data()
+{
+    stepData(QStringList() << "parse" << "populate" << "refresh" << "data");
+}
+
+void ModelBenchmarks::invoices()
+{
+    benchmarkListModel<InvoicesModel>(InvoicesDataset, "invoices", &InvoicesModel::populateInvoicesFromJson);
+}
+
+void ModelBenchmarks::payments_data()
+{
+    stepData(QStringList() << "parse" << "populate" << "refresh" << "data");
+}
+
+void ModelBenchmarks::payments()
+{
+    benchmarkListModel<PaymentsModel>(PaymentsDataset, "payments", &PaymentsModel::populatePaymentsFromJson);
+}
+
+void ModelBenchmarks::peers_data()
+{
+    stepData(QStringList() << "parse" << "populate" << "refresh" << "data");
+}
+
+void ModelBenchmarks::peers()
+{
+    benchmarkListModel<PeersModel>(PeersDataset, "peers", &PeersModel::populatePeersFromJson);
+}
+
+void ModelBenchmarks::funds_data()
+{
+    stepData(QStringList() << "parse" << "populate" << "refresh" << "data");
+}
+
+void ModelBenchmarks::funds()
+{
+    benchmarkListModel<WalletModel>(FundsDataset, "outputs", &WalletModel::populateFundsFromJson);
+}
+
+void ModelBenchmarks::nodes_data()
+{
+    stepData(QStringList() << "parse" << "populate");
+}
+
+void ModelBenchmarks::nodes()
+{
+    QFETCH(int, rows);
+    QFETCH(QString, step);
+
+    QByteArray json = dataset(NodesDataset, rows);
+
+    if (step == "parse") {
+        QBENCHMARK {
+            parseArray(json, "nodes");
+        }
+        return;
+    }
+
+    QJsonArray jsonArray = parseArray(json, "nodes");
+    QCOMPARE(jsonArray.size(), rows);
+
+    QBENCHMARK {
+        NodesModel nodesModel(nullptr);
+        nodesModel.populateNodesFromJson(jsonArray);
+    }
+}
+
+void ModelBenchmarks::autoPilot_data()
+{
+    stepData(QStringList() << "candidate");
+}
+
+void ModelBenchmarks::autoPilot()
+{
+    QFETCH(int, rows);
+
+    NodesModel nodesModel(nullptr);
+    nodesModel.populateNodesFromJson(parseArray(dataset(NodesDataset, rows), "nodes"));
+    QList<Node> nodes = nodesModel.getNodes();
+    QString ourId = QString::fromLatin1(benchmarkOurId);
+
+    QString candidate;
+    QBENCHMARK {
+        candidate = AutoPilot::candidateNode(nodes, ourId, 0);
+    }
+
+    QVERIFY(!candidate.isEmpty() || nodes.isEmpty());
+}
+
+void ModelBenchmarks::json()
+{
+    if (!qEnvironmentVariableIsSet("PRESTO_BENCHMARK_JSON")) {
+        QSKIP("PRESTO_BENCHMARK_JSON not set");
+    }
+
+    ModelBenchmark benchmark;
+    benchmark.setSizes(benchmarkSizes());
+    QString filePath = QString::fromLocal8Bit(qgetenv("PRESTO_BENCHMARK_JSON"));
+    QVERIFY(benchmark.writeResults(benchmark.run(), filePath));
+}
+
+QTEST_MAIN(ModelBenchmarks)
+
+#include "tst_models.moc"